@@ -0,0 +1,79 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#ifndef PYLON_CAMERA_CACHE_FILES_H
+#define PYLON_CAMERA_CACHE_FILES_H
+
+#include <stdint.h>
+#include <string>
+
+namespace pylon_camera
+{
+
+/**
+ * Helpers for the files the node keeps across restarts, i.e. the feature
+ * snapshots and the rectification tables. The files are keyed by hashes of
+ * the settings they were created with.
+ */
+namespace cache_files
+{
+
+// parameters of the 64 bit FNV-1a hash
+const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+const uint64_t FNV_PRIME = 1099511628211ULL;
+
+/**
+ * Default directory of the cached files
+ * @return '$ROS_HOME/pylon_camera', '$HOME/.ros/pylon_camera' if ROS_HOME
+ *         isn't set or an empty string if neither is set
+ */
+std::string defaultCacheDir();
+
+/**
+ * Creates the missing directories of the path one by one
+ * @param path the directory to create
+ * @param purpose what the directory is for, only used for the warning
+ * @return false if a directory couldn't be created
+ */
+bool createDirectories(const std::string& path, const std::string& purpose);
+
+/**
+ * 64 bit FNV-1a of the key, which is stable across builds unlike std::hash
+ */
+uint64_t hash(const std::string& key);
+
+/**
+ * @return the hash as 16 hex digits, to be used in file names
+ */
+std::string hashString(const uint64_t& hash);
+
+}  // namespace cache_files
+}  // namespace pylon_camera
+
+#endif  // PYLON_CAMERA_CACHE_FILES_H
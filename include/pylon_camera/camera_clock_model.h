@@ -0,0 +1,151 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#ifndef PYLON_CAMERA_CAMERA_CLOCK_MODEL_H
+#define PYLON_CAMERA_CAMERA_CLOCK_MODEL_H
+
+#include <cstdint>
+#include <deque>
+#include <ros/ros.h>
+
+namespace pylon_camera
+{
+
+/**
+ * Online model of the camera clock, which maps the tick timestamps of the
+ * camera to ROS time: host = offset + (1 + drift) * camera.
+ * The model is fed with pairs of latched camera ticks and the host time
+ * before and after latching. Offset and drift are estimated by a least
+ * squares fit over a sliding window of these pairs. Pairs with a long
+ * round trip are rejected, because their host time is uncertain. The round
+ * trips of rejected pairs still slide through the window the shortest round
+ * trip is taken from, hence a single lucky latch can't lock the model out.
+ * The class does not access the camera, hence it can be tested with
+ * synthetic tick streams. It is not thread-safe.
+ */
+class CameraClockModel
+{
+public:
+    /**
+     * @param window_size the max number of latch samples used for the fit
+     */
+    explicit CameraClockModel(const std::size_t& window_size = 32);
+
+    virtual ~CameraClockModel();
+
+    /**
+     * Drops all samples, e.g. after reopening the camera which resets the
+     * camera clock.
+     * @param tick_frequency the frequency of the camera clock in Hz
+     */
+    void reset(const double& tick_frequency);
+
+    /**
+     * Adds a latch sample to the model.
+     * @param ticks the latched camera ticks
+     * @param host_before the host time right before latching
+     * @param host_after the host time right after latching
+     * @return false if the sample has been rejected.
+     */
+    bool addSample(const uint64_t& ticks,
+                   const ros::Time& host_before,
+                   const ros::Time& host_after);
+
+    /**
+     * Returns true if the model contains at least one sample. Before the
+     * second sample the drift is assumed to be zero.
+     */
+    bool isValid() const;
+
+    /**
+     * Maps camera ticks to ROS time
+     * @param ticks the camera ticks
+     * @return the corresponding ROS time, zero if the model is not valid.
+     */
+    ros::Time toRosTime(const uint64_t& ticks) const;
+
+    /**
+     * Getter for the estimated drift of the camera clock relative to the
+     * host clock (e.g. 1e-5 = 10ppm)
+     */
+    const double& drift() const;
+
+    /**
+     * Getter for the frequency of the camera clock
+     */
+    const double& tickFrequency() const;
+
+    /**
+     * Number of samples currently used for the fit
+     */
+    std::size_t numSamples() const;
+
+protected:
+    struct Sample
+    {
+        // camera time in seconds relative to the reference ticks
+        double camera_time;
+        // host time in seconds relative to the reference host time
+        double host_time;
+        // uncertainty of the host time in seconds
+        double round_trip;
+    };
+
+    /**
+     * Camera time in seconds relative to the reference ticks
+     */
+    double cameraTime(const uint64_t& ticks) const;
+
+    /**
+     * Least squares fit of offset_ and drift_ over all samples
+     */
+    void fit();
+
+    std::size_t window_size_;
+    double tick_frequency_;
+
+    // reference points all samples are relative to, this keeps the values
+    // small for the fit
+    uint64_t ref_ticks_;
+    ros::Time ref_host_time_;
+
+    std::deque<Sample> samples_;
+
+    // the round trips of the last window_size_ samples, including the
+    // rejected ones
+    std::deque<double> round_trips_;
+
+    // host_time = offset_ + (1 + drift_) * camera_time
+    double offset_;
+    double drift_;
+};
+
+}  // namespace pylon_camera
+
+#endif  // PYLON_CAMERA_CAMERA_CLOCK_MODEL_H
@@ -0,0 +1,129 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#ifndef PYLON_CAMERA_CAMERA_CONFIGURATION_H
+#define PYLON_CAMERA_CAMERA_CONFIGURATION_H
+
+#include <cstddef>
+#include <string>
+
+namespace pylon_camera
+{
+
+/**
+ * A batch of settings that is applied to the camera in one transaction by
+ * PylonCamera::reconfigure(). Only the settings whose flag is set are
+ * changed, the others keep their current values.
+ */
+struct CameraConfiguration
+{
+    CameraConfiguration()
+        : has_binning_(false)
+        , binning_x_(1)
+        , binning_y_(1)
+        , has_decimation_(false)
+        , decimation_x_(1)
+        , decimation_y_(1)
+        , has_roi_(false)
+        , roi_offset_x_(0)
+        , roi_offset_y_(0)
+        , roi_width_(0)
+        , roi_height_(0)
+        , roi_width_max_(0)
+        , roi_height_max_(0)
+        , has_image_encoding_(false)
+        , image_encoding_("")
+        , has_exposure_(false)
+        , exposure_(0.0)
+        , has_gain_(false)
+        , gain_(0.0)
+    {}
+
+    /**
+     * The settings below need a stopped stream, because they change the
+     * payload size. They are applied with a single stop and restart of
+     * grabbing.
+     */
+
+    bool has_binning_;
+    size_t binning_x_;
+    size_t binning_y_;
+
+    /**
+     * Decimation skips rows and columns of the sensor, which raises the
+     * frame rate more than binning, but doesn't improve the SNR
+     */
+    bool has_decimation_;
+    size_t decimation_x_;
+    size_t decimation_y_;
+
+    /**
+     * Region of interest in pixels of the binned image. A width or height
+     * of zero selects the maximum size. The values are aligned to the
+     * increments of the camera and the offsets limited to fit the size.
+     */
+    bool has_roi_;
+    size_t roi_offset_x_;
+    size_t roi_offset_y_;
+    size_t roi_width_;
+    size_t roi_height_;
+
+    /**
+     * Maximum size of the region of interest at the current binning. Only
+     * reported by PylonCamera::currentROI(), ignored as target.
+     */
+    size_t roi_width_max_;
+    size_t roi_height_max_;
+
+    /**
+     * ROS encoding of the pixels, e.g. 'mono8' or 'bayer_rggb8'
+     */
+    bool has_image_encoding_;
+    std::string image_encoding_;
+
+    /**
+     * The remaining settings are applied while the camera keeps grabbing
+     */
+
+    /**
+     * Exposure time in microseconds
+     */
+    bool has_exposure_;
+    float exposure_;
+
+    /**
+     * Gain in percent [0.0 - 1.0]
+     */
+    bool has_gain_;
+    float gain_;
+};
+
+}  // namespace pylon_camera
+
+#endif  // PYLON_CAMERA_CAMERA_CONFIGURATION_H
@@ -0,0 +1,109 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#ifndef PYLON_CAMERA_CAMERA_INFO_CACHE_H
+#define PYLON_CAMERA_CAMERA_INFO_CACHE_H
+
+#include <boost/thread/mutex.hpp>
+#include <ros/time.h>
+#include <sensor_msgs/CameraInfo.h>
+#include <stdint.h>
+#include <vector>
+
+namespace pylon_camera
+{
+
+/**
+ * Versioned copy of the CameraInfo of the camera_info_manager. The cached
+ * message is immutable and only replaced, with an increased version, if the
+ * info of the manager actually changed. The published messages are
+ * recycled once no subscriber holds them anymore, so that publishing a frame
+ * neither copies the calibration nor locks the manager.
+ */
+class CameraInfoCache
+{
+public:
+    CameraInfoCache();
+
+    /**
+     * Replaces the cached info if the given one differs from it.
+     * @param cam_info the current info of the camera_info_manager
+     * @return true if the version changed
+     */
+    bool update(const sensor_msgs::CameraInfo& cam_info);
+
+    /**
+     * The cached info, which is never modified. A new version is a new
+     * message, hence comparing the pointers detects a change.
+     * @return the cached info, nullptr before the first update()
+     */
+    sensor_msgs::CameraInfoConstPtr info() const;
+
+    /**
+     * @return the version of the cached info, 0 before the first update()
+     */
+    uint64_t version() const;
+
+    /**
+     * True if the cached info contains an intrinsic calibration
+     */
+    bool isCalibrated() const;
+
+    /**
+     * Returns a message with the content of the cached info for publishing.
+     * A message that was returned before is reused if it's no longer
+     * referenced by anyone else, so only its stamp (and its content after a
+     * version change) is written.
+     * @param stamp the stamp of the header
+     * @return the message, nullptr before the first update()
+     */
+    sensor_msgs::CameraInfoPtr stamped(const ros::Time& stamp);
+
+    /**
+     * Max number of published messages kept for recycling
+     */
+    static const std::size_t MAX_RECYCLED = 8;
+
+protected:
+    mutable boost::mutex mutex_;
+
+    sensor_msgs::CameraInfoConstPtr info_;
+
+    uint64_t version_;
+
+    /**
+     * Messages returned by stamped() and the version of their content
+     */
+    std::vector<sensor_msgs::CameraInfoPtr> published_;
+    std::vector<uint64_t> published_versions_;
+};
+
+}  // namespace pylon_camera
+
+#endif  // PYLON_CAMERA_CAMERA_INFO_CACHE_H
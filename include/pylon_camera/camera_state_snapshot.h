@@ -0,0 +1,118 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#ifndef PYLON_CAMERA_CAMERA_STATE_SNAPSHOT_H
+#define PYLON_CAMERA_CAMERA_STATE_SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <boost/shared_ptr.hpp>
+
+namespace pylon_camera
+{
+
+/**
+ * Immutable copy of the camera state the grab path depends on. It is rebuilt
+ * whenever a setter changes the image format, size or the exposure and gain
+ * limits, and read by the hot paths without any GenApi access or lock.
+ * A snapshot is never modified after it was published, a change of state
+ * publishes a new one.
+ */
+struct CameraStateSnapshot
+{
+    CameraStateSnapshot()
+        : generation_(0)
+        , gen_api_encoding_("")
+        , ros_encoding_("")
+        , is_mono_(false)
+        , is_yuv_(false)
+        , bit_depth_(0)
+        , packed_bits_(0)
+        , pixel_depth_(0)
+        , rows_(0)
+        , cols_(0)
+        , size_byte_(0)
+        , exposure_min_(0.0)
+        , exposure_max_(0.0)
+        , gain_min_(0.0)
+        , gain_max_(0.0)
+    {}
+
+    /**
+     * Counts the published snapshots, 0 if the camera state wasn't read yet
+     */
+    uint64_t generation_;
+
+    /**
+     * The pixel format of the camera, e.g. 'Mono12p', and its ROS encoding
+     * of the published image, e.g. 'mono16'
+     */
+    std::string gen_api_encoding_;
+    std::string ros_encoding_;
+
+    /**
+     * Properties of the ROS encoding, so that the per frame code doesn't
+     * need to parse the encoding string. bit_depth_ is per channel.
+     */
+    bool is_mono_;
+    bool is_yuv_;
+    int bit_depth_;
+
+    /**
+     * Bits per pixel of a packed pixel format, 0 for all other formats
+     */
+    int packed_bits_;
+
+    /**
+     * Bytes per pixel of the published image including all channels
+     */
+    int pixel_depth_;
+
+    /**
+     * Size of the published image
+     */
+    size_t rows_;
+    size_t cols_;
+    size_t size_byte_;
+
+    /**
+     * Limits of the exposure time in microseconds and of the raw gain
+     */
+    double exposure_min_;
+    double exposure_max_;
+    double gain_min_;
+    double gain_max_;
+};
+
+typedef boost::shared_ptr<const CameraStateSnapshot> CameraStateSnapshotConstPtr;
+
+}  // namespace pylon_camera
+
+#endif  // PYLON_CAMERA_CAMERA_STATE_SNAPSHOT_H
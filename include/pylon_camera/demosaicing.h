@@ -0,0 +1,72 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#ifndef PYLON_CAMERA_DEMOSAICING_H
+#define PYLON_CAMERA_DEMOSAICING_H
+
+#include <string>
+#include <sensor_msgs/Image.h>
+#include <pylon_camera/pylon_camera_parameter.h>
+
+namespace pylon_camera
+{
+
+/**
+ * Host-side demosaicing, which lets the camera transmit a third of the
+ * bytes of a color image. The conversions use the vectorized Bayer kernels
+ * of OpenCV, which process bands of rows in parallel.
+ */
+namespace demosaicing
+{
+    /**
+     * Demosaics a bayer_*8 or bayer_*16 image.
+     * @param bayer the raw image
+     * @param algorithm bilinear or edge-aware interpolation
+     * @param color_encoding 'rgb8' or 'bgr8', the depth follows the raw image
+     * @param color the color image, its header is copied from the raw image
+     * @return false if the raw image is no Bayer image
+     */
+    bool toColor(const sensor_msgs::Image& bayer,
+                 const DEMOSAICING_ALGORITHM& algorithm,
+                 const std::string& color_encoding,
+                 sensor_msgs::Image& color);
+
+    /**
+     * Converts a Bayer image or a color image created by toColor() to a mono
+     * image. Converting the color image is cheaper if it exists anyway.
+     * @param img the bayer_*, rgb* or bgr* image
+     * @param mono the mono8 or mono16 image, its header is copied
+     * @return false if the image is neither a Bayer nor a color image
+     */
+    bool toMono(const sensor_msgs::Image& img, sensor_msgs::Image& mono);
+
+}  // namespace demosaicing
+}  // namespace pylon_camera
+
+#endif  // PYLON_CAMERA_DEMOSAICING_H
@@ -0,0 +1,121 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#ifndef PYLON_CAMERA_FRAME_METADATA_H
+#define PYLON_CAMERA_FRAME_METADATA_H
+
+#include <cstdint>
+#include <ros/ros.h>
+
+namespace pylon_camera
+{
+
+/**
+ * Information about a grabbed frame, which is not part of the image data
+ */
+struct FrameMetadata
+{
+    FrameMetadata()
+        : camera_ticks_(0)
+        , has_camera_stamp_(false)
+        , camera_stamp_()
+        , host_stamp_()
+        , has_exposure_time_(false)
+        , exposure_time_(0.0)
+        , has_gain_(false)
+        , gain_(0.0)
+        , has_frame_counter_(false)
+        , frame_counter_(0)
+        , has_crc_(false)
+        , crc_ok_(false)
+    {}
+
+    /**
+     * Timestamp of the exposure start in ticks of the camera clock.
+     * Zero if the camera does not provide it.
+     */
+    uint64_t camera_ticks_;
+
+    /**
+     * Flag which indicates if camera_stamp_ is valid. This requires the
+     * camera ticks and a synchronized clock model.
+     */
+    bool has_camera_stamp_;
+
+    /**
+     * The exposure start mapped to ROS time by the camera clock model
+     */
+    ros::Time camera_stamp_;
+
+    /**
+     * ROS time at which the frame has been retrieved from the grab engine
+     */
+    ros::Time host_stamp_;
+
+    /**
+     * The remaining values are parsed from the chunk data the camera appends
+     * to the image, hence they belong exactly to this frame. Each one is
+     * only valid if its flag is set, which requires chunk mode and a camera
+     * supporting the chunk.
+     */
+
+    bool has_exposure_time_;
+
+    /**
+     * Exposure time of the frame in microseconds
+     */
+    float exposure_time_;
+
+    bool has_gain_;
+
+    /**
+     * Gain of the frame in percent, in the same range as
+     * PylonCamera::currentGain()
+     */
+    float gain_;
+
+    bool has_frame_counter_;
+
+    /**
+     * Number of frames the camera acquired since grabbing started. A gap
+     * between subsequent frames means frames have been lost.
+     */
+    uint64_t frame_counter_;
+
+    /**
+     * Flag which indicates that the payload has been verified against its
+     * CRC checksum, with the result in crc_ok_
+     */
+    bool has_crc_;
+    bool crc_ok_;
+};
+
+}  // namespace pylon_camera
+
+#endif  // PYLON_CAMERA_FRAME_METADATA_H
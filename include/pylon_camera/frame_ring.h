@@ -0,0 +1,393 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#ifndef PYLON_CAMERA_FRAME_RING_H
+#define PYLON_CAMERA_FRAME_RING_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <boost/thread.hpp>
+
+#include <pylon_camera/pylon_camera_parameter.h>
+
+namespace pylon_camera
+{
+
+/**
+ * Bounded ring buffer which hands over the grabbed frames from the
+ * acquisition thread (single producer) to the publishing stage (single
+ * consumer). Pushing and popping is lock-free, the mutex and the condition
+ * variable are only used to put a waiting thread to sleep.
+ * To drop the oldest frame in case of an overflow, the producer has to pop
+ * as well. Hence every cell carries a sequence number and the read position
+ * is claimed with a CAS, so that a cell is never overwritten while the
+ * consumer still moves the frame out of it (cf. D. Vyukov's bounded queue).
+ */
+template <typename T>
+class FrameRing
+{
+public:
+    FrameRing(const std::size_t& capacity, const OVERFLOW_POLICY& policy);
+
+    virtual ~FrameRing();
+
+    /**
+     * Pushes a frame into the ring. Must only be called by the producer.
+     * If the ring is full, the overflow policy decides whether the oldest
+     * frame or the new frame gets dropped or if the call blocks till the
+     * consumer made room for it.
+     * @param frame the frame to push
+     * @return false if the frame has been dropped or the ring has been closed
+     *         while waiting.
+     */
+    bool push(const T& frame);
+
+    /**
+     * Pops the oldest frame from the ring without waiting.
+     * @param frame the popped frame
+     * @return false if the ring is empty.
+     */
+    bool tryPop(T& frame);
+
+    /**
+     * Pops the oldest frame from the ring. Must only be called by the consumer.
+     * @param frame the popped frame
+     * @param timeout max. time to wait for a frame if the ring is empty
+     * @return false if no frame became available within the timeout or the
+     *         ring has been closed.
+     */
+    bool pop(T& frame, const boost::posix_time::time_duration& timeout);
+
+    /**
+     * Wakes up all waiting threads and prevents them from waiting again.
+     * Frames still in the ring can be popped afterwards.
+     */
+    void close();
+
+    /**
+     * Getter for the max. number of frames in the ring
+     */
+    const std::size_t& capacity() const;
+
+    /**
+     * Getter for the policy in case of an overflow
+     */
+    const OVERFLOW_POLICY& overflowPolicy() const;
+
+    /**
+     * Number of frames currently in the ring. Only a snapshot, because both
+     * threads keep on working.
+     */
+    std::size_t size() const;
+
+    /**
+     * Total number of frames passed to push()
+     */
+    uint64_t numPushed() const;
+
+    /**
+     * Total number of frames dropped because the ring was full
+     */
+    uint64_t numDropped() const;
+
+protected:
+    struct Cell
+    {
+        std::atomic<std::size_t> sequence;
+        T frame;
+    };
+
+    /**
+     * Writes the frame to the next free cell
+     * @return false if the ring is full
+     */
+    bool tryPush(const T& frame);
+
+    bool isFull() const;
+
+    bool isEmpty() const;
+
+    /**
+     * Waits till the predicate holds, the timeout passed or the ring is closed
+     */
+    template <typename Predicate>
+    bool waitFor(Predicate pred, const boost::posix_time::time_duration& timeout);
+
+    /**
+     * Wakes up the other thread, but only if it is actually waiting
+     */
+    void notify();
+
+    const std::size_t capacity_;
+    // A cell released by the consumer carries the position of its next
+    // push, which equals the position of the push after a full ring of one
+    // cell. Hence there are at least two cells, and the producer compares
+    // its position with the read position to respect the capacity.
+    const std::size_t num_cells_;
+    const OVERFLOW_POLICY policy_;
+    Cell* cells_;
+
+    std::atomic<std::size_t> enqueue_pos_;
+    std::atomic<std::size_t> dequeue_pos_;
+
+    std::atomic<uint64_t> num_pushed_;
+    std::atomic<uint64_t> num_dropped_;
+
+    std::atomic<bool> is_closed_;
+    std::atomic<int> num_waiting_;
+    boost::mutex wait_mutex_;
+    boost::condition_variable wait_cond_;
+};
+
+template <typename T>
+FrameRing<T>::FrameRing(const std::size_t& capacity,
+                        const OVERFLOW_POLICY& policy)
+    : capacity_(std::max<std::size_t>(capacity, 1)),
+      num_cells_(std::max<std::size_t>(capacity_, 2)),
+      policy_(policy),
+      cells_(new Cell[num_cells_]),
+      enqueue_pos_(0),
+      dequeue_pos_(0),
+      num_pushed_(0),
+      num_dropped_(0),
+      is_closed_(false),
+      num_waiting_(0),
+      wait_mutex_(),
+      wait_cond_()
+{
+    for ( std::size_t i = 0; i < num_cells_; ++i )
+    {
+        cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+template <typename T>
+FrameRing<T>::~FrameRing()
+{
+    delete[] cells_;
+    cells_ = nullptr;
+}
+
+template <typename T>
+bool FrameRing<T>::push(const T& frame)
+{
+    ++num_pushed_;
+    while ( !tryPush(frame) )
+    {
+        if ( policy_ == OP_DROP_NEWEST )
+        {
+            ++num_dropped_;
+            return false;
+        }
+        else if ( policy_ == OP_DROP_OLDEST )
+        {
+            T oldest;
+            if ( tryPop(oldest) )
+            {
+                ++num_dropped_;
+            }
+            else
+            {
+                // the consumer is just moving the oldest frame out of its
+                // cell, which will be free in a moment
+                boost::this_thread::yield();
+            }
+        }
+        else if ( !waitFor([this]() { return !isFull(); },
+                           boost::posix_time::milliseconds(100)) && is_closed_ )
+        {
+            ++num_dropped_;
+            return false;
+        }
+    }
+    notify();
+    return true;
+}
+
+template <typename T>
+bool FrameRing<T>::tryPush(const T& frame)
+{
+    if ( isFull() )
+    {
+        return false;
+    }
+    const std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    Cell& cell = cells_[pos % num_cells_];
+    cell.frame = frame;
+    cell.sequence.store(pos + 1, std::memory_order_release);
+    enqueue_pos_.store(pos + 1, std::memory_order_relaxed);
+    return true;
+}
+
+template <typename T>
+bool FrameRing<T>::tryPop(T& frame)
+{
+    std::size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    Cell* cell = nullptr;
+    while ( true )
+    {
+        cell = &cells_[pos % num_cells_];
+        const std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+        const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq)
+                                  - static_cast<std::ptrdiff_t>(pos + 1);
+        if ( diff == 0 )
+        {
+            // claim the cell, on failure pos is updated to the current value
+            if ( dequeue_pos_.compare_exchange_weak(pos,
+                                                    pos + 1,
+                                                    std::memory_order_relaxed) )
+            {
+                break;
+            }
+        }
+        else if ( diff < 0 )
+        {
+            return false;
+        }
+        else
+        {
+            pos = dequeue_pos_.load(std::memory_order_relaxed);
+        }
+    }
+    std::swap(frame, cell->frame);
+    // release the frame now and not with the next overwrite of the cell
+    cell->frame = T();
+    cell->sequence.store(pos + num_cells_, std::memory_order_release);
+    notify();
+    return true;
+}
+
+template <typename T>
+bool FrameRing<T>::pop(T& frame, const boost::posix_time::time_duration& timeout)
+{
+    if ( tryPop(frame) )
+    {
+        return true;
+    }
+    if ( !waitFor([this]() { return !isEmpty(); }, timeout) )
+    {
+        return false;
+    }
+    return tryPop(frame);
+}
+
+template <typename T>
+void FrameRing<T>::close()
+{
+    {
+        boost::lock_guard<boost::mutex> lock(wait_mutex_);
+        is_closed_ = true;
+    }
+    wait_cond_.notify_all();
+}
+
+template <typename T>
+const std::size_t& FrameRing<T>::capacity() const
+{
+    return capacity_;
+}
+
+template <typename T>
+const OVERFLOW_POLICY& FrameRing<T>::overflowPolicy() const
+{
+    return policy_;
+}
+
+template <typename T>
+std::size_t FrameRing<T>::size() const
+{
+    const std::size_t dequeue_pos = dequeue_pos_.load(std::memory_order_relaxed);
+    const std::size_t enqueue_pos = enqueue_pos_.load(std::memory_order_relaxed);
+    return enqueue_pos > dequeue_pos ? enqueue_pos - dequeue_pos : 0;
+}
+
+template <typename T>
+uint64_t FrameRing<T>::numPushed() const
+{
+    return num_pushed_;
+}
+
+template <typename T>
+uint64_t FrameRing<T>::numDropped() const
+{
+    return num_dropped_;
+}
+
+template <typename T>
+bool FrameRing<T>::isFull() const
+{
+    const std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    return pos - dequeue_pos_.load(std::memory_order_relaxed) >= capacity_ ||
+           cells_[pos % num_cells_].sequence.load(std::memory_order_acquire) != pos;
+}
+
+template <typename T>
+bool FrameRing<T>::isEmpty() const
+{
+    const std::size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    return cells_[pos % num_cells_].sequence.load(std::memory_order_acquire) != pos + 1;
+}
+
+template <typename T>
+template <typename Predicate>
+bool FrameRing<T>::waitFor(Predicate pred,
+                           const boost::posix_time::time_duration& timeout)
+{
+    boost::unique_lock<boost::mutex> lock(wait_mutex_);
+    // announce the waiting before checking the predicate, notify() checks
+    // the counter after changing the state: one of both sees the other
+    ++num_waiting_;
+    const bool result = wait_cond_.timed_wait(lock, timeout, [&]()
+            {
+                return is_closed_ || pred();
+            });
+    --num_waiting_;
+    return result && pred();
+}
+
+template <typename T>
+void FrameRing<T>::notify()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if ( num_waiting_ > 0 )
+    {
+        // taking the mutex prevents the wakeup from being lost between the
+        // waiting thread checking the predicate and going to sleep
+        {
+            boost::lock_guard<boost::mutex> lock(wait_mutex_);
+        }
+        wait_cond_.notify_all();
+    }
+}
+
+}  // namespace pylon_camera
+
+#endif  // PYLON_CAMERA_FRAME_RING_H
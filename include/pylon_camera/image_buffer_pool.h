@@ -0,0 +1,113 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#ifndef PYLON_CAMERA_IMAGE_BUFFER_POOL_H
+#define PYLON_CAMERA_IMAGE_BUFFER_POOL_H
+
+#include <boost/thread.hpp>
+#include <sensor_msgs/Image.h>
+#include <stdint.h>
+#include <map>
+#include <vector>
+
+namespace pylon_camera
+{
+
+/**
+ * Pool of sensor_msgs::Image messages whose data vectors serve as grab
+ * buffers. The stream grabber writes the frames directly into the message
+ * data, hence the grab result can be published without copying it.
+ * Buffers that are handed back to the pool are recycled for later
+ * allocations.
+ */
+class ImageBufferPool
+{
+public:
+    ImageBufferPool();
+
+    virtual ~ImageBufferPool();
+
+    /**
+     * Hands out a buffer of the given size, which is backed by the data
+     * vector of an image message of this pool.
+     * @param buffer_size the desired buffer size in bytes
+     * @param buffer_context the id to identify the buffer later on
+     * @return pointer to the first byte of the buffer
+     */
+    uint8_t* allocate(const std::size_t& buffer_size, intptr_t& buffer_context);
+
+    /**
+     * Hands a buffer back to the pool, so that it can be recycled.
+     * @param buffer_context the id of the buffer
+     */
+    void release(const intptr_t& buffer_context);
+
+    /**
+     * Returns the image message which owns the buffer with the given id.
+     * Caution: The size of the data vector must not be increased, as long as
+     * the buffer is in use by the stream grabber!
+     * @param buffer_context the id of the buffer
+     * @return the image message or a nullptr if the buffer is unknown
+     */
+    sensor_msgs::ImagePtr image(const intptr_t& buffer_context) const;
+
+    /**
+     * Returns the number of buffers, that are currently in use
+     * @return the number of used buffers
+     */
+    std::size_t numBuffersInUse() const;
+
+    /**
+     * Returns the number of buffers that are ready to be recycled
+     * @return the number of free buffers
+     */
+    std::size_t numFreeBuffers() const;
+
+protected:
+    mutable boost::mutex mutex_;
+
+    /**
+     * Buffers currently handed out, accessible by their buffer context
+     */
+    std::map<intptr_t, sensor_msgs::ImagePtr> buffers_in_use_;
+
+    /**
+     * Buffers handed back to the pool, ready to be recycled
+     */
+    std::vector<sensor_msgs::ImagePtr> free_buffers_;
+
+    /**
+     * The buffer context of the next buffer that will be handed out
+     */
+    intptr_t next_buffer_context_;
+};
+
+}  // namespace pylon_camera
+
+#endif  // PYLON_CAMERA_IMAGE_BUFFER_POOL_H
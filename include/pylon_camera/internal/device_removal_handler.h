@@ -0,0 +1,67 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#ifndef PYLON_CAMERA_INTERNAL_DEVICE_REMOVAL_HANDLER_H
+#define PYLON_CAMERA_INTERNAL_DEVICE_REMOVAL_HANDLER_H
+
+#include <pylon/PylonIncludes.h>
+#include <boost/function.hpp>
+
+namespace pylon_camera
+{
+
+/**
+ * Configuration event handler that forwards the removal of the camera device
+ * to the given function. pylon calls it from its device monitoring thread as
+ * soon as the removal has been detected, which requires an open camera.
+ */
+class DeviceRemovalHandler : public Pylon::CConfigurationEventHandler
+{
+public:
+    typedef boost::function<void ()> RemovalCallback;
+
+    explicit DeviceRemovalHandler(const RemovalCallback& callback)
+        : callback_(callback)
+    {}
+
+    virtual ~DeviceRemovalHandler()
+    {}
+
+    virtual void OnCameraDeviceRemoved(Pylon::CInstantCamera& camera)
+    {
+        callback_();
+    }
+
+protected:
+    RemovalCallback callback_;
+};
+
+}  // namespace pylon_camera
+
+#endif  // PYLON_CAMERA_INTERNAL_DEVICE_REMOVAL_HANDLER_H
@@ -0,0 +1,115 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#ifndef PYLON_CAMERA_INTERNAL_IMAGE_BUFFER_FACTORY_H
+#define PYLON_CAMERA_INTERNAL_IMAGE_BUFFER_FACTORY_H
+
+#include <pylon/PylonIncludes.h>
+#include <boost/shared_ptr.hpp>
+#include <sensor_msgs/Image.h>
+
+#include <pylon_camera/image_buffer_pool.h>
+
+namespace pylon_camera
+{
+
+/**
+ * Buffer factory for the pylon stream grabber, which provides the buffers of
+ * an ImageBufferPool. Hence the grabbed frames end up directly in the data
+ * vector of sensor_msgs::Image messages.
+ */
+class ImageBufferFactory : public Pylon::IBufferFactory
+{
+public:
+    explicit ImageBufferFactory(const boost::shared_ptr<ImageBufferPool>& pool)
+        : pool_(pool)
+    {}
+
+    virtual ~ImageBufferFactory()
+    {}
+
+    virtual void AllocateBuffer(size_t buffer_size,
+                                void** p_created_buffer,
+                                intptr_t& buffer_context)
+    {
+        *p_created_buffer = pool_->allocate(buffer_size, buffer_context);
+    }
+
+    virtual void FreeBuffer(void* p_created_buffer, intptr_t buffer_context)
+    {
+        pool_->release(buffer_context);
+    }
+
+    virtual void DestroyBufferFactory()
+    {
+        // the factory is registered with Cleanup_None, its lifetime is
+        // managed by the shared pointers of the camera and the messages
+    }
+
+    /**
+     * Getter for the pool providing the buffers
+     */
+    ImageBufferPool& pool()
+    {
+        return *pool_;
+    }
+
+protected:
+    boost::shared_ptr<ImageBufferPool> pool_;
+};
+
+/**
+ * Deleter for image messages that wrap the buffer of a grab result. The grab
+ * result is kept alive till the last subscriber released the message, only
+ * afterwards the buffer is handed back to the stream grabber. The factory is
+ * kept alive as well, because pylon frees the buffer through it.
+ */
+struct GrabResultReleaser
+{
+    GrabResultReleaser(const boost::shared_ptr<ImageBufferFactory>& factory,
+                       const Pylon::CGrabResultPtr& grab_result)
+        : factory_(factory)
+        , grab_result_(grab_result)
+    {}
+
+    void operator()(sensor_msgs::Image*)
+    {
+        // the message itself is owned by the pool
+        grab_result_.Release();
+    }
+
+    // declared before the grab result: members are destroyed in reverse
+    // order, hence the factory outlives the grab result
+    boost::shared_ptr<ImageBufferFactory> factory_;
+    Pylon::CGrabResultPtr grab_result_;
+};
+
+}  // namespace pylon_camera
+
+#endif  // PYLON_CAMERA_INTERNAL_IMAGE_BUFFER_FACTORY_H
@@ -0,0 +1,78 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#ifndef PYLON_CAMERA_INTERNAL_IMAGE_EVENT_HANDLER_H
+#define PYLON_CAMERA_INTERNAL_IMAGE_EVENT_HANDLER_H
+
+#include <pylon/PylonIncludes.h>
+#include <boost/function.hpp>
+#include <ros/console.h>
+
+namespace pylon_camera
+{
+
+/**
+ * Image event handler for the grab loop thread of the pylon InstantCamera.
+ * Forwards every grab result to the given function as soon as it has been
+ * retrieved, hence the function is called from the grab loop thread.
+ */
+class ImageEventHandler : public Pylon::CImageEventHandler
+{
+public:
+    typedef boost::function<void (const Pylon::CGrabResultPtr&)> GrabResultCallback;
+
+    explicit ImageEventHandler(const GrabResultCallback& callback)
+        : callback_(callback)
+    {}
+
+    virtual ~ImageEventHandler()
+    {}
+
+    virtual void OnImageGrabbed(Pylon::CInstantCamera& camera,
+                                const Pylon::CGrabResultPtr& grab_result)
+    {
+        callback_(grab_result);
+    }
+
+    virtual void OnImagesSkipped(Pylon::CInstantCamera& camera,
+                                 size_t count_of_skipped_images)
+    {
+        // only happens with the 'latest image only' strategy, where skipping
+        // frames is intended
+        ROS_DEBUG_STREAM("Grab loop skipped " << count_of_skipped_images
+                << " images");
+    }
+
+protected:
+    GrabResultCallback callback_;
+};
+
+}  // namespace pylon_camera
+
+#endif  // PYLON_CAMERA_INTERNAL_IMAGE_EVENT_HANDLER_H
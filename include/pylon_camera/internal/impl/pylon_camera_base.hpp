@@ -30,12 +30,17 @@
 #ifndef PYLON_CAMERA_INTERNAL_BASE_HPP_
 #define PYLON_CAMERA_INTERNAL_BASE_HPP_
 
+#include <algorithm>
+#include <cerrno>
 #include <cmath>
+#include <cstdio>
+#include <cstring>
 #include <string>
 #include <vector>
 
 #include <pylon_camera/internal/pylon_camera.h>
 #include <pylon_camera/encoding_conversions.h>
+#include <pylon_camera/packed_pixels.h>
 #include <sensor_msgs/image_encodings.h>
 
 namespace pylon_camera
@@ -43,16 +48,63 @@ namespace pylon_camera
 
 template <typename CameraTraitT>
 PylonCameraImpl<CameraTraitT>::PylonCameraImpl(Pylon::IPylonDevice* device) :
-    PylonCamera(),
-    cam_(new CBaslerInstantCameraT(device))
+    PylonCameraImpl(new CBaslerInstantCameraT(device))
 {}
 
+template <typename CameraTraitT>
+PylonCameraImpl<CameraTraitT>::PylonCameraImpl(CBaslerInstantCameraT* cam) :
+    PylonCamera(),
+    cam_(cam),
+    buffer_factory_(new ImageBufferFactory(
+                boost::shared_ptr<ImageBufferPool>(new ImageBufferPool()))),
+    triggers_in_flight_(0),
+    max_triggers_in_flight_(1),
+    stale_before_ticks_(0),
+    num_stale_frames_(0),
+    image_event_handler_(nullptr),
+    event_driven_(false),
+    event_mutex_(),
+    event_cond_(),
+    event_result_(),
+    event_result_id_(0),
+    num_event_waiters_(0),
+    image_callback_mutex_(),
+    image_callback_(),
+    device_removal_handler_(nullptr),
+    removal_callback_mutex_(),
+    removal_callback_(),
+    chunk_data_enabled_(false),
+    check_payload_crc_(false),
+    chunk_gain_min_(0.0),
+    chunk_gain_max_(0.0),
+    probe_downsampling_throughput_(true)
+{
+    // the factory has to be set before grabbing starts, its lifetime is
+    // managed by buffer_factory_ and the grabbed messages
+    cam_->SetBufferFactory(buffer_factory_.get(), Pylon::Cleanup_None);
+    serial_number_ = cam_->GetDeviceInfo().GetSerialNumber().c_str();
+    device_user_id_ = cam_->GetDeviceInfo().GetUserDefinedName().c_str();
+}
+
 template <typename CameraTraitT>
 PylonCameraImpl<CameraTraitT>::~PylonCameraImpl()
 {
+    // stops the grab loop thread before its event handler is deleted
     delete cam_;
     cam_ = nullptr;
 
+    if ( image_event_handler_ )
+    {
+        delete image_event_handler_;
+        image_event_handler_ = nullptr;
+    }
+
+    if ( device_removal_handler_ )
+    {
+        delete device_removal_handler_;
+        device_removal_handler_ = nullptr;
+    }
+
     if ( binary_exp_search_ )
     {
         delete binary_exp_search_;
@@ -61,13 +113,26 @@ PylonCameraImpl<CameraTraitT>::~PylonCameraImpl()
 }
 
 template <typename CameraTraitT>
-bool PylonCameraImpl<CameraTraitT>::registerCameraConfiguration()
+bool PylonCameraImpl<CameraTraitT>::registerCameraConfiguration(
+                                        const ACQUISITION_MODE& acquisition_mode)
 {
     try
     {
-        cam_->RegisterConfiguration(new Pylon::CSoftwareTriggerConfiguration,
-                                        Pylon::RegistrationMode_ReplaceAll,
-                                        Pylon::Cleanup_Delete);
+        acquisition_mode_ = acquisition_mode;
+        if ( !isFreeRunning() )
+        {
+            cam_->RegisterConfiguration(new Pylon::CSoftwareTriggerConfiguration,
+                                            Pylon::RegistrationMode_ReplaceAll,
+                                            Pylon::Cleanup_Delete);
+        }
+        else
+        {
+            // the camera streams with its own frame rate, hence the exposure
+            // of the next frame overlaps with the readout of the current one
+            cam_->RegisterConfiguration(new Pylon::CAcquireContinuousConfiguration,
+                                            Pylon::RegistrationMode_ReplaceAll,
+                                            Pylon::Cleanup_Delete);
+        }
         return true;
     }
     catch ( const GenICam::GenericException &e )
@@ -82,6 +147,18 @@ bool PylonCameraImpl<CameraTraitT>::openCamera()
 {
     try
     {
+        // registering the configurations replaces all handlers, hence the
+        // removal handler is appended right before opening
+        if ( !device_removal_handler_ )
+        {
+            device_removal_handler_ = new DeviceRemovalHandler(
+                    boost::bind(&PylonCameraImpl<CameraTraitT>::onDeviceRemoved,
+                                this));
+        }
+        cam_->DeregisterConfiguration(device_removal_handler_);
+        cam_->RegisterConfiguration(device_removal_handler_,
+                                    Pylon::RegistrationMode_Append,
+                                    Pylon::Cleanup_None);
         cam_->Open();
         return true;
     }
@@ -98,6 +175,110 @@ bool PylonCameraImpl<CameraTraitT>::isCamRemoved()
     return cam_->IsCameraDeviceRemoved();
 }
 
+template <typename CameraTraitT>
+void PylonCameraImpl<CameraTraitT>::setRemovalCallback(const RemovalCallback& callback)
+{
+    // blocks till a running call has finished
+    boost::lock_guard<boost::mutex> lock(removal_callback_mutex_);
+    removal_callback_ = callback;
+}
+
+template <typename CameraTraitT>
+void PylonCameraImpl<CameraTraitT>::onDeviceRemoved()
+{
+    ROS_ERROR_STREAM("Camera with serial number " << serial_number_
+            << " has been removed");
+    boost::lock_guard<boost::mutex> lock(removal_callback_mutex_);
+    if ( removal_callback_ )
+    {
+        removal_callback_();
+    }
+}
+
+template <typename CameraTraitT>
+bool PylonCameraImpl<CameraTraitT>::reconnect()
+{
+    try
+    {
+        // only enumerating the transport layer of the device with its serial
+        // number is faster than a full enumeration
+        Pylon::CDeviceInfo device_info;
+        device_info.SetSerialNumber(serial_number_.c_str());
+        device_info.SetDeviceClass(cam_->GetDeviceInfo().GetDeviceClass());
+        Pylon::DeviceInfoList_t filter;
+        filter.push_back(device_info);
+
+        Pylon::CTlFactory& tl_factory = Pylon::CTlFactory::GetInstance();
+        Pylon::DeviceInfoList_t device_list;
+        if ( tl_factory.EnumerateDevices(device_list, filter) == 0 )
+        {
+            return false;
+        }
+
+        is_ready_ = false;
+        // the registered configurations, event handlers and the buffer
+        // factory belong to the InstantCamera, hence they are kept
+        cam_->DestroyDevice();
+        cam_->Attach(tl_factory.CreateDevice(device_list.front()));
+        return true;
+    }
+    catch ( const GenICam::GenericException &e )
+    {
+        ROS_ERROR_STREAM("Error while reconnecting to the camera with serial "
+                << "number " << serial_number_ << ": " << e.GetDescription());
+        return false;
+    }
+}
+
+template <typename CameraTraitT>
+bool PylonCameraImpl<CameraTraitT>::saveFeatureSnapshot(const std::string& file_name)
+{
+    // written to a temporary file first, so that a concurrently starting
+    // node never loads a partial snapshot
+    const std::string tmp_file_name = file_name + ".tmp";
+    try
+    {
+        Pylon::CFeaturePersistence::Save(tmp_file_name.c_str(),
+                                         &cam_->GetNodeMap());
+    }
+    catch ( const GenICam::GenericException &e )
+    {
+        ROS_ERROR_STREAM("Error while saving the feature snapshot "
+                << file_name << ": " << e.GetDescription());
+        std::remove(tmp_file_name.c_str());
+        return false;
+    }
+    if ( std::rename(tmp_file_name.c_str(), file_name.c_str()) != 0 )
+    {
+        ROS_ERROR_STREAM("Error while saving the feature snapshot "
+                << file_name << ": " << std::strerror(errno));
+        std::remove(tmp_file_name.c_str());
+        return false;
+    }
+    return true;
+}
+
+template <typename CameraTraitT>
+bool PylonCameraImpl<CameraTraitT>::loadFeatureSnapshot(const std::string& file_name)
+{
+    try
+    {
+        // the validation reports every feature that couldn't be restored
+        Pylon::CFeaturePersistence::Load(file_name.c_str(),
+                                         &cam_->GetNodeMap(),
+                                         true);
+    }
+    catch ( const GenICam::GenericException &e )
+    {
+        ROS_WARN_STREAM("Couldn't restore the feature snapshot "
+                << file_name << ": " << e.GetDescription());
+        return false;
+    }
+    // probing would overwrite the restored binning and decimation
+    probe_downsampling_throughput_ = false;
+    return true;
+}
+
 template <typename CameraTraitT>
 size_t PylonCameraImpl<CameraTraitT>::currentBinningX()
 {
@@ -125,19 +306,186 @@ size_t PylonCameraImpl<CameraTraitT>::currentBinningY()
 }
 
 template <typename CameraTraitT>
-std::string PylonCameraImpl<CameraTraitT>::currentROSEncoding() const
+size_t PylonCameraImpl<CameraTraitT>::currentDecimationX()
+{
+    if ( GenApi::IsAvailable(cam_->DecimationHorizontal) )
+    {
+        return static_cast<size_t>(cam_->DecimationHorizontal.GetValue());
+    }
+    else
+    {
+        return 1;
+    }
+}
+
+template <typename CameraTraitT>
+size_t PylonCameraImpl<CameraTraitT>::currentDecimationY()
+{
+    if ( GenApi::IsAvailable(cam_->DecimationVertical) )
+    {
+        return static_cast<size_t>(cam_->DecimationVertical.GetValue());
+    }
+    else
+    {
+        return 1;
+    }
+}
+
+template <typename CameraTraitT>
+void PylonCameraImpl<CameraTraitT>::resolveDownsampling(const size_t& factor_x,
+                                                        const size_t& factor_y,
+                                                        const bool& prefer_decimation,
+                                                        CameraConfiguration& target)
+{
+    bool binning_ok = false;
+    bool decimation_ok = false;
+    bool has_decimation = false;
+    try
+    {
+        binning_ok = GenApi::IsAvailable(cam_->BinningHorizontal) &&
+                     GenApi::IsAvailable(cam_->BinningVertical) &&
+                     cam_->BinningHorizontal.GetMax() >= static_cast<int64_t>(factor_x) &&
+                     cam_->BinningVertical.GetMax() >= static_cast<int64_t>(factor_y);
+        has_decimation = GenApi::IsAvailable(cam_->DecimationHorizontal) &&
+                         GenApi::IsAvailable(cam_->DecimationVertical);
+        decimation_ok = has_decimation &&
+                        cam_->DecimationHorizontal.GetMax() >= static_cast<int64_t>(factor_x) &&
+                        cam_->DecimationVertical.GetMax() >= static_cast<int64_t>(factor_y);
+    }
+    catch ( const GenICam::GenericException &e )
+    {
+        ROS_ERROR_STREAM("An exception while reading the downsampling ranges "
+                << "occurred: " << e.GetDescription());
+    }
+
+    // the preferred mode is used if it reaches the factors, the other one
+    // otherwise. Binning is the fallback, because it's more common
+    const bool use_decimation = prefer_decimation ?
+                                decimation_ok || !binning_ok :
+                                decimation_ok && !binning_ok;
+    target.has_binning_ = true;
+    target.binning_x_ = use_decimation ? 1 : factor_x;
+    target.binning_y_ = use_decimation ? 1 : factor_y;
+    target.has_decimation_ = has_decimation;
+    target.decimation_x_ = use_decimation ? factor_x : 1;
+    target.decimation_y_ = use_decimation ? factor_y : 1;
+    ROS_INFO_STREAM("Downsampling by (" << factor_x << ", " << factor_y
+            << ") with " << ( use_decimation ? "decimation" : "binning" )
+            << ", preferring " << ( prefer_decimation ? "the frame rate" : "the SNR" ));
+}
+
+template <typename CameraTraitT>
+void PylonCameraImpl<CameraTraitT>::writeDownsampling(const size_t& binning_x,
+                                                      const size_t& binning_y,
+                                                      const size_t& decimation_x,
+                                                      const size_t& decimation_y)
+{
+    // some cameras don't allow binning and decimation at the same time,
+    // hence both are reset before the factors are written
+    const bool has_binning = GenApi::IsAvailable(cam_->BinningHorizontal) &&
+                             GenApi::IsAvailable(cam_->BinningVertical);
+    const bool has_decimation = GenApi::IsAvailable(cam_->DecimationHorizontal) &&
+                                GenApi::IsAvailable(cam_->DecimationVertical);
+    if ( has_decimation )
+    {
+        cam_->DecimationHorizontal.SetValue(1);
+        cam_->DecimationVertical.SetValue(1);
+    }
+    if ( has_binning )
+    {
+        cam_->BinningHorizontal.SetValue(1);
+        cam_->BinningVertical.SetValue(1);
+        cam_->BinningHorizontal.SetValue(clampedValue(cam_->BinningHorizontal, binning_x));
+        cam_->BinningVertical.SetValue(clampedValue(cam_->BinningVertical, binning_y));
+    }
+    if ( has_decimation )
+    {
+        cam_->DecimationHorizontal.SetValue(
+                            clampedValue(cam_->DecimationHorizontal, decimation_x));
+        cam_->DecimationVertical.SetValue(
+                            clampedValue(cam_->DecimationVertical, decimation_y));
+    }
+}
+
+template <typename CameraTraitT>
+int64_t PylonCameraImpl<CameraTraitT>::clampedValue(GenApi::IInteger& feature,
+                                                    const size_t& value)
+{
+    return std::max(feature.GetMin(),
+                    std::min(static_cast<int64_t>(value), feature.GetMax()));
+}
+
+template <typename CameraTraitT>
+void PylonCameraImpl<CameraTraitT>::logDownsamplingThroughput(const size_t& factor_x,
+                                                              const size_t& factor_y)
 {
-    std::string gen_api_encoding(cam_->PixelFormat.ToString().c_str());
-    std::string ros_encoding("");
-    if ( !encoding_conversions::genAPI2Ros(gen_api_encoding, ros_encoding) )
+    const bool has_binning = GenApi::IsAvailable(cam_->BinningHorizontal) &&
+                             GenApi::IsAvailable(cam_->BinningVertical);
+    const bool has_decimation = GenApi::IsAvailable(cam_->DecimationHorizontal) &&
+                                GenApi::IsAvailable(cam_->DecimationVertical);
+    const size_t binning_x = currentBinningX();
+    const size_t binning_y = currentBinningY();
+    const size_t decimation_x = currentDecimationX();
+    const size_t decimation_y = currentDecimationY();
+    // changing the factors clamps the region of interest, hence it is
+    // restored as well
+    const int64_t width = cam_->Width.GetValue();
+    const int64_t height = cam_->Height.GetValue();
+    const int64_t offset_x = cam_->OffsetX.GetValue();
+    const int64_t offset_y = cam_->OffsetY.GetValue();
+    try
     {
         std::stringstream ss;
-        ss << "No ROS equivalent to GenApi encoding '" << gen_api_encoding
-           << "' found! This is bad because this case should never occur!";
-        throw std::runtime_error(ss.str());
-        return "NO_ENCODING";
+        ss << "Max throughput at the current exposure, downsampling by ("
+           << factor_x << ", " << factor_y << "):";
+        const char* mode_names[] = { "none", "binning", "decimation" };
+        for ( int mode = 0; mode < 3; ++mode )
+        {
+            if ( ( mode == 1 && !has_binning ) || ( mode == 2 && !has_decimation ) )
+            {
+                continue;
+            }
+            writeDownsampling(mode == 1 ? factor_x : 1,
+                              mode == 1 ? factor_y : 1,
+                              mode == 2 ? factor_x : 1,
+                              mode == 2 ? factor_y : 1);
+            const double frame_rate = resultingFrameRate().GetValue();
+            const double payload_size = static_cast<double>(cam_->PayloadSize.GetValue());
+            ss << " " << mode_names[mode] << " = " << cam_->Width.GetValue()
+               << "x" << cam_->Height.GetValue() << " @ " << frame_rate
+               << " Hz, " << frame_rate * payload_size / 1e6 << " MB/s;";
+        }
+        ROS_INFO_STREAM(ss.str());
+    }
+    catch ( const GenICam::GenericException &e )
+    {
+        ROS_WARN_STREAM("Couldn't determine the throughput of the downsampling "
+                << "modes: " << e.GetDescription());
+    }
+
+    try
+    {
+        writeDownsampling(binning_x, binning_y, decimation_x, decimation_y);
+        // the offsets are reset first, so that the full width and height fit
+        cam_->OffsetX.SetValue(cam_->OffsetX.GetMin());
+        cam_->OffsetY.SetValue(cam_->OffsetY.GetMin());
+        cam_->Width.SetValue(width);
+        cam_->Height.SetValue(height);
+        cam_->OffsetX.SetValue(offset_x);
+        cam_->OffsetY.SetValue(offset_y);
+    }
+    catch ( const GenICam::GenericException &e )
+    {
+        ROS_ERROR_STREAM("Couldn't restore the binning, decimation and region "
+                << "of interest after determining their throughput: "
+                << e.GetDescription());
     }
-    return ros_encoding;
+}
+
+template <typename CameraTraitT>
+std::string PylonCameraImpl<CameraTraitT>::currentROSEncoding() const
+{
+    return state()->ros_encoding_;
 }
 
 template <typename CameraTraitT>
@@ -149,8 +497,9 @@ float PylonCameraImpl<CameraTraitT>::currentExposure()
 template <typename CameraTraitT>
 float PylonCameraImpl<CameraTraitT>::currentGain()
 {
-    float curr_gain = (static_cast<float>(gain().GetValue()) - static_cast<float>(gain().GetMin())) /
-        (static_cast<float>(gain().GetMax() - static_cast<float>(gain().GetMin())));
+    const CameraStateSnapshotConstPtr current_state = state();
+    float curr_gain = (static_cast<float>(gain().GetValue()) - current_state->gain_min_) /
+        (current_state->gain_max_ - current_state->gain_min_);
     return curr_gain;
 }
 
@@ -293,14 +642,96 @@ bool PylonCameraImpl<CameraTraitT>::startGrabbing(const PylonCameraParameter& pa
             return false;
         }
 
-        cam_->StartGrabbing();
+        // each frame in flight occupies a grab buffer
+        max_triggers_in_flight_ = std::max(1,
+                    std::min(parameters.triggers_in_flight_,
+                             static_cast<int>(cam_->MaxNumBuffer.GetValue())));
+        if ( acquisition_mode_ == AM_PIPELINED_SOFTWARE_TRIGGER &&
+             max_triggers_in_flight_ != parameters.triggers_in_flight_ )
+        {
+            ROS_WARN_STREAM("Limiting the number of triggers in flight to "
+                    << max_triggers_in_flight_ << " (MaxNumBuffer)");
+        }
+
+        // the grab loop thread of the InstantCamera only makes sense for
+        // the free-running modes, the trigger modes have to trigger each
+        // frame before retrieving it
+        event_driven_ = parameters.event_driven_grabbing_ && isFreeRunning();
+        if ( event_driven_ && !image_event_handler_ )
+        {
+            image_event_handler_ = new ImageEventHandler(
+                    boost::bind(&PylonCameraImpl<CameraTraitT>::onImageGrabbed,
+                                this,
+                                _1));
+            cam_->RegisterImageEventHandler(image_event_handler_,
+                                            Pylon::RegistrationMode_Append,
+                                            Pylon::Cleanup_None);
+        }
+
+        // opening the camera resets its clock. The model is set up before
+        // grabbing starts, because in event-driven grabbing the grab loop
+        // thread stamps the frames with it right away
+        try
+        {
+            clock_model_.reset(timestampTickFrequency());
+        }
+        catch ( const std::runtime_error& e )
+        {
+            ROS_WARN_STREAM(e.what() << ". Assuming a 1 GHz camera clock");
+            clock_model_.reset(1e9);
+        }
+        syncClock();
+
+        // grabbing is restarted for every recovery and reconfiguration of
+        // the downsampling, the throughput doesn't change in between. The
+        // probe compares the requested factors, given either directly or as
+        // binning or decimation, 0 counts as 1
+        if ( probe_downsampling_throughput_ )
+        {
+            probe_downsampling_throughput_ = false;
+            size_t factor_x = 1;
+            size_t factor_y = 1;
+            if ( parameters.downsampling_given_ )
+            {
+                factor_x = parameters.downsampling_x_;
+                factor_y = parameters.downsampling_y_;
+            }
+            else
+            {
+                if ( parameters.binning_x_given_ )
+                {
+                    factor_x = std::max(factor_x, parameters.binning_x_);
+                }
+                if ( parameters.binning_y_given_ )
+                {
+                    factor_y = std::max(factor_y, parameters.binning_y_);
+                }
+                if ( parameters.decimation_x_given_ )
+                {
+                    factor_x = std::max(factor_x, parameters.decimation_x_);
+                }
+                if ( parameters.decimation_y_given_ )
+                {
+                    factor_y = std::max(factor_y, parameters.decimation_y_);
+                }
+            }
+            if ( factor_x > 1 || factor_y > 1 )
+            {
+                logDownsamplingThroughput(std::max<size_t>(factor_x, 1),
+                                          std::max<size_t>(factor_y, 1));
+            }
+        }
+
+        chunk_data_enabled_ = setupChunkData(parameters.enable_chunk_data_);
+        check_payload_crc_ = chunk_data_enabled_ && parameters.check_payload_crc_;
+
+        cam_->StartGrabbing(grabStrategy(), grabLoop());
+        triggers_in_flight_ = 0;
         user_output_selector_enums_ = detectAndCountNumUserOutputs();
         device_user_id_ = cam_->DeviceUserID.GetValue();
-        img_rows_ = static_cast<size_t>(cam_->Height.GetValue());
-        img_cols_ = static_cast<size_t>(cam_->Width.GetValue());
-        img_size_byte_ =  img_cols_ * img_rows_ * imagePixelDepth();
+        updateState();
 
-        grab_timeout_ = exposureTime().GetMax() * 1.05;
+        grab_timeout_ = state()->exposure_max_ * 1.05;
 
         // grab one image to be sure, that the communication is successful
         Pylon::CGrabResultPtr grab_result;
@@ -323,7 +754,8 @@ bool PylonCameraImpl<CameraTraitT>::startGrabbing(const PylonCameraParameter& pa
 }
 
 template <typename CameraTrait>
-bool PylonCameraImpl<CameraTrait>::grab(std::vector<uint8_t>& image)
+bool PylonCameraImpl<CameraTrait>::grab(std::vector<uint8_t>& image,
+                                        FrameMetadata& metadata)
 {
     Pylon::CGrabResultPtr ptr_grab_result;
     if ( !grab(ptr_grab_result) )
@@ -331,9 +763,19 @@ bool PylonCameraImpl<CameraTrait>::grab(std::vector<uint8_t>& image)
         ROS_ERROR("Error: Grab was not successful");
         return false;
     }
+    fillMetadata(ptr_grab_result, metadata);
 
+    ScopedLatency latency(statistics_, LS_BUFFER);
     const uint8_t *pImageBuffer = reinterpret_cast<uint8_t*>(ptr_grab_result->GetBuffer());
-    image.assign(pImageBuffer, pImageBuffer + img_size_byte_);
+    if ( packed_bits_ > 0 )
+    {
+        image.resize(img_size_byte_);
+        unpackImage(pImageBuffer, image.data());
+    }
+    else
+    {
+        image.assign(pImageBuffer, pImageBuffer + img_size_byte_);
+    }
 
     if ( !is_ready_ )
         is_ready_ = true;
@@ -351,30 +793,183 @@ bool PylonCameraImpl<CameraTrait>::grab(uint8_t* image)
         return false;
     }
 
-    memcpy(image, ptr_grab_result->GetBuffer(), img_size_byte_);
+    ScopedLatency latency(statistics_, LS_BUFFER);
+    if ( packed_bits_ > 0 )
+    {
+        unpackImage(reinterpret_cast<uint8_t*>(ptr_grab_result->GetBuffer()), image);
+    }
+    else
+    {
+        memcpy(image, ptr_grab_result->GetBuffer(), img_size_byte_);
+    }
+
+    return true;
+}
+
+template <typename CameraTrait>
+bool PylonCameraImpl<CameraTrait>::grab(sensor_msgs::ImagePtr& image,
+                                        FrameMetadata& metadata)
+{
+    Pylon::CGrabResultPtr ptr_grab_result;
+    if ( !grab(ptr_grab_result) )
+    {
+        ROS_ERROR("Error: Grab was not successful");
+        return false;
+    }
+    fillMetadata(ptr_grab_result, metadata);
+    wrapGrabResult(ptr_grab_result, image);
+
+    if ( !is_ready_ )
+        is_ready_ = true;
 
     return true;
 }
 
+template <typename CameraTrait>
+void PylonCameraImpl<CameraTrait>::wrapGrabResult(
+                                    const Pylon::CGrabResultPtr& grab_result,
+                                    sensor_msgs::ImagePtr& image)
+{
+    ScopedLatency latency(statistics_, LS_BUFFER);
+    if ( packed_bits_ > 0 )
+    {
+        // the unpacked image is larger than the buffer of the grabber, hence
+        // it can't be wrapped
+        image.reset(new sensor_msgs::Image());
+        image->data.resize(img_size_byte_);
+        unpackImage(reinterpret_cast<uint8_t*>(grab_result->GetBuffer()),
+                    image->data.data());
+        return;
+    }
+    sensor_msgs::ImagePtr pool_img =
+            buffer_factory_->pool().image(grab_result->GetBufferContext());
+    // the payload might be larger than the image (e.g. appended chunk data).
+    // Shrinking the data vector keeps the buffer in place, whereas growing it
+    // would move it away from the stream grabber
+    if ( pool_img && img_size_byte_ <= pool_img->data.size() )
+    {
+        pool_img->data.resize(img_size_byte_);
+        image = sensor_msgs::ImagePtr(pool_img.get(),
+                                      GrabResultReleaser(buffer_factory_,
+                                                         grab_result));
+    }
+    else
+    {
+        // buffer not provided by the pool -> fallback to copying
+        const uint8_t *pImageBuffer = reinterpret_cast<uint8_t*>(grab_result->GetBuffer());
+        image.reset(new sensor_msgs::Image());
+        image->data.assign(pImageBuffer, pImageBuffer + img_size_byte_);
+    }
+}
+
+template <typename CameraTrait>
+void PylonCameraImpl<CameraTrait>::unpackImage(const uint8_t* packed, uint8_t* image)
+{
+    // the buffers of std::vector and the grabber are aligned to at least 2 byte
+    packed_pixels::unpack(packed, reinterpret_cast<uint16_t*>(image),
+                          img_rows_ * img_cols_, packed_bits_);
+}
+
+template <typename CameraTrait>
+void PylonCameraImpl<CameraTrait>::updateState()
+{
+    CameraStateSnapshot* state = new CameraStateSnapshot();
+    state->gen_api_encoding_ = std::string(cam_->PixelFormat.ToString().c_str());
+    if ( !encoding_conversions::genAPI2Ros(state->gen_api_encoding_,
+                                           state->ros_encoding_) )
+    {
+        ROS_ERROR_STREAM("No ROS equivalent to GenApi encoding '"
+                << state->gen_api_encoding_ << "' found!");
+        state->ros_encoding_ = "NO_ENCODING";
+    }
+    else
+    {
+        state->is_mono_ = sensor_msgs::image_encodings::isMono(
+                                                        state->ros_encoding_);
+        state->is_yuv_ = state->ros_encoding_ ==
+                                        sensor_msgs::image_encodings::YUV422;
+        state->bit_depth_ = sensor_msgs::image_encodings::bitDepth(
+                                                        state->ros_encoding_);
+    }
+    state->packed_bits_ = packed_pixels::packedBits(state->gen_api_encoding_);
+    // pylon PixelSize already contains the number of channels, the size is
+    // given in bit, wheras ROS provides it in byte. Packed pixels are
+    // published unpacked to 16 bit.
+    state->pixel_depth_ = state->packed_bits_ > 0 ?
+                          2 : static_cast<int>(cam_->PixelSize.GetIntValue() / 8);
+    state->rows_ = static_cast<size_t>(cam_->Height.GetValue());
+    state->cols_ = static_cast<size_t>(cam_->Width.GetValue());
+    state->size_byte_ = state->rows_ * state->cols_ * state->pixel_depth_;
+    state->exposure_min_ = static_cast<double>(exposureTime().GetMin());
+    state->exposure_max_ = static_cast<double>(exposureTime().GetMax());
+    state->gain_min_ = static_cast<double>(gain().GetMin());
+    state->gain_max_ = static_cast<double>(gain().GetMax());
+
+    img_rows_ = state->rows_;
+    img_cols_ = state->cols_;
+    packed_bits_ = state->packed_bits_;
+    img_size_byte_ = state->size_byte_;
+    publishState(state);
+}
+
 template <typename CameraTrait>
 bool PylonCameraImpl<CameraTrait>::grab(Pylon::CGrabResultPtr& grab_result)
 {
+    while ( retrieveResult(grab_result) )
+    {
+        if ( !isStale(grab_result) )
+        {
+            return true;
+        }
+        ROS_DEBUG("Skipping a frame exposed before the last setting change");
+    }
+    return false;
+}
+
+template <typename CameraTrait>
+bool PylonCameraImpl<CameraTrait>::retrieveResult(Pylon::CGrabResultPtr& grab_result)
+{
+    if ( event_driven_ )
+    {
+        // the grab loop thread retrieves the results
+        return waitForImageEvent(grab_result);
+    }
+
     try
     {
         int timeout = 5000;  // ms
 
-        // WaitForFrameTriggerReady to prevent trigger signal to get lost
-        // this could happen, if 2xExecuteSoftwareTrigger() is only followed by 1xgrabResult()
-        // -> 2nd trigger might get lost
-        if ( cam_->WaitForFrameTriggerReady(timeout, Pylon::TimeoutHandling_ThrowException) )
+        // in the free-running modes the camera triggers itself, hence we only
+        // have to retrieve the results
+        if ( acquisition_mode_ == AM_SOFTWARE_TRIGGER )
         {
-            cam_->ExecuteSoftwareTrigger();
+            ScopedLatency latency(statistics_, LS_TRIGGER_WAIT);
+            // WaitForFrameTriggerReady to prevent trigger signal to get lost
+            // this could happen, if 2xExecuteSoftwareTrigger() is only followed by 1xgrabResult()
+            // -> 2nd trigger might get lost
+            if ( cam_->WaitForFrameTriggerReady(timeout, Pylon::TimeoutHandling_ThrowException) )
+            {
+                cam_->ExecuteSoftwareTrigger();
+            }
+            else
+            {
+                ROS_ERROR("Error WaitForFrameTriggerReady() timed out, impossible to ExecuteSoftwareTrigger()");
+                return false;
+            }
         }
-        else
+        else if ( acquisition_mode_ == AM_PIPELINED_SOFTWARE_TRIGGER )
         {
-            ROS_ERROR("Error WaitForFrameTriggerReady() timed out, impossible to ExecuteSoftwareTrigger()");
-            return false;
+            ScopedLatency latency(statistics_, LS_TRIGGER_WAIT);
+            if ( !fillTriggerPipeline(timeout) )
+            {
+                return false;
+            }
+            // the frame counts as retrieved even if retrieving fails, e.g.
+            // because the trigger got lost. Otherwise the pipeline would
+            // stall waiting for it
+            --triggers_in_flight_;
         }
+        ScopedLatency latency(statistics_, LS_RETRIEVE);
         cam_->RetrieveResult(grab_timeout_, grab_result, Pylon::TimeoutHandling_ThrowException);
     }
     catch ( const GenICam::GenericException &e )
@@ -406,23 +1001,341 @@ bool PylonCameraImpl<CameraTrait>::grab(Pylon::CGrabResultPtr& grab_result)
 }
 
 template <typename CameraTraitT>
-std::vector<std::string> PylonCameraImpl<CameraTraitT>::detectAvailableImageEncodings()
+void PylonCameraImpl<CameraTraitT>::markQueuedFramesStale()
 {
-    std::vector<std::string> available_encodings;
-    GenApi::INodeMap& node_map = cam_->GetNodeMap();
-    GenApi::CEnumerationPtr img_encoding_enumeration_ptr(
-                                        node_map.GetNode("PixelFormat"));
-    GenApi::NodeList_t feature_list;
-    img_encoding_enumeration_ptr->GetEntries(feature_list);
-    std::stringstream ss;
-    ss << "Cam supports the following [GenAPI|ROS] image encodings: ";
-    for (GenApi::NodeList_t::iterator it = feature_list.begin();
-         it != feature_list.end();
-         ++it)
+    if ( acquisition_mode_ == AM_SOFTWARE_TRIGGER && !event_driven_ )
     {
-        if ( GenApi::IsAvailable(*it) )
-        {
-            GenApi::CEnumEntryPtr enum_entry(*it);
+        return;
+    }
+    try
+    {
+        // every frame exposed from now on starts after the latched time
+        timestampLatch().Execute();
+        stale_before_ticks_ = timestampLatchValue().GetValue();
+        num_stale_frames_ = 0;
+        return;
+    }
+    catch ( const GenICam::GenericException &e )
+    {
+        ROS_DEBUG_STREAM("Can't latch the camera clock to skip stale frames: "
+                << e.GetDescription());
+    }
+    catch ( const std::runtime_error &e )
+    {
+        ROS_DEBUG_STREAM("Can't latch the camera clock to skip stale frames: "
+                << e.what());
+    }
+
+    // without the camera clock the stale frames are counted instead: the
+    // triggered ones in the pipelined mode, otherwise the queued frames are
+    // dropped and the frames being exposed and transferred are skipped
+    stale_before_ticks_ = 0;
+    if ( acquisition_mode_ == AM_PIPELINED_SOFTWARE_TRIGGER )
+    {
+        num_stale_frames_ = triggers_in_flight_;
+        return;
+    }
+    if ( !event_driven_ && cam_->IsGrabbing() )
+    {
+        Pylon::CGrabResultPtr queued;
+        while ( cam_->RetrieveResult(0, queued, Pylon::TimeoutHandling_Return) )
+        {
+        }
+    }
+    num_stale_frames_ = 2;
+}
+
+template <typename CameraTraitT>
+bool PylonCameraImpl<CameraTraitT>::isStale(const Pylon::CGrabResultPtr& grab_result)
+{
+    if ( num_stale_frames_ > 0 )
+    {
+        --num_stale_frames_;
+        return true;
+    }
+    if ( stale_before_ticks_ == 0 )
+    {
+        return false;
+    }
+    const uint64_t ticks = grab_result->GetTimeStamp();
+    if ( ticks != 0 && ticks < stale_before_ticks_ )
+    {
+        return true;
+    }
+    stale_before_ticks_ = 0;
+    return false;
+}
+
+template <typename CameraTraitT>
+bool PylonCameraImpl<CameraTraitT>::fillTriggerPipeline(const int& timeout)
+{
+    while ( triggers_in_flight_ < max_triggers_in_flight_ )
+    {
+        // The camera is ready for the next trigger as soon as it can expose
+        // the next frame, which is usually during the transfer of the
+        // previous one. Without any frame in flight we have to wait for it,
+        // otherwise we only poll and retrieve the oldest frame if the camera
+        // isn't ready, e.g. because all buffers are held by subscribers.
+        const int wait = triggers_in_flight_ > 0 ? 0 : timeout;
+        if ( !cam_->WaitForFrameTriggerReady(wait, Pylon::TimeoutHandling_Return) )
+        {
+            if ( triggers_in_flight_ > 0 )
+            {
+                break;
+            }
+            ROS_ERROR("Error WaitForFrameTriggerReady() timed out, impossible to ExecuteSoftwareTrigger()");
+            return false;
+        }
+        cam_->ExecuteSoftwareTrigger();
+        ++triggers_in_flight_;
+    }
+    return true;
+}
+
+template <typename CameraTraitT>
+void PylonCameraImpl<CameraTraitT>::onImageGrabbed(
+                                    const Pylon::CGrabResultPtr& grab_result)
+{
+    {
+        boost::lock_guard<boost::mutex> lock(event_mutex_);
+        if ( num_event_waiters_ > 0 )
+        {
+            event_result_ = grab_result;
+            ++event_result_id_;
+            event_cond_.notify_all();
+        }
+    }
+
+    if ( !grab_result->GrabSucceeded() )
+    {
+        ROS_ERROR_STREAM("Error: " << grab_result->GetErrorCode() << " "
+                << grab_result->GetErrorDescription());
+        return;
+    }
+
+    boost::lock_guard<boost::mutex> lock(image_callback_mutex_);
+    if ( image_callback_.empty() )
+    {
+        return;
+    }
+    FrameMetadata metadata;
+    fillMetadata(grab_result, metadata);
+    sensor_msgs::ImagePtr image;
+    wrapGrabResult(grab_result, image);
+    image_callback_(image, metadata);
+}
+
+template <typename CameraTraitT>
+bool PylonCameraImpl<CameraTraitT>::waitForImageEvent(
+                                    Pylon::CGrabResultPtr& grab_result)
+{
+    boost::unique_lock<boost::mutex> lock(event_mutex_);
+    const uint64_t last_result_id = event_result_id_;
+    ++num_event_waiters_;
+    const bool received = event_cond_.wait_for(
+            lock,
+            boost::chrono::milliseconds(static_cast<int64_t>(grab_timeout_)),
+            [this, last_result_id]() { return event_result_id_ != last_result_id; });
+    --num_event_waiters_;
+    if ( received )
+    {
+        grab_result = event_result_;
+    }
+    if ( num_event_waiters_ == 0 )
+    {
+        // hand the buffer back to the grab loop
+        event_result_.Release();
+    }
+    lock.unlock();
+
+    if ( !received )
+    {
+        if ( cam_->IsCameraDeviceRemoved() )
+        {
+            ROS_ERROR("Lost connection to the camera . . .");
+        }
+        else
+        {
+            ROS_ERROR("Timeout while waiting for the grab loop to retrieve the next image");
+        }
+        return false;
+    }
+    if ( !grab_result->GrabSucceeded() )
+    {
+        ROS_ERROR_STREAM("Error: " << grab_result->GetErrorCode() << " "
+                << grab_result->GetErrorDescription());
+        return false;
+    }
+    return true;
+}
+
+template <typename CameraTraitT>
+void PylonCameraImpl<CameraTraitT>::setImageCallback(const ImageCallback& callback)
+{
+    // blocks till a running call has finished
+    boost::lock_guard<boost::mutex> lock(image_callback_mutex_);
+    image_callback_ = callback;
+}
+
+template <typename CameraTraitT>
+void PylonCameraImpl<CameraTraitT>::fillMetadata(
+                                    const Pylon::CGrabResultPtr& grab_result,
+                                    FrameMetadata& metadata) const
+{
+    metadata.host_stamp_ = ros::Time::now();
+    // the camera stamps the frame when the exposure starts
+    metadata.camera_ticks_ = grab_result->GetTimeStamp();
+
+    if ( chunk_data_enabled_ && grab_result->IsChunkDataAvailable() )
+    {
+        try
+        {
+            readChunkData(grab_result, metadata);
+            if ( check_payload_crc_ && grab_result->HasCRC() )
+            {
+                metadata.has_crc_ = true;
+                metadata.crc_ok_ = grab_result->CheckCRC();
+            }
+        }
+        catch ( const GenICam::GenericException &e )
+        {
+            ROS_ERROR_STREAM_THROTTLE(5.0, "Error while reading the chunk data: "
+                    << e.GetDescription());
+        }
+    }
+
+    metadata.has_camera_stamp_ = metadata.camera_ticks_ != 0 &&
+                                 clock_model_.isValid();
+    if ( metadata.has_camera_stamp_ )
+    {
+        metadata.camera_stamp_ = clock_model_.toRosTime(metadata.camera_ticks_);
+    }
+}
+
+template <typename CameraTraitT>
+float PylonCameraImpl<CameraTraitT>::normalizedGain(const double& gain) const
+{
+    if ( chunk_gain_max_ <= chunk_gain_min_ )
+    {
+        return 0.0;
+    }
+    return static_cast<float>((gain - chunk_gain_min_) /
+                              (chunk_gain_max_ - chunk_gain_min_));
+}
+
+template <typename CameraTraitT>
+bool PylonCameraImpl<CameraTraitT>::syncClock()
+{
+    try
+    {
+        GenApi::ICommand& latch = timestampLatch();
+        GenApi::IInteger& latch_value = timestampLatchValue();
+        // the time between sending the latch command and its acknowledge
+        // limits the accuracy of the sample
+        const ros::Time before = ros::Time::now();
+        latch.Execute();
+        const ros::Time after = ros::Time::now();
+        return clock_model_.addSample(static_cast<uint64_t>(latch_value.GetValue()),
+                                      before,
+                                      after);
+    }
+    catch ( const GenICam::GenericException &e )
+    {
+        ROS_ERROR_STREAM("An exception while latching the camera clock occurred: "
+                << e.GetDescription());
+        return false;
+    }
+    catch ( const std::runtime_error& e )
+    {
+        ROS_WARN_STREAM_ONCE(e.what() << ". The frames will be stamped with "
+                << "the host time");
+        return false;
+    }
+}
+
+template <typename CameraTraitT>
+bool PylonCameraImpl<CameraTraitT>::setupAcquisitionMode(const PylonCameraParameter& parameters)
+{
+    try
+    {
+        cam_->TriggerSelector.SetValue(TriggerSelectorEnums::TriggerSelector_FrameStart);
+        if ( !isFreeRunning() )
+        {
+            cam_->TriggerSource.SetValue(TriggerSourceEnums::TriggerSource_Software);
+            cam_->TriggerMode.SetValue(TriggerModeEnums::TriggerMode_On);
+            return true;
+        }
+
+        cam_->TriggerMode.SetValue(TriggerModeEnums::TriggerMode_Off);
+        if ( !GenApi::IsAvailable(cam_->AcquisitionFrameRateEnable) )
+        {
+            ROS_WARN_STREAM("Camera does not support limiting the acquisition "
+                    << "frame rate. Will acquire with the max possible rate.");
+            return true;
+        }
+        if ( parameters.frameRate() > 0.0 )
+        {
+            // limit the frame rate of the free-running camera to the desired
+            // publisher frame rate
+            cam_->AcquisitionFrameRateEnable.SetValue(true);
+            double frame_rate_to_set = std::max(acquisitionFrameRate().GetMin(),
+                                                std::min(parameters.frameRate(),
+                                                         acquisitionFrameRate().GetMax()));
+            acquisitionFrameRate().SetValue(frame_rate_to_set);
+        }
+        else
+        {
+            cam_->AcquisitionFrameRateEnable.SetValue(false);
+        }
+    }
+    catch ( const GenICam::GenericException &e )
+    {
+        ROS_ERROR_STREAM("An exception while setting up the acquisition mode "
+                << parameters.acquisitionModeString() << " occurred: "
+                << e.GetDescription());
+        return false;
+    }
+    return true;
+}
+
+template <typename CameraTraitT>
+Pylon::EGrabStrategy PylonCameraImpl<CameraTraitT>::grabStrategy() const
+{
+    if ( acquisition_mode_ == AM_FREE_RUN_LATEST_IMAGE_ONLY )
+    {
+        return Pylon::GrabStrategy_LatestImageOnly;
+    }
+    return Pylon::GrabStrategy_OneByOne;
+}
+
+template <typename CameraTraitT>
+Pylon::EGrabLoop PylonCameraImpl<CameraTraitT>::grabLoop() const
+{
+    if ( event_driven_ )
+    {
+        return Pylon::GrabLoop_ProvidedByInstantCamera;
+    }
+    return Pylon::GrabLoop_ProvidedByUser;
+}
+
+template <typename CameraTraitT>
+std::vector<std::string> PylonCameraImpl<CameraTraitT>::detectAvailableImageEncodings()
+{
+    std::vector<std::string> available_encodings;
+    GenApi::INodeMap& node_map = cam_->GetNodeMap();
+    GenApi::CEnumerationPtr img_encoding_enumeration_ptr(
+                                        node_map.GetNode("PixelFormat"));
+    GenApi::NodeList_t feature_list;
+    img_encoding_enumeration_ptr->GetEntries(feature_list);
+    std::stringstream ss;
+    ss << "Cam supports the following [GenAPI|ROS] image encodings: ";
+    for (GenApi::NodeList_t::iterator it = feature_list.begin();
+         it != feature_list.end();
+         ++it)
+    {
+        if ( GenApi::IsAvailable(*it) )
+        {
+            GenApi::CEnumEntryPtr enum_entry(*it);
             std::string encoding_gen_api = enum_entry->GetSymbolic().c_str();
             std::string encoding_ros("NO_ROS_EQUIVALENT");
             encoding_conversions::genAPI2Ros(encoding_gen_api, encoding_ros);
@@ -434,12 +1347,38 @@ std::vector<std::string> PylonCameraImpl<CameraTraitT>::detectAvailableImageEnco
     return available_encodings;
 }
 
+template <typename CameraTraitT>
+void PylonCameraImpl<CameraTraitT>::usePackedFallback(std::string& gen_api_encoding) const
+{
+    // 16 bit encodings are transmitted as 12 bit packed pixels, or as 10 bit
+    // packed pixels if the camera doesn't provide 12 bit
+    if ( packed_pixels::packedBits(gen_api_encoding) != 12 ||
+         std::find(available_image_encodings_.begin(),
+                   available_image_encodings_.end(),
+                   gen_api_encoding) != available_image_encodings_.end() )
+    {
+        return;
+    }
+    std::string fallback = gen_api_encoding;
+    fallback.replace(fallback.size() - 3, 2, "10");
+    if ( std::find(available_image_encodings_.begin(),
+                   available_image_encodings_.end(),
+                   fallback) != available_image_encodings_.end() )
+    {
+        gen_api_encoding = fallback;
+    }
+}
+
 template <typename CameraTraitT>
 bool PylonCameraImpl<CameraTraitT>::setImageEncoding(const std::string& ros_encoding)
 {
     std::string gen_api_encoding;
     bool conversion_found = encoding_conversions::ros2GenAPI(ros_encoding, gen_api_encoding);
-    if ( !conversion_found )
+    if ( conversion_found )
+    {
+        usePackedFallback(gen_api_encoding);
+    }
+    else
     {
         if ( ros_encoding.empty() )
         {
@@ -508,117 +1447,300 @@ bool PylonCameraImpl<CameraTraitT>::setImageEncoding(const std::string& ros_enco
 }
 
 template <typename CameraTraitT>
-int PylonCameraImpl<CameraTraitT>::imagePixelDepth() const
+bool PylonCameraImpl<CameraTraitT>::reconfigure(const CameraConfiguration& target,
+                                                CameraConfiguration& reached,
+                                                bool& retry)
 {
-    int pixel_depth(0);
+    const ros::WallTime start = ros::WallTime::now();
+    retry = false;
+    bool success = true;
+    bool restart = false;
+    bool was_grabbing = false;
     try
     {
-        // pylon PixelSize already contains the number of channels
-        // the size is given in bit, wheras ROS provides it in byte
-        pixel_depth = cam_->PixelSize.GetIntValue() / 8;
-    }
-    catch ( const GenICam::GenericException &e )
-    {
-        ROS_ERROR_STREAM("An exception while reading image pixel size occurred: "
-                << e.GetDescription());
-    }
-    return pixel_depth;
-}
+        // the settings of the stream are only written if they change, so
+        // that grabbing isn't restarted needlessly
+        std::string gen_api_encoding;
+        bool change_encoding = false;
+        if ( target.has_image_encoding_ )
+        {
+            const bool conversion_found = encoding_conversions::ros2GenAPI(
+                                        target.image_encoding_, gen_api_encoding);
+            if ( conversion_found )
+            {
+                usePackedFallback(gen_api_encoding);
+            }
+            if ( !GenApi::IsAvailable(cam_->PixelFormat) || !conversion_found ||
+                 std::find(available_image_encodings_.begin(),
+                           available_image_encodings_.end(),
+                           gen_api_encoding) == available_image_encodings_.end() )
+            {
+                ROS_WARN_STREAM("Camera does not support the desired image pixel "
+                    << "encoding '" << target.image_encoding_ << "'!");
+                success = false;
+            }
+            else
+            {
+                GenApi::INodeMap& node_map = cam_->GetNodeMap();
+                change_encoding = gen_api_encoding !=
+                    GenApi::CEnumerationPtr(node_map.GetNode("PixelFormat"))->ToString().c_str();
+            }
+        }
 
-template <typename CameraTraitT>
-bool PylonCameraImpl<CameraTraitT>::setBinningX(const size_t& target_binning_x,
-                                                size_t& reached_binning_x)
-{
-    try
-    {
-        if ( GenApi::IsAvailable(cam_->BinningHorizontal) )
+        // the factors are limited to the range of the camera when they are
+        // written, because some cameras don't allow binning and decimation
+        // at the same time, which limits the range of the other one
+        const bool has_binning = GenApi::IsAvailable(cam_->BinningHorizontal) &&
+                                 GenApi::IsAvailable(cam_->BinningVertical);
+        size_t binning_x = currentBinningX();
+        size_t binning_y = currentBinningY();
+        bool change_binning = false;
+        if ( target.has_binning_ )
+        {
+            if ( has_binning )
+            {
+                binning_x = std::max<size_t>(1, target.binning_x_);
+                binning_y = std::max<size_t>(1, target.binning_y_);
+                change_binning = binning_x != currentBinningX() ||
+                                 binning_y != currentBinningY();
+            }
+            else
+            {
+                ROS_WARN_STREAM("Camera does not support binning. Will keep the "
+                        << "current settings");
+            }
+        }
+
+        const bool has_decimation = GenApi::IsAvailable(cam_->DecimationHorizontal) &&
+                                    GenApi::IsAvailable(cam_->DecimationVertical);
+        size_t decimation_x = currentDecimationX();
+        size_t decimation_y = currentDecimationY();
+        bool change_decimation = false;
+        if ( target.has_decimation_ )
+        {
+            if ( has_decimation )
+            {
+                decimation_x = std::max<size_t>(1, target.decimation_x_);
+                decimation_y = std::max<size_t>(1, target.decimation_y_);
+                change_decimation = decimation_x != currentDecimationX() ||
+                                    decimation_y != currentDecimationY();
+            }
+            else
+            {
+                ROS_WARN_STREAM("Camera does not support decimation. Will keep "
+                        << "the current settings");
+            }
+        }
+
+        CameraConfiguration roi;
+        bool change_roi = false;
+        bool move_roi = false;
+        if ( target.has_roi_ )
+        {
+            if ( change_binning || change_decimation )
+            {
+                // the maximum size depends on the binning and decimation
+                change_roi = true;
+            }
+            else
+            {
+                resolveROI(target, roi);
+                const bool resize =
+                    static_cast<int64_t>(roi.roi_width_) != cam_->Width.GetValue() ||
+                    static_cast<int64_t>(roi.roi_height_) != cam_->Height.GetValue();
+                const bool move =
+                    static_cast<int64_t>(roi.roi_offset_x_) != cam_->OffsetX.GetValue() ||
+                    static_cast<int64_t>(roi.roi_offset_y_) != cam_->OffsetY.GetValue();
+                // moving the window keeps the payload size, hence some
+                // cameras allow to change the offsets while grabbing
+                move_roi = move && !resize && !change_encoding &&
+                           GenApi::IsWritable(cam_->OffsetX) &&
+                           GenApi::IsWritable(cam_->OffsetY);
+                change_roi = ( resize || move ) && !move_roi;
+            }
+        }
+
+        restart = change_encoding || change_binning || change_decimation || change_roi;
+        if ( restart )
         {
+            was_grabbing = cam_->IsGrabbing();
             cam_->StopGrabbing();
-            size_t binning_x_to_set = target_binning_x;
-            if ( binning_x_to_set < cam_->BinningHorizontal.GetMin() )
+            if ( change_encoding )
+            {
+                GenApi::INodeMap& node_map = cam_->GetNodeMap();
+                GenApi::CEnumerationPtr(node_map.GetNode("PixelFormat"))->FromString(
+                                                    gen_api_encoding.c_str());
+            }
+            if ( change_binning || change_decimation )
             {
-                ROS_WARN_STREAM("Desired horizontal binning_x factor("
-                        << binning_x_to_set << ") unreachable! Setting to lower "
-                        << "limit: " << cam_->BinningHorizontal.GetMin());
-                binning_x_to_set = cam_->BinningHorizontal.GetMin();
+                writeDownsampling(binning_x, binning_y, decimation_x, decimation_y);
+                if ( ( change_binning && ( binning_x != currentBinningX() ||
+                                           binning_y != currentBinningY() ) ) ||
+                     ( change_decimation && ( decimation_x != currentDecimationX() ||
+                                              decimation_y != currentDecimationY() ) ) )
+                {
+                    ROS_WARN_STREAM("Desired binning (" << binning_x << ", "
+                        << binning_y << ") and decimation (" << decimation_x
+                        << ", " << decimation_y << ") unreachable! Set to ("
+                        << currentBinningX() << ", " << currentBinningY()
+                        << ") and (" << currentDecimationX() << ", "
+                        << currentDecimationY() << ")");
+                }
             }
-            else if ( binning_x_to_set > cam_->BinningHorizontal.GetMax() )
+            if ( change_roi )
             {
-                ROS_WARN_STREAM("Desired horizontal binning_x factor("
-                        << binning_x_to_set << ") unreachable! Setting to upper "
-                        << "limit: " << cam_->BinningHorizontal.GetMax());
-                binning_x_to_set = cam_->BinningHorizontal.GetMax();
+                if ( change_binning || change_decimation )
+                {
+                    resolveROI(target, roi);
+                }
+                // the offsets limit the maximum size, hence they are reset
+                // before the size is increased
+                cam_->OffsetX.SetValue(0);
+                cam_->OffsetY.SetValue(0);
+                cam_->Width.SetValue(roi.roi_width_);
+                cam_->Height.SetValue(roi.roi_height_);
+                cam_->OffsetX.SetValue(roi.roi_offset_x_);
+                cam_->OffsetY.SetValue(roi.roi_offset_y_);
             }
-            cam_->BinningHorizontal.SetValue(binning_x_to_set);
-            reached_binning_x = currentBinningX();
-            cam_->StartGrabbing();
-            img_cols_ = static_cast<size_t>(cam_->Width.GetValue());
-            img_size_byte_ =  img_cols_ * img_rows_ * imagePixelDepth();
+            if ( was_grabbing )
+            {
+                cam_->StartGrabbing(grabStrategy(), grabLoop());
+                triggers_in_flight_ = 0;
+            }
+            updateState();
         }
-        else
+        if ( move_roi )
         {
-            ROS_WARN_STREAM("Camera does not support binning. Will keep the "
-                    << "current settings");
-            reached_binning_x = currentBinningX();
+            cam_->OffsetX.SetValue(roi.roi_offset_x_);
+            cam_->OffsetY.SetValue(roi.roi_offset_y_);
         }
     }
     catch ( const GenICam::GenericException &e )
     {
-        ROS_ERROR_STREAM("An exception while setting target horizontal "
-                << "binning_x factor to " << target_binning_x << " occurred: "
-                << e.GetDescription());
-        return false;
+        ROS_ERROR_STREAM("An exception while reconfiguring the camera "
+                << "occurred: " << e.GetDescription());
+        success = false;
+        // access and timeout errors occur e.g. while the camera is still
+        // busy, whereas invalid values would fail again
+        retry = !cam_->IsCameraDeviceRemoved() &&
+                ( dynamic_cast<const GenICam::AccessException*>(&e) ||
+                  dynamic_cast<const GenICam::TimeoutException*>(&e) );
+        try
+        {
+            if ( was_grabbing && !cam_->IsGrabbing() )
+            {
+                cam_->StartGrabbing(grabStrategy(), grabLoop());
+                triggers_in_flight_ = 0;
+            }
+            updateState();
+        }
+        catch ( const GenICam::GenericException &e )
+        {
+            ROS_ERROR_STREAM("Couldn't restart grabbing after the failed "
+                    << "reconfiguration: " << e.GetDescription());
+        }
     }
-    return true;
+
+    // exposure and gain don't affect the stream
+    if ( target.has_exposure_ )
+    {
+        float reached_exposure;
+        success = setExposure(target.exposure_, reached_exposure) && success;
+    }
+    if ( target.has_gain_ )
+    {
+        float reached_gain;
+        success = setGain(target.gain_, reached_gain) && success;
+    }
+
+    reached.has_binning_ = true;
+    reached.binning_x_ = currentBinningX();
+    reached.binning_y_ = currentBinningY();
+    reached.has_decimation_ = true;
+    reached.decimation_x_ = currentDecimationX();
+    reached.decimation_y_ = currentDecimationY();
+    reached.has_roi_ = currentROI(reached);
+    reached.has_image_encoding_ = true;
+    reached.image_encoding_ = currentROSEncoding();
+    reached.has_exposure_ = true;
+    reached.exposure_ = currentExposure();
+    reached.has_gain_ = true;
+    reached.gain_ = currentGain();
+
+    ROS_INFO_STREAM("Reconfigured the camera in "
+            << 1e3 * (ros::WallTime::now() - start).toSec() << " ms "
+            << (restart ? "with a single restart of grabbing" : "while grabbing"));
+    return success;
 }
 
 template <typename CameraTraitT>
-bool PylonCameraImpl<CameraTraitT>::setBinningY(const size_t& target_binning_y,
-                                                size_t& reached_binning_y)
+bool PylonCameraImpl<CameraTraitT>::currentROI(CameraConfiguration& roi)
 {
     try
     {
-        if ( GenApi::IsAvailable(cam_->BinningVertical) )
-        {
-            cam_->StopGrabbing();
-            size_t binning_y_to_set = target_binning_y;
-            if ( binning_y_to_set < cam_->BinningVertical.GetMin() )
-            {
-                ROS_WARN_STREAM("Desired vertical binning_y factor("
-                        << binning_y_to_set << ") unreachable! Setting to lower "
-                        << "limit: " << cam_->BinningVertical.GetMin());
-                binning_y_to_set = cam_->BinningVertical.GetMin();
-            }
-            else if ( binning_y_to_set > cam_->BinningVertical.GetMax() )
-            {
-                ROS_WARN_STREAM("Desired vertical binning_y factor("
-                        << binning_y_to_set << ") unreachable! Setting to upper "
-                        << "limit: " << cam_->BinningVertical.GetMax());
-                binning_y_to_set = cam_->BinningVertical.GetMax();
-            }
-            cam_->BinningVertical.SetValue(binning_y_to_set);
-            reached_binning_y = currentBinningY();
-            cam_->StartGrabbing();
-            img_rows_ = static_cast<size_t>(cam_->Height.GetValue());
-            img_size_byte_ =  img_cols_ * img_rows_ * imagePixelDepth();
-        }
-        else
-        {
-            ROS_WARN_STREAM("Camera does not support binning. Will keep the "
-                    << "current settings");
-            reached_binning_y = currentBinningY();
-        }
+        roi.roi_offset_x_ = static_cast<size_t>(cam_->OffsetX.GetValue());
+        roi.roi_offset_y_ = static_cast<size_t>(cam_->OffsetY.GetValue());
+        roi.roi_width_ = static_cast<size_t>(cam_->Width.GetValue());
+        roi.roi_height_ = static_cast<size_t>(cam_->Height.GetValue());
+        roi.roi_width_max_ = static_cast<size_t>(cam_->WidthMax.GetValue());
+        roi.roi_height_max_ = static_cast<size_t>(cam_->HeightMax.GetValue());
     }
     catch ( const GenICam::GenericException &e )
     {
-        ROS_ERROR_STREAM("An exception while setting target vertical "
-                << "binning_y factor to " << target_binning_y << " occurred: "
-                << e.GetDescription());
+        ROS_ERROR_STREAM("An exception while reading the region of interest "
+                << "occurred: " << e.GetDescription());
         return false;
     }
     return true;
 }
 
+template <typename CameraTraitT>
+void PylonCameraImpl<CameraTraitT>::resolveROI(const CameraConfiguration& target,
+                                               CameraConfiguration& roi)
+{
+    const int64_t width_max = cam_->WidthMax.GetValue();
+    const int64_t height_max = cam_->HeightMax.GetValue();
+    const int64_t width_min = cam_->Width.GetMin();
+    const int64_t height_min = cam_->Height.GetMin();
+    const int64_t width_inc = std::max<int64_t>(1, cam_->Width.GetInc());
+    const int64_t height_inc = std::max<int64_t>(1, cam_->Height.GetInc());
+    const int64_t offset_x_inc = std::max<int64_t>(1, cam_->OffsetX.GetInc());
+    const int64_t offset_y_inc = std::max<int64_t>(1, cam_->OffsetY.GetInc());
+
+    int64_t width = target.roi_width_ == 0 ? width_max :
+                    std::min<int64_t>(target.roi_width_, width_max);
+    int64_t height = target.roi_height_ == 0 ? height_max :
+                     std::min<int64_t>(target.roi_height_, height_max);
+    width = std::max(width_min, width_min + (width - width_min) / width_inc * width_inc);
+    height = std::max(height_min, height_min + (height - height_min) / height_inc * height_inc);
+
+    int64_t offset_x = std::min<int64_t>(target.roi_offset_x_, width_max - width);
+    int64_t offset_y = std::min<int64_t>(target.roi_offset_y_, height_max - height);
+    offset_x -= offset_x % offset_x_inc;
+    offset_y -= offset_y % offset_y_inc;
+
+    if ( ( target.roi_width_ != 0 && width != static_cast<int64_t>(target.roi_width_) ) ||
+         ( target.roi_height_ != 0 && height != static_cast<int64_t>(target.roi_height_) ) ||
+         offset_x != static_cast<int64_t>(target.roi_offset_x_) ||
+         offset_y != static_cast<int64_t>(target.roi_offset_y_) )
+    {
+        ROS_WARN_STREAM("Desired region of interest unreachable! Setting to "
+                << width << "x" << height << "+" << offset_x << "+" << offset_y);
+    }
+
+    roi.has_roi_ = true;
+    roi.roi_offset_x_ = static_cast<size_t>(offset_x);
+    roi.roi_offset_y_ = static_cast<size_t>(offset_y);
+    roi.roi_width_ = static_cast<size_t>(width);
+    roi.roi_height_ = static_cast<size_t>(height);
+}
+
+template <typename CameraTraitT>
+int PylonCameraImpl<CameraTraitT>::imagePixelDepth() const
+{
+    return state()->pixel_depth_;
+}
+
 template <typename CameraTraitT>
 bool PylonCameraImpl<CameraTraitT>::setExposure(const float& target_exposure,
                                                 float& reached_exposure)
@@ -627,22 +1749,24 @@ bool PylonCameraImpl<CameraTraitT>::setExposure(const float& target_exposure,
     {
         cam_->ExposureAuto.SetValue(ExposureAutoEnums::ExposureAuto_Off);
 
+        const CameraStateSnapshotConstPtr current_state = state();
         float exposure_to_set = target_exposure;
-        if ( exposure_to_set < exposureTime().GetMin() )
+        if ( exposure_to_set < current_state->exposure_min_ )
         {
             ROS_WARN_STREAM("Desired exposure (" << exposure_to_set << ") "
                 << "time unreachable! Setting to lower limit: "
-                << exposureTime().GetMin());
-            exposure_to_set = exposureTime().GetMin();
+                << current_state->exposure_min_);
+            exposure_to_set = current_state->exposure_min_;
         }
-        else if ( exposure_to_set > exposureTime().GetMax() )
+        else if ( exposure_to_set > current_state->exposure_max_ )
         {
             ROS_WARN_STREAM("Desired exposure (" << exposure_to_set << ") "
                 << "time unreachable! Setting to upper limit: "
-                << exposureTime().GetMax());
-            exposure_to_set = exposureTime().GetMax();
+                << current_state->exposure_max_);
+            exposure_to_set = current_state->exposure_max_;
         }
         exposureTime().SetValue(exposure_to_set);
+        markQueuedFramesStale();
         reached_exposure = currentExposure();
 
         if ( std::fabs(reached_exposure - exposure_to_set) > exposureStep() )
@@ -685,9 +1809,11 @@ bool PylonCameraImpl<CameraTraitT>::setGain(const float& target_gain,
             truncated_gain = 1.0;
         }
 
-        float gain_to_set = gain().GetMin() +
-                            truncated_gain * (gain().GetMax() - gain().GetMin());
+        const CameraStateSnapshotConstPtr current_state = state();
+        float gain_to_set = current_state->gain_min_ +
+                            truncated_gain * (current_state->gain_max_ - current_state->gain_min_);
         gain().SetValue(gain_to_set);
+        markQueuedFramesStale();
         reached_gain = currentGain();
     }
     catch ( const GenICam::GenericException &e )
@@ -806,6 +1932,8 @@ bool PylonCameraImpl<CameraTraitT>::setBrightness(const int& target_brightness,
                 is_binary_exposure_search_running_ = true;
             }
         }
+        // the pylon auto function only adjusts frames exposed from now on
+        markQueuedFramesStale();
     }
     catch (const GenICam::GenericException &e)
     {
@@ -869,8 +1997,8 @@ bool PylonCameraImpl<CameraTraitT>::setExtendedBrightness(const int& target_brig
     // failure if we reached min or max exposure limit
     // but we return in the next cycle because maybe the current setting leads
     // to the target brightness
-    if ( reached_exposure == exposureTime().GetMin() ||
-         reached_exposure == exposureTime().GetMax() )
+    if ( reached_exposure == state()->exposure_min_ ||
+         reached_exposure == state()->exposure_max_ )
     {
         binary_exp_search_->limitReached(true);
     }
@@ -910,7 +2038,7 @@ bool PylonCameraImpl<CameraTraitT>::setShutterMode(const SHUTTER_MODE &shutter_m
 template <typename CameraTraitT>
 float PylonCameraImpl<CameraTraitT>::exposureStep()
 {
-    return static_cast<float>(exposureTime().GetMin());
+    return static_cast<float>(state()->exposure_min_);
 }
 
 template <typename CameraTraitT>
@@ -0,0 +1,128 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#ifndef PYLON_CAMERA_INTERNAL_CAMEMU_H_
+#define PYLON_CAMERA_INTERNAL_CAMEMU_H_
+
+#include <string>
+#include <vector>
+
+#include <pylon_camera/internal/impl/pylon_camera_usb.hpp>
+
+namespace pylon_camera
+{
+
+/**
+ * The USB instant camera only accepts devices of the 'BaslerUsb' class. The
+ * emulator follows the feature names of the USB cameras, hence its device is
+ * attached to the USB instant camera without that check. The parameters it
+ * lacks are not available.
+ */
+class CamEmuInstantCamera : public Pylon::CBaslerUsbInstantCamera
+{
+public:
+    explicit CamEmuInstantCamera(Pylon::IPylonDevice* device)
+    {
+        Attach(device);
+    }
+
+    virtual void Attach(Pylon::IPylonDevice* device,
+                        Pylon::ECleanupDelete cleanup_procedure = Pylon::Cleanup_Delete)
+    {
+        Pylon::CInstantCamera::Attach(device, cleanup_procedure);
+    }
+};
+
+class PylonCamEmuCamera : public PylonUSBCamera
+{
+public:
+    explicit PylonCamEmuCamera(Pylon::IPylonDevice* device);
+    virtual ~PylonCamEmuCamera();
+
+    virtual bool applyCamSpecificStartupSettings(const PylonCameraParameter& params);
+    virtual bool setUserOutput(int output_id, bool value);
+    virtual std::string typeName() const;
+
+protected:
+    virtual bool setupSequencer(const std::vector<float>& exposure_times,
+                                std::vector<float>& exposure_times_set);
+};
+
+PylonCamEmuCamera::PylonCamEmuCamera(Pylon::IPylonDevice* device) :
+    PylonUSBCamera(new CamEmuInstantCamera(device))
+{}
+
+PylonCamEmuCamera::~PylonCamEmuCamera()
+{}
+
+bool PylonCamEmuCamera::applyCamSpecificStartupSettings(const PylonCameraParameter& parameters)
+{
+    // the emulator has neither user sets nor auto functions, hence only the
+    // acquisition mode is set up
+    try
+    {
+        if ( !setupAcquisitionMode(parameters) )
+        {
+            return false;
+        }
+        ROS_INFO_STREAM("Cam has exposure time range: ["
+                << cam_->ExposureTime.GetMin() << " - "
+                << cam_->ExposureTime.GetMax()
+                << "] measured in microseconds.");
+    }
+    catch ( const GenICam::GenericException &e )
+    {
+        ROS_ERROR_STREAM("Error applying cam specific startup setting for the "
+                << "camera emulator: " << e.GetDescription());
+        return false;
+    }
+    return true;
+}
+
+bool PylonCamEmuCamera::setUserOutput(int output_id, bool value)
+{
+    ROS_ERROR("The camera emulator has no digital output.");
+    return false;
+}
+
+bool PylonCamEmuCamera::setupSequencer(const std::vector<float>& exposure_times,
+                                       std::vector<float>& exposure_times_set)
+{
+    ROS_ERROR("The camera emulator has no sequencer.");
+    return false;
+}
+
+std::string PylonCamEmuCamera::typeName() const
+{
+    return "CamEmu";
+}
+
+}  // namespace pylon_camera
+
+#endif  // PYLON_CAMERA_INTERNAL_CAMEMU_H_
@@ -51,11 +51,17 @@ public:
 protected:
     virtual bool setupSequencer(const std::vector<float>& exposure_times,
                                 std::vector<float>& exposure_times_set);
-    virtual bool grab(Pylon::CGrabResultPtr& grab_result);
+    virtual bool retrieveResult(Pylon::CGrabResultPtr& grab_result);
+    virtual bool fillTriggerPipeline(const int& timeout);
+
+    // time the last software trigger has been issued, used for pacing the
+    // triggers in the pipelined software-trigger mode
+    ros::WallTime last_trigger_time_;
 };
 
 PylonDARTCamera::PylonDARTCamera(Pylon::IPylonDevice* device) :
-    PylonUSBCamera(device)
+    PylonUSBCamera(device),
+    last_trigger_time_()
 {}
 
 PylonDARTCamera::~PylonDARTCamera()
@@ -83,14 +89,35 @@ bool PylonDARTCamera::setupSequencer(const std::vector<float>& exposure_times,
     return false;
 }
 
-bool PylonDARTCamera::grab(Pylon::CGrabResultPtr& grab_result)
+bool PylonDARTCamera::retrieveResult(Pylon::CGrabResultPtr& grab_result)
 {
+    if ( event_driven_ )
+    {
+        // the grab loop thread retrieves the results
+        return waitForImageEvent(grab_result);
+    }
+
     try
     {
-        // /!\ The dart camera device does not support
-        // 'waitForFrameTriggerReady'
-        cam_->ExecuteSoftwareTrigger();
+        if ( acquisition_mode_ == AM_SOFTWARE_TRIGGER )
+        {
+            ScopedLatency latency(statistics_, LS_TRIGGER_WAIT);
+            // /!\ The dart camera device does not support
+            // 'waitForFrameTriggerReady'
+            cam_->ExecuteSoftwareTrigger();
+        }
+        else if ( acquisition_mode_ == AM_PIPELINED_SOFTWARE_TRIGGER )
+        {
+            ScopedLatency latency(statistics_, LS_TRIGGER_WAIT);
+            if ( !fillTriggerPipeline(0) )
+            {
+                return false;
+            }
+            // counts as retrieved even if the trigger got lost
+            --triggers_in_flight_;
+        }
 
+        ScopedLatency latency(statistics_, LS_RETRIEVE);
         cam_->RetrieveResult(grab_timeout_, grab_result,
                              Pylon::TimeoutHandling_ThrowException);
     }
@@ -123,6 +150,56 @@ bool PylonDARTCamera::grab(Pylon::CGrabResultPtr& grab_result)
     return true;
 }
 
+bool PylonDARTCamera::fillTriggerPipeline(const int& timeout)
+{
+    // The dart camera does not support 'waitForFrameTriggerReady' and
+    // ignores triggers while it is not ready. Hence the triggers are paced
+    // by the max frame rate the camera reports for the current settings,
+    // plus a small margin.
+    float max_frame_rate = 0.0;
+    try
+    {
+        max_frame_rate = maxPossibleFramerate();
+    }
+    catch ( const GenICam::GenericException &e )
+    {
+        ROS_WARN_STREAM_ONCE("Can't read the max frame rate of the dart "
+                << "camera, hence the triggers can't be pipelined: "
+                << e.GetDescription());
+    }
+    catch ( const std::runtime_error& e )
+    {
+        ROS_WARN_STREAM_ONCE("Can't read the max frame rate of the dart "
+                << "camera, hence the triggers can't be pipelined: " << e.what());
+    }
+    if ( max_frame_rate <= 0.0 )
+    {
+        // without pacing information only one frame can be in flight
+        if ( triggers_in_flight_ == 0 )
+        {
+            cam_->ExecuteSoftwareTrigger();
+            last_trigger_time_ = ros::WallTime::now();
+            ++triggers_in_flight_;
+        }
+        return true;
+    }
+
+    const ros::WallDuration min_trigger_interval(1.05 / max_frame_rate);
+    while ( triggers_in_flight_ < max_triggers_in_flight_ )
+    {
+        const ros::WallDuration since_last_trigger =
+                                ros::WallTime::now() - last_trigger_time_;
+        if ( since_last_trigger < min_trigger_interval )
+        {
+            (min_trigger_interval - since_last_trigger).sleep();
+        }
+        cam_->ExecuteSoftwareTrigger();
+        last_trigger_time_ = ros::WallTime::now();
+        ++triggers_in_flight_;
+    }
+    return true;
+}
+
 std::string PylonDARTCamera::typeName() const
 {
     return "DART";
@@ -51,6 +51,9 @@ struct GigECameraTrait
     typedef GenApi::IInteger GainType;
     typedef int64_t AutoTargetBrightnessValueType;
     typedef Basler_GigECameraParams::ShutterModeEnums ShutterModeEnums;
+    typedef Basler_GigECameraParams::TriggerSelectorEnums TriggerSelectorEnums;
+    typedef Basler_GigECameraParams::TriggerModeEnums TriggerModeEnums;
+    typedef Basler_GigECameraParams::TriggerSourceEnums TriggerSourceEnums;
     typedef Basler_GigECamera::UserOutputSelectorEnums UserOutputSelectorEnums;
     typedef Basler_GigECamera::LineSelectorEnums LineSelectorEnums;
     typedef Basler_GigECamera::LineModeEnums LineModeEnums;
@@ -74,8 +77,10 @@ bool PylonGigECamera::applyCamSpecificStartupSettings(const PylonCameraParameter
         cam_->UserSetSelector.SetValue(Basler_GigECameraParams::UserSetSelector_Default);
         cam_->UserSetLoad.Execute();
         // UserSetSelector_Default overrides Software Trigger Mode !!
-        cam_->TriggerSource.SetValue(Basler_GigECameraParams::TriggerSource_Software);
-        cam_->TriggerMode.SetValue(Basler_GigECameraParams::TriggerMode_On);
+        if ( !setupAcquisitionMode(parameters) )
+        {
+            return false;
+        }
 
         if (parameters.auto_flash_)
         {
@@ -301,6 +306,7 @@ bool PylonGigECamera::setGamma(const float& target_gamma, float& reached_gamma)
                                   << gamma_to_set);
         }
         gamma().SetValue(gamma_to_set);
+        markQueuedFramesStale();
         reached_gamma = currentGamma();
     }
     catch ( const GenICam::GenericException &e )
@@ -390,6 +396,129 @@ GigECameraTrait::AutoTargetBrightnessType& PylonGigECamera::autoTargetBrightness
     }
 }
 
+template <>
+GenApi::IFloat& PylonGigECamera::acquisitionFrameRate()
+{
+    if ( GenApi::IsAvailable(cam_->AcquisitionFrameRateAbs) )
+    {
+        return cam_->AcquisitionFrameRateAbs;
+    }
+    else
+    {
+        throw std::runtime_error("Error while accessing AcquisitionFrameRateAbs in PylonGigECamera");
+    }
+}
+
+template <>
+GenApi::ICommand& PylonGigECamera::timestampLatch()
+{
+    if ( GenApi::IsAvailable(cam_->GevTimestampControlLatch) )
+    {
+        return cam_->GevTimestampControlLatch;
+    }
+    else
+    {
+        throw std::runtime_error("Error while accessing GevTimestampControlLatch in PylonGigECamera");
+    }
+}
+
+template <>
+GenApi::IInteger& PylonGigECamera::timestampLatchValue()
+{
+    if ( GenApi::IsAvailable(cam_->GevTimestampValue) )
+    {
+        return cam_->GevTimestampValue;
+    }
+    else
+    {
+        throw std::runtime_error("Error while accessing GevTimestampValue in PylonGigECamera");
+    }
+}
+
+template <>
+double PylonGigECamera::timestampTickFrequency()
+{
+    if ( GenApi::IsAvailable(cam_->GevTimestampTickFrequency) )
+    {
+        return static_cast<double>(cam_->GevTimestampTickFrequency.GetValue());
+    }
+    else
+    {
+        throw std::runtime_error("Error while accessing GevTimestampTickFrequency in PylonGigECamera");
+    }
+}
+
+template <>
+bool PylonGigECamera::setupChunkData(const bool& enable)
+{
+    if ( !GenApi::IsWritable(cam_->ChunkModeActive) )
+    {
+        if ( enable )
+        {
+            ROS_INFO_STREAM("Camera does not support chunk data, the frame "
+                    << "metadata is limited to the timestamps.");
+        }
+        return false;
+    }
+    cam_->ChunkModeActive.SetValue(enable);
+    if ( !enable )
+    {
+        return false;
+    }
+
+    const Basler_GigECameraParams::ChunkSelectorEnums selectors[] = {
+            Basler_GigECameraParams::ChunkSelector_ExposureTime,
+            Basler_GigECameraParams::ChunkSelector_GainAll,
+            Basler_GigECameraParams::ChunkSelector_Framecounter,
+            Basler_GigECameraParams::ChunkSelector_Timestamp,
+            Basler_GigECameraParams::ChunkSelector_PayloadCRC16 };
+    for ( const Basler_GigECameraParams::ChunkSelectorEnums& selector : selectors )
+    {
+        if ( GenApi::IsAvailable(cam_->ChunkSelector.GetEntry(selector)) )
+        {
+            cam_->ChunkSelector.SetValue(selector);
+            cam_->ChunkEnable.SetValue(true);
+        }
+    }
+    chunk_gain_min_ = static_cast<double>(gain().GetMin());
+    chunk_gain_max_ = static_cast<double>(gain().GetMax());
+    return true;
+}
+
+template <>
+void PylonGigECamera::readChunkData(const Pylon::CGrabResultPtr& grab_result,
+                                    FrameMetadata& metadata) const
+{
+    Pylon::CBaslerGigEGrabResultPtr result(grab_result);
+    if ( !result.IsValid() )
+    {
+        return;
+    }
+    if ( GenApi::IsReadable(result->ChunkExposureTime) )
+    {
+        metadata.has_exposure_time_ = true;
+        metadata.exposure_time_ = static_cast<float>(
+                                        result->ChunkExposureTime.GetValue());
+    }
+    if ( GenApi::IsReadable(result->ChunkGainAll) )
+    {
+        metadata.has_gain_ = true;
+        metadata.gain_ = normalizedGain(static_cast<double>(
+                                        result->ChunkGainAll.GetValue()));
+    }
+    if ( GenApi::IsReadable(result->ChunkFramecounter) )
+    {
+        metadata.has_frame_counter_ = true;
+        metadata.frame_counter_ = static_cast<uint64_t>(
+                                        result->ChunkFramecounter.GetValue());
+    }
+    if ( GenApi::IsReadable(result->ChunkTimestamp) )
+    {
+        metadata.camera_ticks_ = static_cast<uint64_t>(
+                                        result->ChunkTimestamp.GetValue());
+    }
+}
+
 template <>
 std::string PylonGigECamera::typeName() const
 {
@@ -51,6 +51,9 @@ struct USBCameraTrait
     typedef GenApi::IFloat GainType;
     typedef double AutoTargetBrightnessValueType;
     typedef Basler_UsbCameraParams::ShutterModeEnums ShutterModeEnums;
+    typedef Basler_UsbCameraParams::TriggerSelectorEnums TriggerSelectorEnums;
+    typedef Basler_UsbCameraParams::TriggerModeEnums TriggerModeEnums;
+    typedef Basler_UsbCameraParams::TriggerSourceEnums TriggerSourceEnums;
     typedef Basler_UsbCameraParams::UserOutputSelectorEnums UserOutputSelectorEnums;
 
     static inline AutoTargetBrightnessValueType convertBrightness(const int& value)
@@ -71,8 +74,10 @@ bool PylonUSBCamera::applyCamSpecificStartupSettings(const PylonCameraParameter&
         cam_->UserSetSelector.SetValue(Basler_UsbCameraParams::UserSetSelector_Default);
         cam_->UserSetLoad.Execute();
         // UserSetSelector_Default overrides Software Trigger Mode !!
-        cam_->TriggerSource.SetValue(Basler_UsbCameraParams::TriggerSource_Software);
-        cam_->TriggerMode.SetValue(Basler_UsbCameraParams::TriggerMode_On);
+        if ( !setupAcquisitionMode(parameters) )
+        {
+            return false;
+        }
 
          /* Thresholds for the AutoExposure Functions:
           *  - lower limit can be used to get rid of changing light conditions
@@ -244,6 +249,7 @@ bool PylonUSBCamera::setGamma(const float& target_gamma, float& reached_gamma)
                                   << gamma_to_set);
         }
         gamma().SetValue(gamma_to_set);
+        markQueuedFramesStale();
         reached_gamma = currentGamma();
     }
     catch ( const GenICam::GenericException &e )
@@ -333,6 +339,129 @@ USBCameraTrait::AutoTargetBrightnessType& PylonUSBCamera::autoTargetBrightness()
     }
 }
 
+template <>
+GenApi::IFloat& PylonUSBCamera::acquisitionFrameRate()
+{
+    if ( GenApi::IsAvailable(cam_->AcquisitionFrameRate) )
+    {
+        return cam_->AcquisitionFrameRate;
+    }
+    else
+    {
+        throw std::runtime_error("Error while accessing AcquisitionFrameRate in PylonUSBCamera");
+    }
+}
+
+template <>
+GenApi::ICommand& PylonUSBCamera::timestampLatch()
+{
+    if ( GenApi::IsAvailable(cam_->TimestampLatch) )
+    {
+        return cam_->TimestampLatch;
+    }
+    else
+    {
+        throw std::runtime_error("Error while accessing TimestampLatch in PylonUSBCamera");
+    }
+}
+
+template <>
+GenApi::IInteger& PylonUSBCamera::timestampLatchValue()
+{
+    if ( GenApi::IsAvailable(cam_->TimestampLatchValue) )
+    {
+        return cam_->TimestampLatchValue;
+    }
+    else
+    {
+        throw std::runtime_error("Error while accessing TimestampLatchValue in PylonUSBCamera");
+    }
+}
+
+template <>
+double PylonUSBCamera::timestampTickFrequency()
+{
+    // the timestamps of USB cameras are given in nanoseconds
+    return 1e9;
+}
+
+template <>
+bool PylonUSBCamera::setupChunkData(const bool& enable)
+{
+    if ( !GenApi::IsWritable(cam_->ChunkModeActive) )
+    {
+        if ( enable )
+        {
+            ROS_INFO_STREAM("Camera does not support chunk data, the frame "
+                    << "metadata is limited to the timestamps.");
+        }
+        return false;
+    }
+    cam_->ChunkModeActive.SetValue(enable);
+    if ( !enable )
+    {
+        return false;
+    }
+
+    const Basler_UsbCameraParams::ChunkSelectorEnums selectors[] = {
+            Basler_UsbCameraParams::ChunkSelector_ExposureTime,
+            Basler_UsbCameraParams::ChunkSelector_Gain,
+            Basler_UsbCameraParams::ChunkSelector_CounterValue,
+            Basler_UsbCameraParams::ChunkSelector_Timestamp,
+            Basler_UsbCameraParams::ChunkSelector_PayloadCRC16 };
+    for ( const Basler_UsbCameraParams::ChunkSelectorEnums& selector : selectors )
+    {
+        if ( GenApi::IsAvailable(cam_->ChunkSelector.GetEntry(selector)) )
+        {
+            cam_->ChunkSelector.SetValue(selector);
+            cam_->ChunkEnable.SetValue(true);
+        }
+    }
+    // USB cameras have no dedicated frame counter chunk: counter 2 counts
+    // the frame start events, i.e. the acquired frames
+    if ( GenApi::IsWritable(cam_->ChunkCounterSelector) )
+    {
+        cam_->ChunkCounterSelector.SetValue(
+                            Basler_UsbCameraParams::ChunkCounterSelector_Counter2);
+    }
+    chunk_gain_min_ = gain().GetMin();
+    chunk_gain_max_ = gain().GetMax();
+    return true;
+}
+
+template <>
+void PylonUSBCamera::readChunkData(const Pylon::CGrabResultPtr& grab_result,
+                                   FrameMetadata& metadata) const
+{
+    Pylon::CBaslerUsbGrabResultPtr result(grab_result);
+    if ( !result.IsValid() )
+    {
+        return;
+    }
+    if ( GenApi::IsReadable(result->ChunkExposureTime) )
+    {
+        metadata.has_exposure_time_ = true;
+        metadata.exposure_time_ = static_cast<float>(
+                                        result->ChunkExposureTime.GetValue());
+    }
+    if ( GenApi::IsReadable(result->ChunkGain) )
+    {
+        metadata.has_gain_ = true;
+        metadata.gain_ = normalizedGain(result->ChunkGain.GetValue());
+    }
+    if ( GenApi::IsReadable(result->ChunkCounterValue) )
+    {
+        metadata.has_frame_counter_ = true;
+        metadata.frame_counter_ = static_cast<uint64_t>(
+                                        result->ChunkCounterValue.GetValue());
+    }
+    if ( GenApi::IsReadable(result->ChunkTimestamp) )
+    {
+        metadata.camera_ticks_ = static_cast<uint64_t>(
+                                        result->ChunkTimestamp.GetValue());
+    }
+}
+
 template <>
 std::string PylonUSBCamera::typeName() const
 {
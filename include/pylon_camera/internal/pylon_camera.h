@@ -35,11 +35,17 @@
 
 #include <pylon/PylonIncludes.h>
 #include <GenApi/IEnumEntry.h>
+#include <boost/bind.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
 #include <string>
 #include <vector>
 
 #include <pylon_camera/pylon_camera_parameter.h>
 #include <pylon_camera/pylon_camera.h>
+#include <pylon_camera/internal/image_buffer_factory.h>
+#include <pylon_camera/internal/image_event_handler.h>
+#include <pylon_camera/internal/device_removal_handler.h>
 
 namespace pylon_camera
 {
@@ -52,32 +58,46 @@ public:
 
     virtual ~PylonCameraImpl();
 
-    virtual bool registerCameraConfiguration();
+    virtual bool registerCameraConfiguration(const ACQUISITION_MODE& acquisition_mode);
 
     virtual bool openCamera();
 
     virtual bool isCamRemoved();
 
+    virtual void setRemovalCallback(const RemovalCallback& callback);
+
+    virtual bool reconnect();
+
     virtual bool setupSequencer(const std::vector<float>& exposure_times);
 
     virtual bool applyCamSpecificStartupSettings(const PylonCameraParameter& parameters);
 
+    virtual bool saveFeatureSnapshot(const std::string& file_name);
+
+    virtual bool loadFeatureSnapshot(const std::string& file_name);
+
     virtual bool startGrabbing(const PylonCameraParameter& parameters);
 
-    virtual bool grab(std::vector<uint8_t>& image);
+    virtual bool grab(std::vector<uint8_t>& image, FrameMetadata& metadata);
 
     virtual bool grab(uint8_t* image);
 
-    virtual bool setShutterMode(const pylon_camera::SHUTTER_MODE& mode);
+    virtual bool grab(sensor_msgs::ImagePtr& image, FrameMetadata& metadata);
+
+    virtual bool syncClock();
 
-    virtual bool setBinningX(const size_t& target_binning_x,
-                             size_t& reached_binning_x);
+    virtual void setImageCallback(const ImageCallback& callback);
 
-    virtual bool setBinningY(const size_t& target_binning_y,
-                             size_t& reached_binning_y);
+    virtual bool setShutterMode(const pylon_camera::SHUTTER_MODE& mode);
 
     virtual bool setImageEncoding(const std::string& target_ros_encoding);
 
+    virtual bool reconfigure(const CameraConfiguration& target,
+                             CameraConfiguration& reached,
+                             bool& retry);
+
+    virtual bool currentROI(CameraConfiguration& roi);
+
     virtual bool setExposure(const float& target_exposure, float& reached_exposure);
 
     virtual bool setGain(const float& target_gain, float& reached_gain);
@@ -97,6 +117,15 @@ public:
 
     virtual size_t currentBinningY();
 
+    virtual size_t currentDecimationX();
+
+    virtual size_t currentDecimationY();
+
+    virtual void resolveDownsampling(const size_t& factor_x,
+                                     const size_t& factor_y,
+                                     const bool& prefer_decimation,
+                                     CameraConfiguration& target);
+
     virtual std::vector<std::string> detectAvailableImageEncodings();
 
     virtual std::string currentROSEncoding() const;
@@ -143,9 +172,71 @@ protected:
     typedef typename CameraTraitT::GainType GainType;
     typedef typename CameraTraitT::ShutterModeEnums ShutterModeEnums;
     typedef typename CameraTraitT::UserOutputSelectorEnums UserOutputSelectorEnums;
+    typedef typename CameraTraitT::TriggerSelectorEnums TriggerSelectorEnums;
+    typedef typename CameraTraitT::TriggerModeEnums TriggerModeEnums;
+    typedef typename CameraTraitT::TriggerSourceEnums TriggerSourceEnums;
+
+    /**
+     * Takes the ownership of an instant camera the device is already
+     * attached to, e.g. one that accepts devices of another class.
+     */
+    explicit PylonCameraImpl(CBaslerInstantCameraT* cam);
 
     CBaslerInstantCameraT* cam_;
 
+    // Provides the grab buffers out of a pool of image messages, which
+    // makes it possible to publish the grab results without copying them
+    boost::shared_ptr<ImageBufferFactory> buffer_factory_;
+
+    // Number of frames that have been triggered in the pipelined
+    // software-trigger mode, but not yet retrieved, and its upper limit
+    int triggers_in_flight_;
+    int max_triggers_in_flight_;
+
+    // Frames exposed before a setting has been changed are still queued in
+    // the free-running and pipelined modes and get skipped by grab(). They
+    // are recognized by their exposure start in camera ticks (0 if there are
+    // none), or counted if the camera clock can't be latched
+    uint64_t stale_before_ticks_;
+    int num_stale_frames_;
+
+    // In event-driven grabbing the frames are retrieved by the grab loop
+    // thread of the InstantCamera, which passes them to the handler
+    ImageEventHandler* image_event_handler_;
+    bool event_driven_;
+
+    // Hands over the next grab result of the grab loop thread to the
+    // threads waiting in grab(). Only set while someone is waiting, hence
+    // it doesn't occupy a grab buffer otherwise
+    boost::mutex event_mutex_;
+    boost::condition_variable event_cond_;
+    Pylon::CGrabResultPtr event_result_;
+    uint64_t event_result_id_;
+    int num_event_waiters_;
+
+    // Held while the image callback is running, so that it can't be unset
+    // in the middle of a call
+    boost::mutex image_callback_mutex_;
+    ImageCallback image_callback_;
+
+    // Reports the removal of the device from pylon's monitoring thread. The
+    // mutex is held while the callback is running
+    DeviceRemovalHandler* device_removal_handler_;
+    boost::mutex removal_callback_mutex_;
+    RemovalCallback removal_callback_;
+
+    // Chunk data settings of the running grab. The gain range is cached to
+    // normalize the chunk gain without reading the limits for every frame
+    bool chunk_data_enabled_;
+    bool check_payload_crc_;
+    double chunk_gain_min_;
+    double chunk_gain_max_;
+
+    // The throughput of the downsampling modes is probed by rewriting the
+    // binning and decimation, hence only at the first start of grabbing and
+    // not after a feature snapshot has been restored
+    bool probe_downsampling_throughput_;
+
     // Each camera has it's own getter for GenApi accessors that are named
     // differently for USB and GigE
     GenApi::IFloat& exposureTime();
@@ -156,13 +247,192 @@ protected:
     GainType& autoGainLowerLimit();
     GainType& autoGainUpperLimit();
     GenApi::IFloat& resultingFrameRate();
+    GenApi::IFloat& acquisitionFrameRate();
     AutoTargetBrightnessType& autoTargetBrightness();
+    GenApi::ICommand& timestampLatch();
+    GenApi::IInteger& timestampLatchValue();
+    double timestampTickFrequency();
 
     virtual bool setExtendedBrightness(const int& target_brightness,
                                        const float& current_brightness);
 
+    /**
+     * Retrieves the next frame that has been exposed with the current
+     * settings, see markQueuedFramesStale().
+     * @param grab_result the next grab result
+     * @return false if retrieving failed or the grab was not successful.
+     */
     virtual bool grab(Pylon::CGrabResultPtr& grab_result);
 
+    /**
+     * Retrieves the next frame of the running grab, triggering it first in
+     * the software-trigger modes. Unlike grab() it doesn't skip stale frames.
+     * @param grab_result the next grab result
+     * @return false if retrieving failed or the grab was not successful.
+     */
+    virtual bool retrieveResult(Pylon::CGrabResultPtr& grab_result);
+
+    /**
+     * Has to be called after changing a setting that affects the image:
+     * marks the frames that have already been exposed, such that grab()
+     * skips them. Not needed in the software-trigger mode, where each frame
+     * is triggered by grab() itself.
+     */
+    void markQueuedFramesStale();
+
+    /**
+     * @return true if the frame has been exposed before the last call of
+     *         markQueuedFramesStale().
+     */
+    bool isStale(const Pylon::CGrabResultPtr& grab_result);
+
+    /**
+     * Issues software triggers till max_triggers_in_flight_ frames are
+     * triggered, but not yet retrieved. Only used in the pipelined
+     * software-trigger mode.
+     * @param timeout max time in ms to wait for the camera to accept the
+     *        first trigger, with frames in flight the readiness is only polled
+     * @return false if not even a single frame is in flight.
+     */
+    virtual bool fillTriggerPipeline(const int& timeout);
+
+    /**
+     * Called by the image event handler from the grab loop thread for every
+     * retrieved frame. Hands it over to the waiting grab() calls and passes
+     * it to the image callback.
+     */
+    void onImageGrabbed(const Pylon::CGrabResultPtr& grab_result);
+
+    /**
+     * Called by the device removal handler from pylon's monitoring thread
+     */
+    void onDeviceRemoved();
+
+    /**
+     * Replaces RetrieveResult() in event-driven grabbing: waits for the next
+     * frame the grab loop thread retrieves.
+     * @param grab_result the next grab result
+     * @return false if no frame arrived within the grab timeout or the grab
+     *         was not successful.
+     */
+    bool waitForImageEvent(Pylon::CGrabResultPtr& grab_result);
+
+    /**
+     * Wraps the buffer of the grab result in an image message without
+     * copying it, if the buffer has been provided by the pool. Only the data
+     * of the message is set.
+     */
+    void wrapGrabResult(const Pylon::CGrabResultPtr& grab_result,
+                        sensor_msgs::ImagePtr& image);
+
+    /**
+     * Fills the metadata with the timestamps of the grab result. Should be
+     * called right after retrieving the result, because the host stamp is
+     * the current time.
+     */
+    void fillMetadata(const Pylon::CGrabResultPtr& grab_result,
+                      FrameMetadata& metadata) const;
+
+    /**
+     * Activates the chunk mode and enables the chunks of exposure time,
+     * gain, frame counter, timestamp and payload CRC, as far as the camera
+     * supports them. Named differently for USB and GigE. Has to be called
+     * before grabbing starts, because it changes the payload size.
+     * @param enable false deactivates the chunk mode
+     * @return true if the chunk mode is active.
+     */
+    bool setupChunkData(const bool& enable);
+
+    /**
+     * Reads the enabled chunks of the grab result into the metadata. The
+     * values have been parsed from the payload, hence this doesn't cause
+     * any transaction with the device.
+     */
+    void readChunkData(const Pylon::CGrabResultPtr& grab_result,
+                       FrameMetadata& metadata) const;
+
+    /**
+     * Maps a gain in camera units to the range of currentGain()
+     */
+    float normalizedGain(const double& gain) const;
+
+    /**
+     * Sets up the frame start trigger according to the registered acquisition
+     * mode. Has to be called after loading the default user set, because this
+     * overrides the trigger settings of the registered configuration.
+     * @param parameters The PylonCameraParameter set to use
+     * @return false if a communication error occurred or true otherwise.
+     */
+    bool setupAcquisitionMode(const PylonCameraParameter& parameters);
+
+    /**
+     * Resolves the region of interest of the target against the current
+     * maximum image size: a zero size selects the maximum, the values are
+     * aligned to the increments and the offsets limited to fit the size.
+     * @param target the desired region of interest
+     * @param roi the resolved region of interest
+     */
+    void resolveROI(const CameraConfiguration& target,
+                    CameraConfiguration& roi);
+
+    /**
+     * Logs the max frame rate and the resulting throughput without
+     * downsampling, with binning and with decimation by the given factors.
+     * Probes the settings on the camera, hence it must not be grabbing. The
+     * current factors and region of interest are restored afterwards.
+     * Called only once, at the first start of grabbing with downsampling
+     * requested and without a restored feature snapshot.
+     */
+    void logDownsamplingThroughput(const size_t& factor_x,
+                                   const size_t& factor_y);
+
+    /**
+     * Replaces a packed 12 bit GenAPI encoding by its 10 bit counterpart, if
+     * the camera only supports the latter
+     */
+    void usePackedFallback(std::string& gen_api_encoding) const;
+
+    /**
+     * Reads the image size, pixel format and the exposure and gain limits
+     * from the camera, updates img_rows_, img_cols_, packed_bits_ and
+     * img_size_byte_ and publishes them as new state snapshot. Must be called
+     * after every change of these settings.
+     */
+    void updateState();
+
+    /**
+     * Unpacks the packed pixels of a grab result into the 16 bit image of
+     * img_size_byte_ byte
+     */
+    void unpackImage(const uint8_t* packed, uint8_t* image);
+
+    /**
+     * Writes the binning and decimation factors, limited to the range of
+     * the camera. Both are reset first, because some cameras don't allow
+     * them at the same time. The camera must not be grabbing.
+     */
+    void writeDownsampling(const size_t& binning_x,
+                           const size_t& binning_y,
+                           const size_t& decimation_x,
+                           const size_t& decimation_y);
+
+    /**
+     * Limits the value to the range of the integer feature
+     */
+    int64_t clampedValue(GenApi::IInteger& feature, const size_t& value);
+
+    /**
+     * The grab strategy that corresponds to the registered acquisition mode
+     * @return the pylon grab strategy used for StartGrabbing()
+     */
+    Pylon::EGrabStrategy grabStrategy() const;
+
+    /**
+     * The grab loop that corresponds to the event-driven grabbing setting
+     * @return the pylon grab loop type used for StartGrabbing()
+     */
+    Pylon::EGrabLoop grabLoop() const;
+
     virtual bool setupSequencer(const std::vector<float>& exposure_times,
                                 std::vector<float>& exposure_times_set);
 };
@@ -172,6 +442,7 @@ protected:
 #include <pylon_camera/internal/impl/pylon_camera_base.hpp>
 #include <pylon_camera/internal/impl/pylon_camera_usb.hpp>
 #include <pylon_camera/internal/impl/pylon_camera_dart.hpp>
+#include <pylon_camera/internal/impl/pylon_camera_camemu.hpp>
 #include <pylon_camera/internal/impl/pylon_camera_gige.hpp>
 
 #endif  // PYLON_CAMERA_INTERNAL_PYLON_CAMERA_H
@@ -0,0 +1,107 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#ifndef PYLON_CAMERA_LATENCY_HISTOGRAM_H
+#define PYLON_CAMERA_LATENCY_HISTOGRAM_H
+
+#include <stdint.h>
+#include <atomic>
+#include <cstddef>
+
+namespace pylon_camera
+{
+
+/**
+ * Latency statistics of a histogram since the last summary, all durations
+ * in microseconds
+ */
+struct LatencySummary
+{
+    LatencySummary();
+
+    uint64_t count_;
+    double mean_;
+    double p50_;
+    double p95_;
+    double p99_;
+    double max_;
+};
+
+/**
+ * Lock-free histogram of durations, which can be filled from several threads
+ * concurrently. The buckets are logarithmic with 8 sub-buckets per power of
+ * two, hence the percentiles have a relative error of at most 6.25%, whereas
+ * the mean and the max are exact. Recording a value takes a few relaxed
+ * atomic increments, no allocation and no lock.
+ */
+class LatencyHistogram
+{
+public:
+    LatencyHistogram();
+
+    /**
+     * Adds a duration to the histogram
+     * @param duration_ns the duration in nanoseconds
+     */
+    void record(const uint64_t& duration_ns);
+
+    /**
+     * Computes the statistics of all durations recorded since the last call
+     * and resets the histogram. Values recorded concurrently end up either
+     * in this or in the next summary.
+     * @return the statistics since the last call
+     */
+    LatencySummary takeSummary();
+
+protected:
+    static const int SUB_BUCKET_BITS = 3;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    // durations of 2^40ns (~18 minutes) and longer share the last bucket
+    static const int MAX_BITS = 40;
+    static const std::size_t NUM_BUCKETS =
+                            (MAX_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    /**
+     * Index of the bucket a duration falls into
+     */
+    static std::size_t bucketIndex(const uint64_t& duration_ns);
+
+    /**
+     * Representative duration of a bucket, i.e. the center of its range
+     */
+    static double bucketValue(const std::size_t& index);
+
+    std::atomic<uint64_t> buckets_[NUM_BUCKETS];
+    std::atomic<uint64_t> sum_;
+    std::atomic<uint64_t> max_;
+};
+
+}  // namespace pylon_camera
+
+#endif  // PYLON_CAMERA_LATENCY_HISTOGRAM_H
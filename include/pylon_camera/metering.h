@@ -0,0 +1,282 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#ifndef PYLON_CAMERA_METERING_H
+#define PYLON_CAMERA_METERING_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <sensor_msgs/Image.h>
+#include <sensor_msgs/RegionOfInterest.h>
+#include <pylon_camera/pylon_camera_parameter.h>
+
+namespace pylon_camera
+{
+
+/**
+ * Brightness statistics of an image for the exposure search. The 8 bit
+ * brightness of a pixel is its byte for 8 bit encodings, the upper byte of
+ * the MSB aligned 16 bit encodings and the luma of yuv422. All channels of
+ * color and Bayer images are sampled alike.
+ */
+namespace metering
+{
+
+enum METERING_KERNEL
+{
+    MK_SCALAR = 0,
+    MK_SSE2 = 1,
+    MK_AVX2 = 2,
+    MK_NEON = 3,
+};
+
+struct MeteringResult
+{
+    MeteringResult();
+
+    /**
+     * Mean 8 bit brightness of the samples
+     */
+    double mean_;
+
+    /**
+     * Mean 8 bit brightness weighted by the metering mode, equals mean_ for
+     * the average metering
+     */
+    double metered_mean_;
+
+    /**
+     * Fraction of the samples with the value 255
+     */
+    double saturated_fraction_;
+
+    /**
+     * Number of sampled bytes, the sum is accumulated in 64 bit, hence it
+     * can't overflow for any sensor size
+     */
+    uint64_t num_samples_;
+
+    /**
+     * Number of samples per 8 bit brightness
+     */
+    uint64_t histogram_[256];
+};
+
+/**
+ * Which bytes of a row hold the 8 bit brightness of an encoding
+ */
+struct SampleLayout
+{
+    /**
+     * Offset of the first brightness byte in a row
+     */
+    std::size_t offset_;
+
+    /**
+     * Distance of two brightness bytes, 1 or 2
+     */
+    std::size_t stride_;
+
+    /**
+     * Number of brightness bytes per pixel, e.g. 3 for rgb8
+     */
+    std::size_t per_pixel_;
+};
+
+/**
+ * @param encoding the ROS encoding
+ * @param is_bigendian the byte order of 16 bit encodings
+ * @param layout the layout of the brightness bytes
+ * @return false if the encoding isn't supported
+ */
+bool sampleLayout(const std::string& encoding,
+                  const bool& is_bigendian,
+                  SampleLayout& layout);
+
+/**
+ * Computes the mean, the histogram and the saturated fraction in one pass
+ * over every step_y-th row and every step_x-th pixel of these rows. The
+ * SIMD kernels process rows with step_x == 1, the fastest kernel supported
+ * by the CPU is detected once at runtime.
+ * @param img mono8, bayer_*, rgb8/bgr8, 16 bit variants of those or yuv422
+ * @param step_x the horizontal distance of the sampled pixels
+ * @param step_y the vertical distance of the sampled rows
+ * @param result the statistics
+ * @return false if the encoding isn't supported or the image is empty
+ */
+bool meter(const sensor_msgs::Image& img,
+           const std::size_t& step_x,
+           const std::size_t& step_y,
+           MeteringResult& result);
+
+/**
+ * Meters with the given kernel, which has to be supported by the CPU.
+ * The scalar kernel is the reference of all others.
+ * @return false if the encoding or the kernel isn't supported
+ */
+bool meter(const sensor_msgs::Image& img,
+           const std::size_t& step_x,
+           const std::size_t& step_y,
+           MeteringResult& result,
+           const METERING_KERNEL& kernel);
+
+/**
+ * Weights of the metering modes on a grid of tiles, built once per mode,
+ * region and image size. The tile edges are pixel positions, hence the spot
+ * and the region are metered exactly instead of being rounded to a fixed
+ * grid:
+ *  - MM_AVERAGE: one tile, every pixel has the same weight
+ *  - MM_CENTER_WEIGHTED: 16x16 tiles with a gaussian falloff that gives
+ *    about half of the weight to the central quarter of the image
+ *  - MM_SPOT: the central 15 % of the width and height
+ *  - MM_ROI: the given region of the image, clipped to the image
+ *  - MM_MATRIX: 16x16 tiles of equal weight. Tiles brighter than twice the
+ *    median tile of the frame are weighted down by the square of their
+ *    excess, so that a bright window doesn't dominate the scene
+ */
+class WeightMask
+{
+public:
+    /**
+     * @param mode the metering mode
+     * @param roi the region of the image, only used by MM_ROI
+     * @param width the image width in pixels
+     * @param height the image height in pixels
+     */
+    WeightMask(const METERING_MODE& mode,
+               const sensor_msgs::RegionOfInterest& roi,
+               const std::size_t& width,
+               const std::size_t& height);
+
+    /**
+     * @return true if the mask was built for this mode, region and size
+     */
+    bool matches(const METERING_MODE& mode,
+                 const sensor_msgs::RegionOfInterest& roi,
+                 const std::size_t& width,
+                 const std::size_t& height) const;
+
+    /**
+     * @return false if the region of a MM_ROI mask doesn't overlap the image,
+     *         such a mask meters the average of the image
+     */
+    bool isValid() const;
+
+    const METERING_MODE& mode() const;
+    std::size_t tilesX() const;
+    std::size_t tilesY() const;
+
+    /**
+     * The pixel columns [colEdges()[i], colEdges()[i + 1]) belong to tile
+     * column i, the rows analogous
+     */
+    const std::vector<std::size_t>& colEdges() const;
+    const std::vector<std::size_t>& rowEdges() const;
+
+    /**
+     * The weights of the tiles in row major order
+     */
+    const std::vector<float>& weights() const;
+
+private:
+    void setUniformEdges(const std::size_t& tiles_x,
+                         const std::size_t& tiles_y);
+
+    METERING_MODE mode_;
+    sensor_msgs::RegionOfInterest roi_;
+    std::size_t width_;
+    std::size_t height_;
+    bool is_valid_;
+    std::vector<std::size_t> col_edges_;
+    std::vector<std::size_t> row_edges_;
+    std::vector<float> weights_;
+};
+
+/**
+ * Meters like meter() and additionally weights the tiles of the mask: the
+ * rows are split at the tile edges and each segment is metered by the SIMD
+ * kernel, the weighted mean of the tile sums is the metered_mean_. mean_,
+ * the histogram and the saturated fraction describe the whole image, hence
+ * they can be compared with the auto functions of the camera.
+ * @param mask the mask built for the size of the image
+ * @return false if the encoding isn't supported, the image is empty or the
+ *         mask was built for another size
+ */
+bool meter(const sensor_msgs::Image& img,
+           const std::size_t& step_x,
+           const std::size_t& step_y,
+           const WeightMask& mask,
+           MeteringResult& result);
+
+/**
+ * Meters the tiles of the mask with the given kernel, which has to be
+ * supported by the CPU.
+ * @return false if the encoding or the kernel isn't supported, the image is
+ *         empty or the mask was built for another size
+ */
+bool meter(const sensor_msgs::Image& img,
+           const std::size_t& step_x,
+           const std::size_t& step_y,
+           const WeightMask& mask,
+           MeteringResult& result,
+           const METERING_KERNEL& kernel);
+
+/**
+ * @param name 'average', 'center_weighted', 'spot', 'roi' or 'matrix'
+ * @param mode the metering mode
+ * @return false if the name is unknown
+ */
+bool meteringModeFromString(const std::string& name, METERING_MODE& mode);
+
+/**
+ * @return the name of the metering mode, e.g. 'center_weighted'
+ */
+std::string meteringModeString(const METERING_MODE& mode);
+
+/**
+ * @return true if the kernel was compiled in and the CPU supports it
+ */
+bool isSupported(const METERING_KERNEL& kernel);
+
+/**
+ * @return the fastest kernel supported by the CPU
+ */
+METERING_KERNEL bestKernel();
+
+/**
+ * @return the name of the kernel, e.g. 'avx2'
+ */
+std::string kernelName(const METERING_KERNEL& kernel);
+
+}  // namespace metering
+}  // namespace pylon_camera
+
+#endif  // PYLON_CAMERA_METERING_H
@@ -0,0 +1,136 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#ifndef PYLON_CAMERA_MULTI_CAMERA_HOST_H
+#define PYLON_CAMERA_MULTI_CAMERA_HOST_H
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <ros/ros.h>
+#include <ros/callback_queue.h>
+
+#include <pylon_camera/pylon_camera.h>
+#include <pylon_camera/pylon_camera_node.h>
+
+namespace pylon_camera
+{
+
+/**
+ * Drives several cameras in one process. The cameras are opened based on a
+ * single enumeration of the devices, each of them is run by a
+ * PylonCameraNode in its own namespace, hence it provides the same topics
+ * and services as the single camera node. Every camera has its own
+ * acquisition thread, whereas publishing and post-processing the frames is
+ * done by a worker pool shared by all cameras.
+ */
+class MultiCameraHost
+{
+public:
+    /**
+     * @param nh the private node handle. The list of camera names is read
+     *        from its 'cameras' parameter, the parameters of each camera
+     *        are expected in the sub-namespace of its name.
+     */
+    explicit MultiCameraHost(const ros::NodeHandle& nh);
+
+    virtual ~MultiCameraHost();
+
+    /**
+     * Enumerates the devices once, opens all configured cameras and starts
+     * the worker pool.
+     * @return false if no camera is configured.
+     */
+    bool start();
+
+    /**
+     * Stops the worker pool and closes all cameras.
+     */
+    void stop();
+
+protected:
+    /**
+     * Everything that belongs to a single camera
+     */
+    struct Camera
+    {
+        explicit Camera(const std::string& name,
+                        const ros::NodeHandle& parent_nh);
+
+        std::string name_;
+        // the services of each camera are processed by its own spinner,
+        // hence a long running service does not block the other cameras
+        ros::CallbackQueue callback_queue_;
+        ros::NodeHandle nh_;
+        boost::scoped_ptr<ros::AsyncSpinner> spinner_;
+        // taken from the common enumeration, owned by node_ afterwards
+        PylonCamera* pylon_camera_;
+        PylonCameraNode* node_;
+        // serializes the publishing of this camera within the worker pool
+        boost::scoped_ptr<boost::asio::io_service::strand> strand_;
+        boost::thread control_thread_;
+    };
+
+    /**
+     * Creates the node of the camera and supervises it till the host is
+     * stopped. Opening the camera might wait for the device, hence it runs in
+     * a thread per camera.
+     */
+    void controlLoop(Camera* camera);
+
+    /**
+     * Frame ready callback of the nodes: schedules publishing the pending
+     * frames of the camera in the worker pool
+     */
+    void schedulePublishing(Camera* camera);
+
+    /**
+     * Stop predicate of the nodes, which abort opening the camera and their
+     * retries once the host is stopped
+     */
+    bool isStopping() const;
+
+    ros::NodeHandle nh_;
+    std::vector<boost::shared_ptr<Camera> > cameras_;
+
+    boost::asio::io_service io_service_;
+    boost::scoped_ptr<boost::asio::io_service::work> work_;
+    boost::thread_group workers_;
+
+    std::atomic<bool> is_running_;
+};
+
+}  // namespace pylon_camera
+
+#endif  // PYLON_CAMERA_MULTI_CAMERA_HOST_H
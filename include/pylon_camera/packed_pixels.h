@@ -0,0 +1,113 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#ifndef PYLON_CAMERA_PACKED_PIXELS_H
+#define PYLON_CAMERA_PACKED_PIXELS_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <string>
+
+namespace pylon_camera
+{
+
+namespace packed_pixels
+{
+
+enum UNPACK_KERNEL
+{
+    UK_SCALAR = 0,
+    UK_SSSE3 = 1,
+    UK_AVX2 = 2,
+    UK_NEON = 3,
+};
+
+/**
+ * Number of bits per pixel of a packed GenAPI pixel format, e.g. 12 for
+ * 'Mono12p' or 10 for 'BayerRG10p'.
+ * @return 10 or 12 for the supported packed formats, 0 otherwise
+ */
+int packedBits(const std::string& gen_api_enc);
+
+/**
+ * Size of a packed image. Pixels are packed without padding, starting with
+ * the least significant bit (GenICam PFNC), hence the last byte might be
+ * partially used.
+ * @param num_pixels the number of pixels
+ * @param bits 10 or 12
+ * @return the size in byte
+ */
+std::size_t packedSize(const std::size_t& num_pixels, const int& bits);
+
+/**
+ * Unpacks 10 or 12 bit pixels into 16 bit pixels (little endian), aligned
+ * to the most significant bit. The value range of the 16 bit image is hence
+ * used completely and the upper byte holds the 8 bit value of the pixel.
+ * The fastest kernel supported by the CPU is detected once at runtime.
+ * @param src the packed pixels, at least packedSize(num_pixels, bits) byte
+ * @param dst num_pixels unpacked pixels
+ * @param num_pixels the number of pixels
+ * @param bits 10 or 12
+ * @return false if the bit depth is not supported
+ */
+bool unpack(const uint8_t* src,
+            uint16_t* dst,
+            const std::size_t& num_pixels,
+            const int& bits);
+
+/**
+ * Unpacks with the given kernel, which has to be supported by the CPU.
+ * The scalar kernel is the reference of all others.
+ * @return false if the bit depth or the kernel is not supported
+ */
+bool unpack(const uint8_t* src,
+            uint16_t* dst,
+            const std::size_t& num_pixels,
+            const int& bits,
+            const UNPACK_KERNEL& kernel);
+
+/**
+ * @return true if the kernel was compiled in and the CPU supports it
+ */
+bool isSupported(const UNPACK_KERNEL& kernel);
+
+/**
+ * @return the fastest kernel supported by the CPU
+ */
+UNPACK_KERNEL bestKernel();
+
+/**
+ * @return the name of the kernel, e.g. 'avx2'
+ */
+std::string kernelName(const UNPACK_KERNEL& kernel);
+
+}  // namespace packed_pixels
+}  // namespace pylon_camera
+
+#endif  // PYLON_CAMERA_PACKED_PIXELS_H
@@ -0,0 +1,171 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#ifndef PYLON_CAMERA_PIPELINE_STATISTICS_H
+#define PYLON_CAMERA_PIPELINE_STATISTICS_H
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+
+#include <pylon_camera/latency_histogram.h>
+
+namespace pylon_camera
+{
+
+/**
+ * The instrumented stages of the pipeline from triggering a frame till
+ * publishing it
+ */
+enum LATENCY_STAGE
+{
+    LS_TRIGGER_WAIT = 0,      // waiting for the trigger readiness + trigger
+    LS_RETRIEVE = 1,          // RetrieveResult()
+    LS_BUFFER = 2,            // wrapping or copying the grab buffer
+    LS_BRIGHTNESS = 3,        // calcCurrentBrightness()
+    LS_RECTIFY = 4,           // rectification of the published frame
+    LS_PUBLISH = 5,           // publishing the raw image
+    LS_STAMP_TO_PUBLISH = 6,  // from the header stamp till the raw image is published
+    LS_CONVERT = 7,           // demosaicing or YUV conversion of the published frame
+    NUM_LATENCY_STAGES = 8
+};
+
+/**
+ * Counted events of the pipeline
+ */
+enum FRAME_COUNTER
+{
+    FC_GRABBED = 0,
+    FC_GRAB_ERRORS = 1,
+    FC_PUBLISHED = 2,
+    FC_MISSED = 3,            // gaps in the frame counter of the chunk data
+    FC_CRC_ERRORS = 4,        // frames with a wrong payload CRC
+    FC_SKIPPED = 5,           // event-driven frames skipped while the camera was busy
+    NUM_FRAME_COUNTERS = 6
+};
+
+/**
+ * Latency histograms of all pipeline stages and the frame counters. Nothing
+ * is recorded while the statistics are disabled, which can be switched at
+ * runtime. All methods are thread-safe and lock-free.
+ */
+class PipelineStatistics
+{
+public:
+    PipelineStatistics();
+
+    /**
+     * Enables or disables recording
+     */
+    void setEnabled(const bool& enabled);
+
+    bool isEnabled() const;
+
+    /**
+     * Records the duration of a stage, if enabled
+     * @param stage the stage
+     * @param duration_ns the duration in nanoseconds
+     */
+    void record(const LATENCY_STAGE& stage, const uint64_t& duration_ns);
+
+    /**
+     * Increments a frame counter, if enabled
+     * @param counter the counter
+     * @param amount the increment
+     */
+    void count(const FRAME_COUNTER& counter, const uint64_t& amount = 1);
+
+    /**
+     * Statistics of a stage since the last call, see
+     * LatencyHistogram::takeSummary()
+     */
+    LatencySummary takeSummary(const LATENCY_STAGE& stage);
+
+    /**
+     * Value of a frame counter since the last call, which resets it
+     */
+    uint64_t takeCount(const FRAME_COUNTER& counter);
+
+    /**
+     * Name of a stage for reporting
+     */
+    static std::string stageName(const LATENCY_STAGE& stage);
+
+    /**
+     * Name of a frame counter for reporting
+     */
+    static std::string counterName(const FRAME_COUNTER& counter);
+
+    /**
+     * Monotonic time in nanoseconds for measuring the stage durations
+     */
+    static uint64_t now()
+    {
+        return static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+protected:
+    std::atomic<bool> enabled_;
+    LatencyHistogram histograms_[NUM_LATENCY_STAGES];
+    std::atomic<uint64_t> counters_[NUM_FRAME_COUNTERS];
+};
+
+/**
+ * Measures the lifetime of the scope as duration of a stage. Reads the
+ * clock only if the statistics are given and enabled.
+ */
+class ScopedLatency
+{
+public:
+    ScopedLatency(PipelineStatistics* statistics, const LATENCY_STAGE& stage)
+        : statistics_(statistics && statistics->isEnabled() ? statistics : nullptr)
+        , stage_(stage)
+        , start_(statistics_ ? PipelineStatistics::now() : 0)
+    {}
+
+    ~ScopedLatency()
+    {
+        if ( statistics_ )
+        {
+            statistics_->record(stage_, PipelineStatistics::now() - start_);
+        }
+    }
+
+private:
+    PipelineStatistics* statistics_;
+    const LATENCY_STAGE stage_;
+    const uint64_t start_;
+};
+
+}  // namespace pylon_camera
+
+#endif  // PYLON_CAMERA_PIPELINE_STATISTICS_H
@@ -30,11 +30,21 @@
 #ifndef PYLON_CAMERA_PYLON_CAMERA_H
 #define PYLON_CAMERA_PYLON_CAMERA_H
 
+#include <atomic>
 #include <string>
 #include <vector>
 
+#include <boost/function.hpp>
+#include <boost/thread/mutex.hpp>
+#include <sensor_msgs/Image.h>
+
 #include <pylon_camera/pylon_camera_parameter.h>
 #include <pylon_camera/binary_exposure_search.h>
+#include <pylon_camera/camera_configuration.h>
+#include <pylon_camera/camera_state_snapshot.h>
+#include <pylon_camera/camera_clock_model.h>
+#include <pylon_camera/frame_metadata.h>
+#include <pylon_camera/pipeline_statistics.h>
 
 namespace pylon_camera
 {
@@ -49,6 +59,17 @@ namespace pylon_camera
 class PylonCamera
 {
 public:
+    /**
+     * Function the frames are passed to in event-driven grabbing
+     */
+    typedef boost::function<void (const sensor_msgs::ImagePtr&,
+                                  const FrameMetadata&)> ImageCallback;
+
+    /**
+     * Function called when the removal of the camera device is detected
+     */
+    typedef boost::function<void ()> RemovalCallback;
+
     /**
      * Create a new PylonCamera instance. It will return the first camera that could be found.
      * @return new PylonCamera instance or NULL if no camera was found.
@@ -64,10 +85,33 @@ public:
     static PylonCamera* create(const std::string& device_user_id);
 
     /**
-     * Configures the camera according to the software trigger mode.
+     * Create a new PylonCamera instance based on the identification given in
+     * the parameters, in order of precedence: the IP address, which opens a
+     * GigE camera by unicast discovery, the serial number, for which only the
+     * transport layer of the device class is searched, and the DeviceUserID.
+     * @param parameters the parameter set holding the identification.
+     * @return new PylonCamera instance or NULL if the camera was not found.
+     */
+    static PylonCamera* create(const PylonCameraParameter& parameters);
+
+    /**
+     * Create several PylonCamera instances based on a single enumeration of
+     * the connected devices, which is faster than creating them one by one.
+     * @param device_user_ids Pylon DeviceUserIDs of the desired cameras. An
+     * empty string matches the first camera that is not yet taken.
+     * @return a new PylonCamera instance for every DeviceUserID, or NULL if
+     * the corresponding camera was not found.
+     */
+    static std::vector<PylonCamera*> create(
+                            const std::vector<std::string>& device_user_ids);
+
+    /**
+     * Configures the camera according to the desired acquisition mode, which
+     * is either the software trigger mode or one of the free-running modes.
+     * @param acquisition_mode the desired acquisition mode.
      * @return true if all the configuration could be set up.
      */
-    virtual bool registerCameraConfiguration() = 0;
+    virtual bool registerCameraConfiguration(const ACQUISITION_MODE& acquisition_mode) = 0;
 
     /**
      * Opens the desired camera, the communication starts from now on.
@@ -81,6 +125,25 @@ public:
      */
     virtual bool isCamRemoved() = 0;
 
+    /**
+     * Sets the function that is called as soon as pylon detects the removal
+     * of the camera device. It's called from a pylon thread and must not
+     * access the camera. After returning, the previous function is
+     * guaranteed to not be running anymore. Pass an empty function to unset
+     * it.
+     * @param callback the function to call on device removal
+     */
+    virtual void setRemovalCallback(const RemovalCallback& callback) = 0;
+
+    /**
+     * Replaces the removed device with the device of the same serial number,
+     * if it's present again. The instance with its registered configuration,
+     * event handlers and grab buffers is kept, hence it only has to be opened
+     * and started again afterwards.
+     * @return true if the device has been found and attached.
+     */
+    virtual bool reconnect() = 0;
+
     /**
      * Configure the sequencer exposure times.
      * @param exposure_times the list of exposure times.
@@ -97,6 +160,23 @@ public:
      */
     virtual bool applyCamSpecificStartupSettings(const PylonCameraParameter& parameters) = 0;
 
+    /**
+     * Saves the current values of all persistable features of the camera to
+     * a pylon feature stream (.pfs) file.
+     * @param file_name the path of the file to write.
+     * @return true if the snapshot could be saved.
+     */
+    virtual bool saveFeatureSnapshot(const std::string& file_name) = 0;
+
+    /**
+     * Restores all features of the camera in one bulk load from a pylon
+     * feature stream (.pfs) file, which replaces the startup settings. The
+     * camera must be opened and must not be grabbing.
+     * @param file_name the path of the file to read.
+     * @return true if the snapshot could be loaded and validated.
+     */
+    virtual bool loadFeatureSnapshot(const std::string& file_name) = 0;
+
     /**
      * Initializes the internal parameters of the PylonCamera instance.
      * @param parameters The PylonCameraParameter set to use
@@ -107,9 +187,10 @@ public:
     /**
      * Grab a camera frame and copy the result into image
      * @param image reference to the output image.
+     * @param metadata the timestamps of the grabbed frame
      * @return true if the image was grabbed successfully.
      */
-    virtual bool grab(std::vector<uint8_t>& image) = 0;
+    virtual bool grab(std::vector<uint8_t>& image, FrameMetadata& metadata) = 0;
 
     /**
      * Grab a camera frame and copy the result into image
@@ -120,29 +201,57 @@ public:
     virtual bool grab(uint8_t* image) = 0;
 
     /**
-     * @brief sets shutter mode for the camera (rolling or global_reset)
-     * @param mode
-     * @return
+     * Grab a camera frame without copying it. The returned image message
+     * wraps the buffer the frame has been grabbed to. This buffer will be
+     * handed back to the stream grabber after the message has been released,
+     * so the message has to be treated as read-only. Only the image data is
+     * set, the meta data (header, encoding, geometry) has to be filled in by
+     * the caller.
+     * @param image the image message containing the grabbed data
+     * @param metadata the timestamps of the grabbed frame
+     * @return true if the image was grabbed successfully.
      */
-    virtual bool setShutterMode(const pylon_camera::SHUTTER_MODE& mode) = 0;
+    virtual bool grab(sensor_msgs::ImagePtr& image, FrameMetadata& metadata) = 0;
 
     /**
-     * Sets the target horizontal binning_x factor
-     * @param target_binning_x the target horizontal binning_x factor.
-     * @param reached_binning_x the reached horizontal binning_x factor.
-     * @return false if a communication error occurred or true otherwise.
+     * Latches the camera clock and adds the result to the clock model, which
+     * maps the camera timestamps of the grabbed frames to ROS time. Should be
+     * called periodically to keep track of the clock drift.
+     * @return true if the clock model has been updated.
      */
-    virtual bool setBinningX(const size_t& target_binning_x,
-                             size_t& reached_binning_x) = 0;
+    virtual bool syncClock() = 0;
 
     /**
-     * Sets the target vertical binning_y factor
-     * @param target_binning_y the target vertical binning_y factor.
-     * @param reached_binning_y the reached vertical binning_y factor.
-     * @return false if a communication error occurred or true otherwise.
+     * Sets the function the frames are passed to in event-driven grabbing.
+     * It's called from the grab loop thread of pylon as soon as a frame has
+     * been retrieved, with the same image message as returned by
+     * grab(sensor_msgs::ImagePtr&, FrameMetadata&). Frames that arrive while
+     * no function is set are only handed to grab() calls waiting for them.
+     * After returning, the previous function is guaranteed to not be running
+     * anymore. Pass an empty function to unset it.
+     * @param callback the function to call for each frame
+     */
+    virtual void setImageCallback(const ImageCallback& callback) = 0;
+
+    /**
+     * Getter for the model mapping the camera clock to ROS time
      */
-    virtual bool setBinningY(const size_t& target_binning_y,
-                             size_t& reached_binning_y) = 0;
+    const CameraClockModel& clockModel() const;
+
+    /**
+     * Sets the statistics the durations of the grab stages (trigger wait,
+     * retrieving and wrapping the buffer) are recorded to.
+     * @param statistics the statistics, which have to outlive the camera.
+     *        NULL disables the instrumentation.
+     */
+    void setStatistics(PipelineStatistics* statistics);
+
+    /**
+     * @brief sets shutter mode for the camera (rolling or global_reset)
+     * @param mode
+     * @return
+     */
+    virtual bool setShutterMode(const pylon_camera::SHUTTER_MODE& mode) = 0;
 
     /**
      * Detects the supported image pixel encodings of the camera an stores
@@ -156,12 +265,39 @@ public:
      * Sets the desired image pixel encoding (channel meaning, ordering, size)
      * taken from the list of strings in include/sensor_msgs/image_encodings.h
      * The supported encodings are 'mono8', 'bgr8', 'rgb8', 'bayer_bggr8',
-     * 'bayer_gbrg8', 'bayer_rggb8' and 'yuv422'
+     * 'bayer_gbrg8', 'bayer_rggb8', 'yuv422', 'mono16' and 'bayer_*16'.
+     * The 16 bit encodings are transmitted as packed 12 or 10 bit pixels.
      * @param target_ros_endcoding: string describing the encoding.
      * @return false if a communication error occurred or true otherwise.
      */
     virtual bool setImageEncoding(const std::string& target_ros_encoding) = 0;
 
+    /**
+     * Applies a batch of settings in one transaction. Binning, region of
+     * interest and image encoding need a stopped stream, hence grabbing is
+     * stopped and restarted at most once for all of them, and not at all if
+     * they don't change. Exposure and gain are set while grabbing.
+     * @param target the settings to apply, only the flagged ones are changed.
+     * @param reached all settings of the camera after the transaction.
+     * @param retry set to true if it failed only because of errors that might
+     *        be temporary, e.g. while the camera is busy. Unsupported
+     *        settings fail again and aren't worth a retry.
+     * @return false if a setting couldn't be applied or a communication
+     *         error occurred.
+     */
+    virtual bool reconfigure(const CameraConfiguration& target,
+                             CameraConfiguration& reached,
+                             bool& retry) = 0;
+
+    /**
+     * Getter for the current region of interest of the camera, in pixels of
+     * the binned image
+     * @param roi the offsets, the size and the maximum size are set, the
+     *        flag isn't touched.
+     * @return false if a communication error occurred.
+     */
+    virtual bool currentROI(CameraConfiguration& roi) = 0;
+
     /**
      * Sets the exposure time in microseconds
      * @param target_exposure the desired exposure time to set in microseconds.
@@ -237,10 +373,39 @@ public:
      */
     virtual size_t currentBinningY() = 0;
 
+    /**
+     * Returns the current horizontal decimation setting.
+     * @return the horizontal decimation, 1 if not supported.
+     */
+    virtual size_t currentDecimationX() = 0;
+
+    /**
+     * Returns the current vertical decimation setting.
+     * @return the vertical decimation, 1 if not supported.
+     */
+    virtual size_t currentDecimationY() = 0;
+
+    /**
+     * Chooses between binning and decimation to downsample the image by the
+     * given factors. Decimation is preferred for the frame rate, binning for
+     * the SNR, as long as the camera supports the preferred mode with these
+     * factors. The other mode is reset to 1.
+     * @param factor_x the horizontal downsampling factor.
+     * @param factor_y the vertical downsampling factor.
+     * @param prefer_decimation true if the frame rate matters more than the
+     *        SNR.
+     * @param target the binning and decimation of the configuration are set.
+     */
+    virtual void resolveDownsampling(const size_t& factor_x,
+                                     const size_t& factor_y,
+                                     const bool& prefer_decimation,
+                                     CameraConfiguration& target) = 0;
+
     /**
      * Get the camera image encoding according to sensor_msgs::image_encodings
      * The supported encodings are 'mono8', 'bgr8', 'rgb8', 'bayer_bggr8',
-     * 'bayer_gbrg8', 'bayer_rggb8' and 'yuv422'
+     * 'bayer_gbrg8', 'bayer_rggb8', 'yuv422', 'mono16' and 'bayer_*16'.
+     * The 16 bit encodings are transmitted as packed 12 or 10 bit pixels.
      * @return the current ros image pixel encoding.
      */
     virtual std::string currentROSEncoding() const = 0;
@@ -340,12 +505,31 @@ public:
      */
     virtual float exposureStep() = 0;
 
+    /**
+     * Getter for the acquisition mode registered to the camera
+     * @return the acquisition mode
+     */
+    const ACQUISITION_MODE& acquisitionMode() const;
+
+    /**
+     * Checks if the camera acquires continuously with its own frame rate,
+     * i.e. one of the free-running acquisition modes is active.
+     * @return true if the camera is free-running
+     */
+    bool isFreeRunning() const;
+
     /**
      * Getter for the device user id of the used camera
      * @return the device_user_id
      */
     const std::string& deviceUserID() const;
 
+    /**
+     * Getter for the serial number of the used camera
+     * @return the serial number
+     */
+    const std::string& serialNumber() const;
+
     /**
      * Getter for the image height
      * @return number of rows in the image
@@ -380,6 +564,15 @@ public:
      */
     const size_t& imageSize() const;
 
+    /**
+     * Snapshot of the image format, size and exposure and gain limits. The
+     * returned snapshot stays valid as long as it is held, even after a
+     * setter published a newer one, which frees the replaced one with its
+     * last holder.
+     * @return the current camera state
+     */
+    CameraStateSnapshotConstPtr state() const;
+
     /**
      * Get the maximum achievable frame rate
      * @return float
@@ -419,6 +612,13 @@ protected:
     virtual bool setExtendedBrightness(const int& target_brightness,
                                        const float& current_brightness) = 0;
 
+    /**
+     * Makes the given snapshot the current camera state and takes its
+     * ownership. Must be called whenever a setter changed the state.
+     * @param state the new snapshot
+     */
+    void publishState(CameraStateSnapshot* state);
+
     /**
      * Parameters for the extended brightness search
      */
@@ -429,6 +629,12 @@ protected:
      */
     std::string device_user_id_;
 
+    /**
+     * The serial number of the found camera, used to find it again after
+     * its removal
+     */
+    std::string serial_number_;
+
     /**
      * Number of image rows.
      */
@@ -444,6 +650,35 @@ protected:
      */
     size_t img_size_byte_;
 
+    /**
+     * Bits per pixel of a packed pixel format (e.g. 12 for Mono12p), which
+     * is unpacked to 16 bit when grabbing. 0 for all other formats.
+     */
+    int packed_bits_;
+
+    /**
+     * The current camera state and the number of snapshots published so
+     * far. The mutex is only held while the pointer is copied or swapped.
+     */
+    CameraStateSnapshotConstPtr state_;
+    uint64_t num_published_states_;
+    mutable boost::mutex state_mutex_;
+
+    /**
+     * The acquisition mode, either software triggered or free-running
+     */
+    ACQUISITION_MODE acquisition_mode_;
+
+    /**
+     * Maps the camera timestamps to ROS time
+     */
+    CameraClockModel clock_model_;
+
+    /**
+     * Latency statistics of the grab stages, not owned by the camera
+     */
+    PipelineStatistics* statistics_;
+
     /**
      * The max time a single grab is allowed to take. This value should always
      * be greater then the max possible exposure time of the camera
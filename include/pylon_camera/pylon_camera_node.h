@@ -30,19 +30,33 @@
 #ifndef PYLON_CAMERA_PYLON_CAMERA_NODE_H
 #define PYLON_CAMERA_PYLON_CAMERA_NODE_H
 
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/thread.hpp>
+#include <atomic>
 #include <string>
 #include <ros/ros.h>
 #include <actionlib/server/simple_action_server.h>
 #include <camera_info_manager/camera_info_manager.h>
-#include <cv_bridge/cv_bridge.h>
-#include <image_geometry/pinhole_camera_model.h>
 #include <image_transport/image_transport.h>
 #include <sensor_msgs/CameraInfo.h>
 #include <sensor_msgs/image_encodings.h>
+#include <diagnostic_msgs/DiagnosticArray.h>
+#include <diagnostic_msgs/DiagnosticStatus.h>
 
 #include <pylon_camera/pylon_camera_parameter.h>
 #include <pylon_camera/pylon_camera.h>
+#include <pylon_camera/demosaicing.h>
+#include <pylon_camera/uyvy_conversions.h>
+#include <pylon_camera/rectifier.h>
+#include <pylon_camera/camera_info_cache.h>
+#include <pylon_camera/metering.h>
+#include <pylon_camera/frame_ring.h>
+#include <pylon_camera/pipeline_statistics.h>
+#include <pylon_camera/FrameInfo.h>
+#include <pylon_camera/SetConfiguration.h>
+#include <pylon_camera/SetMeteredBrightness.h>
+#include <pylon_camera/SetROI.h>
 
 #include <camera_control_msgs/SetBool.h>
 #include <camera_control_msgs/SetBinning.h>
@@ -65,19 +79,69 @@ class PylonCameraNode
 {
 public:
     PylonCameraNode();
+
+    /**
+     * @param nh the private node handle to advertise the topics and services
+     * @param shutdown_on_error if true, ros::shutdown is called if the camera
+     *        can't be initialized. Should be false if the node does not own
+     *        the process, e.g. when running as nodelet.
+     * @param pylon_camera an already created camera the node takes the
+     *        ownership of, e.g. from a common enumeration of several cameras.
+     *        If NULL, the node creates the camera itself.
+     * @param stop_requested returns true if the owner of the node is shutting
+     *        down, e.g. an unloaded nodelet whose manager keeps ros::ok().
+     *        It ends the waiting for the camera to appear or to reappear.
+     */
+    PylonCameraNode(const ros::NodeHandle& nh,
+                    const bool& shutdown_on_error,
+                    PylonCamera* pylon_camera = nullptr,
+                    const boost::function<bool ()>& stop_requested =
+                                                    boost::function<bool ()>());
+
     virtual ~PylonCameraNode();
 
     /**
      * initialize the camera and the ros node.
-     * calls ros::shutdown if an error occurs.
+     * calls ros::shutdown if an error occurs and shutdown_on_error is set.
      */
     void init();
 
     /**
-     * spin the node
+     * Getter for the is_initialized_ flag, which is false if initializing the
+     * camera failed
+     */
+    const bool& isInitialized() const;
+
+    /**
+     * spin the node: the publishing stage, which waits for the next frame
+     * grabbed by the acquisition thread (or the grab loop thread of pylon in
+     * event-driven grabbing) and publishes it
      */
     virtual void spin();
 
+    /**
+     * Alternative to spin() if the frames are published by a worker pool:
+     * sets a function that is called whenever a frame has been pushed into
+     * the frame ring, e.g. to schedule publishPendingFrames(). It's called
+     * from the acquisition thread, respectively the grab loop thread in
+     * event-driven grabbing, hence it must not block.
+     * @param callback the function to call, an empty one unsets it
+     */
+    void setFrameReadyCallback(const boost::function<void ()>& callback);
+
+    /**
+     * Publishes all frames available in the frame ring without waiting for
+     * further ones. Must not be called concurrently for the same node.
+     */
+    void publishPendingFrames();
+
+    /**
+     * Starts the recovery in the background, if polling detects the removal
+     * of the camera before pylon has reported it. Doesn't block.
+     * @return true while the camera is removed or being recovered
+     */
+    bool resetIfCameraRemoved();
+
     /**
      * Getter for the frame rate set by the launch script or from the ros parameter
      * server
@@ -92,12 +156,43 @@ public:
     const std::string& cameraFrame() const;
 
 protected:
+    /**
+     * @return true if ROS or the owner of the node is shutting down
+     */
+    bool isStopRequested() const;
+
+    /**
+     * Called if init() fails: shuts down ROS or only logs the error,
+     * depending on shutdown_on_error_
+     */
+    void handleInitError();
+
     /**
      * Creates the camera instance and starts the services and action servers.
      * @return false if an error occurred
      */
     bool initAndRegister();
 
+    /**
+     * Restores the feature snapshot of the camera that matches the startup
+     * parameters, or applies the camera specific startup settings if there
+     * is none or it can't be restored.
+     * @return false if an error occurred
+     */
+    bool applyStartupSettings();
+
+    /**
+     * Saves the feature snapshot of the fully configured camera, so that the
+     * next start can restore it
+     */
+    void saveStartupSnapshot();
+
+    /**
+     * Removes the snapshots of this camera except the current one, which
+     * were saved with other parameters
+     */
+    void removeOutdatedStartupSnapshots();
+
     /**
      * Start the camera and initialize the messages
      * @return
@@ -105,7 +200,91 @@ protected:
     bool startGrabbing();
 
     /**
-     * Initializing of img_rect_pub_, grab_img_rect_as_ and the pinhole_model_,
+     * Creates the frame ring and starts the acquisition thread, or registers
+     * the image callback in event-driven grabbing
+     */
+    void startAcquisition();
+
+    /**
+     * Stops the acquisition thread, respectively unregisters the image
+     * callback, and releases all frames left in the ring
+     */
+    void stopAcquisition();
+
+    /**
+     * Called from pylon's monitoring thread when the camera device has been
+     * removed, wakes up the recovery thread
+     */
+    void onCameraRemoved();
+
+    /**
+     * Runs in the recovery thread: waits for the removal of the camera and
+     * recovers it, till the node is destroyed
+     */
+    void recoveryLoop();
+
+    /**
+     * Stops the acquisition, waits till the device with the same serial
+     * number is present again and reopens it with the last known settings.
+     * Publishers, services, action servers and the grab buffers are kept.
+     * @return false if the camera couldn't be reopened or the node is
+     *         shutting down
+     */
+    bool recoverCamera();
+
+    /**
+     * Main loop of the acquisition thread: only grabs the frames with the
+     * desired frame rate and pushes them into the frame ring, hence a stalled
+     * publisher does not delay the next trigger.
+     */
+    void acquisitionLoop();
+
+    /**
+     * Image callback in event-driven grabbing, called from the grab loop
+     * thread of pylon as soon as a frame has been retrieved. Pushes the frame
+     * into the frame ring if subscribers are available. Frames arriving while
+     * the grab mutex is locked, e.g. during reconfiguration or while an
+     * action grabs, are dropped instead of blocking the grab loop.
+     * @param img the grabbed frame, only its data is set
+     * @param metadata the timestamps of the grabbed frame
+     */
+    void imageCallback(const sensor_msgs::ImagePtr& img,
+                       const FrameMetadata& metadata);
+
+    /**
+     * Latches the camera clock if the clock sync interval has passed.
+     * The grab mutex has to be locked.
+     */
+    void syncClockIfDue();
+
+    /**
+     * Pushes a grabbed frame into the frame ring and warns if the ring
+     * dropped frames since the last call
+     * @param img the frame to publish
+     */
+    void pushFrame(const sensor_msgs::ImagePtr& img);
+
+    /**
+     * Publishes a frame popped from the frame ring on the raw and (if
+     * calibrated) the rect topic
+     * @param img the frame to publish
+     */
+    void publishFrame(const sensor_msgs::ImagePtr& img);
+
+    /**
+     * Converts a Bayer or yuv422 frame and publishes it on image_color and
+     * image_mono. Only the images of topics with subscribers are computed.
+     * @param img the Bayer or yuv422 frame
+     */
+    void publishConverted(const sensor_msgs::ImagePtr& img);
+
+    /**
+     * Pins the calling thread to the CPU given by the cpu_affinity parameter
+     */
+    void pinAcquisitionThread();
+
+    /**
+     * Initializing of img_rect_pub_, grab_img_rect_as_ and the rectifier_,
      * in case that a valid camera info has been set
      * @return
      */
@@ -127,35 +306,104 @@ protected:
     uint32_t getNumSubscribersRect() const;
 
     /**
-     * Grabs an image and stores the image in img_raw_msg_
+     * Returns the number of subscribers for the converted image topics,
+     * image_color and image_mono
+     */
+    uint32_t getNumSubscribersConverted() const;
+
+    /**
+     * Grabs an image and stores the image in img_raw_ptr_
      * @return false if an error occurred.
      */
     virtual bool grabImage();
 
+    /**
+     * Fills the meta data (header, encoding, geometry) of a grabbed frame
+     * from img_raw_msg_ and stores it in img_raw_ptr_. The grab mutex has to
+     * be locked.
+     * @param img the grabbed frame, only its data is set
+     * @param metadata the timestamps of the grabbed frame
+     */
+    void setupImageMsg(const sensor_msgs::ImagePtr& img,
+                       const FrameMetadata& metadata);
+
+    /**
+     * Determines the header stamp of a grabbed frame according to the
+     * timestamp mode. Falls back to the host stamp if the camera stamp is
+     * not available.
+     * @param metadata the metadata of the grabbed frame
+     * @return the stamp for the image header
+     */
+    ros::Time frameStamp(const FrameMetadata& metadata);
+
+    /**
+     * Checks the payload CRC of a grabbed frame, if the camera provides it
+     * and the check is enabled. Counts and reports corrupted frames.
+     * @param metadata the metadata of the grabbed frame
+     * @return false if the payload is corrupted
+     */
+    bool isPayloadValid(const FrameMetadata& metadata);
+
+    /**
+     * Counts the frames lost before a grabbed frame from the gap in the
+     * frame counter and publishes its chunk data on the frame_info topic.
+     * The grab mutex has to be locked.
+     * @param header the header of the image the metadata belongs to
+     * @param metadata the metadata of the grabbed frame
+     */
+    void publishFrameInfo(const std_msgs::Header& header,
+                          const FrameMetadata& metadata);
+
     /**
      * Fills the ros CameraInfo-Object with the image dimensions
      */
     virtual void setupInitialCameraInfo(sensor_msgs::CameraInfo& cam_info_msg);
 
     /**
-     * Update the horizontal binning_x factor to get downsampled images
-     * @param target_binning_x the target horizontal binning_x factor
-     * @param reached_binning_x the horizontal binning_x factor that could be
-     *        reached
-     * @return true if the targeted binning could be reached
+     * Applies a batch of settings in one transaction of the camera and
+     * updates the CameraInfo, the image message and the sampling indices
+     * once afterwards. Retries till a timeout if the transaction fails
+     * because of temporary errors, unsupported settings fail right away.
+     * @param target the settings to apply, only the flagged ones are changed
+     * @param reached all settings of the camera after the transaction
+     * @return true if all targeted settings could be applied
+     */
+    bool reconfigure(const CameraConfiguration& target,
+                     CameraConfiguration& reached);
+
+    /**
+     * Updates the binning and the roi of the CameraInfo, the size and
+     * encoding of the image message and the sampling indices of the
+     * brightness search from the current settings of the camera
+     */
+    void updateImageGeometry();
+
+    /**
+     * Copies the CameraInfo of the camera_info_manager into the cache. The
+     * manager doesn't notify about 'set_camera_info'-service calls, hence the
+     * publishing thread polls it twice a second, whereas the node's own
+     * changes force the update.
+     * @param force if false, the manager is only read if the poll period
+     *        elapsed. Only the publishing thread may pass false.
+     */
+    void refreshCameraInfoCache(const bool& force);
+
+    /**
+     * Sets the roi of the CameraInfo to the region of interest of the
+     * camera, in unbinned pixels according to the binning of the msg. All
+     * values are 0 if the region covers the full image.
+     * @param cam_info_msg the CameraInfo to update
      */
-    bool setBinningX(const size_t& target_binning_x,
-                     size_t& reached_binning_x);
+    void setCameraInfoROI(sensor_msgs::CameraInfo& cam_info_msg);
 
     /**
-     * Update the vertical binning_y factor to get downsampled images
-     * @param target_binning_y the target vertical binning_y factor
-     * @param reached_binning_y the vertical binning_y factor that could be
-     *        reached
-     * @return true if the targeted binning could be reached
+     * Records the settings of a successful transaction in the parameter set,
+     * so that they are restored after a device removal
+     * @param target the settings that have been applied
+     * @param reached the settings of the camera after the transaction
      */
-    bool setBinningY(const size_t& target_binning_y,
-                     size_t& reached_binning_y);
+    void rememberConfiguration(const CameraConfiguration& target,
+                               const CameraConfiguration& reached);
 
     /**
      * Service callback for updating the cameras binning setting
@@ -165,6 +413,36 @@ protected:
      */
     bool setBinningCallback(camera_control_msgs::SetBinning::Request &req,
                             camera_control_msgs::SetBinning::Response &res);
+
+    /**
+     * Service callback for updating the cameras decimation setting. It uses
+     * the binning service type, whose factors are the decimation factors.
+     * @param req request
+     * @param res response
+     * @return true on success
+     */
+    bool setDecimationCallback(camera_control_msgs::SetBinning::Request &req,
+                               camera_control_msgs::SetBinning::Response &res);
+
+    /**
+     * Service callback for applying several settings at once, with a single
+     * restart of grabbing for those that need a stopped stream
+     * @param req request
+     * @param res response
+     * @return true on success
+     */
+    bool setConfigurationCallback(pylon_camera::SetConfiguration::Request &req,
+                                  pylon_camera::SetConfiguration::Response &res);
+
+    /**
+     * Service callback for updating the region of interest of the camera
+     * @param req request
+     * @param res response
+     * @return true on success
+     */
+    bool setROICallback(pylon_camera::SetROI::Request &req,
+                        pylon_camera::SetROI::Response &res);
+
     /**
      * Update the exposure value on the camera
      * @param target_exposure the targeted exposure
@@ -183,23 +461,44 @@ protected:
                              camera_control_msgs::SetExposure::Response &res);
 
     /**
-     * Sets the target brightness which is the intensity-mean over all pixels.
+     * Sets the target brightness which is the intensity-mean of the pixels
+     * weighted by the metering mode.
      * If the target exposure time is not in the range of Pylon's auto target
      * brightness range the extended brightness search is started.
      * The Auto function of the Pylon-API supports values from [50 - 205].
      * Using a binary search, this range will be extended up to [1 - 255].
+     * The auto function meters the whole image, hence its target is scaled
+     * by the ratio of the image mean and the metered mean.
      * @param target_brightness is the desired brightness. Range is [1...255].
      * @param current_brightness is the current brightness with the given settings.
      * @param exposure_auto flag which indicates if the target_brightness
      *                      should be reached adapting the exposure time
      * @param gain_auto flag which indicates if the target_brightness should be
      *                      reached adapting the gain.
+     * @param mode the metering mode
+     * @param roi the region of the image metered by MM_ROI
      * @return true if the brightness could be reached or false otherwise.
      */
     bool setBrightness(const int& target_brightness,
                        int& reached_brightness,
                        const bool& exposure_auto,
-                       const bool& gain_auto);
+                       const bool& gain_auto,
+                       const METERING_MODE& mode,
+                       const sensor_msgs::RegionOfInterest& roi);
+
+    /**
+     * Reaches the brightness for the brightness services, enables the
+     * continuous auto functions if requested and remembers the brightness for
+     * the recovery after a device removal
+     * @return true if the brightness could be reached
+     */
+    bool reachBrightness(const int& target_brightness,
+                         const bool& brightness_continuous,
+                         const bool& exposure_auto,
+                         const bool& gain_auto,
+                         const METERING_MODE& mode,
+                         const sensor_msgs::RegionOfInterest& roi,
+                         int& reached_brightness);
 
     /**
      * Service callback for setting the brightness
@@ -210,6 +509,15 @@ protected:
     bool setBrightnessCallback(camera_control_msgs::SetBrightness::Request &req,
                                camera_control_msgs::SetBrightness::Response &res);
 
+    /**
+     * Service callback for setting the brightness with a metering mode
+     * @param req request
+     * @param res response
+     * @return true on success
+     */
+    bool setMeteredBrightnessCallback(pylon_camera::SetMeteredBrightness::Request &req,
+                                      pylon_camera::SetMeteredBrightness::Response &res);
+
     /**
      * Update the gain from the camera to a target gain in percent
      * @param target_gain the targeted gain in percent
@@ -254,38 +562,39 @@ protected:
                              camera_control_msgs::SetSleeping::Response &res);
 
     /**
-     * Returns true if the camera was put into sleep mode
-     * @return true if in sleep mode
+     * Callback that switches the recording of the pipeline statistics
+     * @param req request, data enables or disables the recording
+     * @param res response
+     * @return true on success
      */
-    bool isSleeping();
+    bool enableStatisticsCallback(camera_control_msgs::SetBool::Request &req,
+                                  camera_control_msgs::SetBool::Response &res);
 
     /**
-     * Generates the subset of points on which the brightness search will be
-     * executed in order to speed it up. The subset are the indices of the
-     * one-dimensional image_raw data vector. The base generation is done in a
-     * recursive manner, by calling genSamplingIndicesRec
-     * @return indices describing the subset of points
+     * Publishes the latency percentiles and frame counters recorded since
+     * the last call on the statistics topic and on /diagnostics
      */
-    void setupSamplingIndices(std::vector<std::size_t>& indices,
-                              std::size_t rows,
-                              std::size_t cols,
-                              int downsampling_factor);
+    void publishStatistics(const ros::WallTimerEvent& event);
 
     /**
-     * This function will recursively be called from above setupSamplingIndices()
-     * to generate the indices of pixels given the actual ROI.
-     * @return indices describing the subset of points
+     * Returns true if the camera was put into sleep mode
+     * @return true if in sleep mode
      */
-    void genSamplingIndicesRec(std::vector<std::size_t>& indices,
-                               const std::size_t& min_window_height,
-                               const cv::Point2i& start,
-                               const cv::Point2i& end);
+    bool isSleeping();
 
     /**
-     * Calculates the mean brightness of the image based on the subset indices
-     * @return the mean brightness of the image
+     * Calculates the mean brightness of the last grabbed image on the grid
+     * given by the metering_grid_step parameter. The weight mask of the
+     * metering mode is only rebuilt if the mode, the region or the image size
+     * changed.
+     * @param mode the metering mode
+     * @param roi the region of the image metered by MM_ROI
+     * @param image_brightness the unweighted mean of the image
+     * @return the metered brightness of the image
      */
-    float calcCurrentBrightness();
+    float calcCurrentBrightness(const METERING_MODE& mode,
+                                const sensor_msgs::RegionOfInterest& roi,
+                                float& image_brightness);
 
     /**
      * Callback for the grab images action
@@ -331,33 +640,103 @@ protected:
     ros::NodeHandle nh_;
     PylonCameraParameter pylon_camera_parameter_set_;
     ros::ServiceServer set_binning_srv_;
+    ros::ServiceServer set_decimation_srv_;
     ros::ServiceServer set_exposure_srv_;
     ros::ServiceServer set_gain_srv_;
     ros::ServiceServer set_gamma_srv_;
     ros::ServiceServer set_brightness_srv_;
+    ros::ServiceServer set_metered_brightness_srv_;
     ros::ServiceServer set_sleeping_srv_;
+    ros::ServiceServer enable_statistics_srv_;
+    ros::ServiceServer set_configuration_srv_;
+    ros::ServiceServer set_roi_srv_;
     std::vector<ros::ServiceServer> set_user_output_srvs_;
 
     PylonCamera* pylon_camera_;
 
     image_transport::ImageTransport* it_;
     image_transport::CameraPublisher img_raw_pub_;
+    image_transport::Publisher img_color_pub_;
+    image_transport::Publisher img_mono_pub_;
 
     ros::Publisher* img_rect_pub_;
-    image_geometry::PinholeCameraModel* pinhole_model_;
+    Rectifier* rectifier_;
+
+    // immutable copy of the CameraInfo, which is published with every frame
+    CameraInfoCache camera_info_cache_;
+    ros::WallTime next_camera_info_refresh_;
 
     GrabImagesAS grab_imgs_raw_as_;
     GrabImagesAS* grab_imgs_rect_as_;
 
+    // holds the meta data (header, encoding, geometry) of the raw image
     sensor_msgs::Image img_raw_msg_;
-    cv_bridge::CvImage* cv_bridge_img_rect_;
+    // the last grabbed image, its data is not copied from the grab buffer
+    sensor_msgs::ImagePtr img_raw_ptr_;
+
+    // hands over the grabbed frames from the acquisition thread to spin()
+    FrameRing<sensor_msgs::ImagePtr>* frame_ring_;
+    boost::thread acquisition_thread_;
+    std::atomic<bool> stop_acquisition_;
+    ros::WallTime next_clock_sync_;
+    uint64_t last_num_dropped_;
+    // frames of the event-driven grabbing which arrived while the grab mutex
+    // was held by a reconfiguration, an action or the brightness search
+    std::atomic<uint64_t> num_skipped_;
+    // guards the frame ring against being replaced while a worker
+    // publishes the pending frames
+    boost::mutex publish_mutex_;
+    boost::mutex frame_ready_mutex_;
+    boost::function<void ()> frame_ready_cb_;
+
+    // latency histograms and frame counters of the pipeline stages
+    PipelineStatistics statistics_;
+    ros::Publisher statistics_pub_;
+    ros::Publisher diagnostics_pub_;
+    ros::WallTimer statistics_timer_;
+    uint64_t statistics_num_dropped_;
+
+    // chunk data of the grabbed frames, the last frame counter is used to
+    // detect lost frames and guarded by the grab mutex
+    ros::Publisher frame_info_pub_;
+    bool has_last_frame_counter_;
+    uint64_t last_frame_counter_;
+
+    // recovers the camera in the background after it has been removed. The
+    // flags are guarded by recovery_mutex_
+    boost::thread recovery_thread_;
+    boost::mutex recovery_mutex_;
+    boost::condition_variable recovery_cond_;
+    bool camera_removed_;
+    bool stop_recovery_;
+    std::atomic<bool> is_recovering_;
+
+    // feature snapshot of the configured camera, the flag indicates if the
+    // camera has been configured by restoring it
+    std::string startup_snapshot_dir_;
+    std::string startup_snapshot_file_;
+    bool snapshot_restored_;
+
+    // cold start time, the flag is guarded by publish_mutex_
+    ros::WallTime startup_time_;
+    bool first_frame_published_;
 
     camera_info_manager::CameraInfoManager* camera_info_manager_;
 
-    std::vector<std::size_t> sampling_indices_;
     std::array<float, 256> brightness_exp_lut_;
+    // the exposures of the lut are only valid for the metering they were
+    // reached with
+    METERING_MODE brightness_exp_lut_mode_;
+    sensor_msgs::RegionOfInterest brightness_exp_lut_roi_;
+
+    // replaced whenever the metering changes, the metering runs on a copy of
+    // the pointer
+    boost::shared_ptr<const metering::WeightMask> metering_mask_;
 
     bool is_sleeping_;
+    bool is_initialized_;
+    bool shutdown_on_error_;
+    boost::function<bool ()> stop_requested_;
     boost::recursive_mutex grab_mutex_;
 };
 
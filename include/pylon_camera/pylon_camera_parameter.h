@@ -33,6 +33,7 @@
 #include <string>
 #include <vector>
 #include <ros/ros.h>
+#include <sensor_msgs/RegionOfInterest.h>
 
 namespace pylon_camera
 {
@@ -45,6 +46,49 @@ enum SHUTTER_MODE
     SM_DEFAULT =  -1,
 };
 
+enum ACQUISITION_MODE
+{
+    AM_SOFTWARE_TRIGGER = 0,
+    AM_FREE_RUN_ONE_BY_ONE = 1,
+    AM_FREE_RUN_LATEST_IMAGE_ONLY = 2,
+    AM_PIPELINED_SOFTWARE_TRIGGER = 3,
+};
+
+enum TIMESTAMP_MODE
+{
+    TM_HOST = 0,
+    TM_EXPOSURE_START = 1,
+    TM_EXPOSURE_MID = 2,
+};
+
+enum OVERFLOW_POLICY
+{
+    OP_DROP_OLDEST = 0,
+    OP_DROP_NEWEST = 1,
+    OP_BLOCK = 2,
+};
+
+enum DEMOSAICING_ALGORITHM
+{
+    DA_BILINEAR = 0,
+    DA_EDGE_AWARE = 1,
+};
+
+enum DOWNSAMPLING_PREFERENCE
+{
+    DP_SNR = 0,
+    DP_FRAME_RATE = 1,
+};
+
+enum METERING_MODE
+{
+    MM_AVERAGE = 0,
+    MM_CENTER_WEIGHTED = 1,
+    MM_SPOT = 2,
+    MM_ROI = 3,
+    MM_MATRIX = 4,
+};
+
 /**
  * Parameter class for the PylonCamera
  */
@@ -79,6 +123,39 @@ public:
      */
     std::string shutterModeString() const;
 
+    /**
+     * Getter for the string describing the acquisition mode
+     */
+    std::string acquisitionModeString() const;
+
+    /**
+     * Getter for the string describing the overflow policy of the frame ring
+     */
+    std::string overflowPolicyString() const;
+
+    /**
+     * Getter for the string describing the timestamp mode
+     */
+    std::string timestampModeString() const;
+
+    /**
+     * Getter for the string describing the downsampling preference
+     */
+    std::string downsamplingPreferenceString() const;
+
+    /**
+     * Getter for the string describing the demosaicing algorithm
+     */
+    std::string demosaicingAlgorithmString() const;
+
+    /**
+     * Hash of all parameters that determine the configuration of the camera
+     * at startup. Together with the serial number it identifies a feature
+     * snapshot of the fully configured camera.
+     * @return the hash as hexadecimal string
+     */
+    std::string startupSnapshotHash() const;
+
     /**
      * Getter for the camera_frame_ set from ros-parameter server
      */
@@ -94,6 +171,13 @@ public:
      */
     const std::string& imageEncoding() const;
 
+    /**
+     * Setter for the image_encoding_ initially set from ros-parameter server
+     * The encoding needs to be updated if it has been changed at runtime
+     */
+    void setImageEncoding(const ros::NodeHandle& nh,
+                          const std::string& image_encoding);
+
     /**
      * Setter for the frame_rate_ initially set from ros-parameter server
      * The frame rate needs to be updated with the value the camera supports
@@ -113,6 +197,27 @@ public:
                           const std::string& camera_info_url);
 
 public:
+    /**
+     * Serial number of the camera to open. Only the devices of one transport
+     * layer with this serial number are enumerated, which is faster than
+     * searching the DeviceUserID. Takes precedence over the DeviceUserID.
+     */
+    std::string serial_number_;
+
+    /**
+     * IP address of the GigE camera to open. The camera is found by unicast
+     * device discovery without any enumeration, also in other subnets. Takes
+     * precedence over the serial number and the DeviceUserID.
+     */
+    std::string ip_address_;
+
+    /**
+     * Restricts the search for the camera to the transport layer of this
+     * device class, either 'BaslerGigE' or 'BaslerUsb'. If empty, all
+     * transport layers are searched.
+     */
+    std::string device_class_;
+
     /** Binning factor to get downsampled images. It refers here to any camera
      * setting which combines rectangular neighborhoods of pixels into larger
      * "super-pixels." It reduces the resolution of the output image to
@@ -131,11 +236,59 @@ public:
     bool binning_y_given_;
 
     /**
-     * Factor that describes the image downsampling to speed up the exposure
-     * search to find the desired brightness.
-     * The smallest window height is img_rows/downsampling_factor
+     * Decimation factors to get downsampled images. Unlike binning, the
+     * camera skips rows and columns instead of combining them, which
+     * reduces the readout time and hence raises the max frame rate, but
+     * doesn't improve the signal to noise ratio. 0 is considered the same
+     * as 1 (no decimation).
+     */
+    size_t decimation_x_;
+    size_t decimation_y_;
+
+    /**
+     * Flags which indicate if the decimation factors are provided and hence
+     * should be set during startup
+     */
+    bool decimation_x_given_;
+    bool decimation_y_given_;
+
+    /**
+     * Downsampling factors which are reached either by binning or by
+     * decimation, depending on the downsampling_preference_ and on what the
+     * camera supports. Explicitly given binning or decimation factors
+     * override the choice.
+     */
+    size_t downsampling_x_;
+    size_t downsampling_y_;
+
+    /**
+     * Flag which indicates if the downsampling factors are provided
+     */
+    bool downsampling_given_;
+
+    /**
+     * Whether downsampling should prefer binning for a better signal to
+     * noise ratio (DP_SNR) or decimation for a higher frame rate
+     * (DP_FRAME_RATE)
+     */
+    DOWNSAMPLING_PREFERENCE downsampling_preference_;
+
+    /**
+     * Region of interest on the sensor in pixels of the binned image. Only
+     * this window is read out and transferred, which reduces the bandwidth
+     * and raises the max frame rate. A width or height of 0 selects the
+     * maximum size.
+     */
+    size_t roi_offset_x_;
+    size_t roi_offset_y_;
+    size_t roi_width_;
+    size_t roi_height_;
+
+    /**
+     * Flag which indicates if any of the roi parameters is provided and hence
+     * the region of interest should be set during startup
      */
-    int downsampling_factor_exp_search_;
+    bool roi_given_;
 
     // #######################################################################
     // ###################### Image Intensity Settings  ######################
@@ -226,6 +379,25 @@ public:
      */
     bool exposure_auto_;
     bool gain_auto_;
+
+    /**
+     * The brightness search meters every metering_grid_step_-th pixel of
+     * every metering_grid_step_-th row. 1 meters the whole image.
+     */
+    size_t metering_grid_step_;
+
+    /**
+     * How the brightness search weights the pixels of the image, see
+     * metering::WeightMask. The set_metered_brightness service selects the
+     * mode per call and keeps it.
+     */
+    METERING_MODE metering_mode_;
+
+    /**
+     * Region of the image for the MM_ROI metering in pixels of the published
+     * image. A width or height of zero selects the rest of the image.
+     */
+    sensor_msgs::RegionOfInterest metering_roi_;
     // #######################################################################
 
     /**
@@ -262,6 +434,127 @@ public:
     */
     SHUTTER_MODE shutter_mode_;
 
+    /**
+     * Acquisition mode. In software-trigger mode every frame is triggered by
+     * the node with the desired frame rate. In the free-running modes the
+     * camera acquires continuously with its own (acquisition) frame rate and
+     * the node only retrieves the results, either one by one or only the
+     * latest one. The pipelined software-trigger mode keeps several triggers
+     * in flight, so that the exposure of the next frame overlaps with the
+     * transfer of the current one.
+     */
+    ACQUISITION_MODE acquisition_mode_;
+
+    /**
+     * Only relevant for the pipelined software-trigger mode: the max number
+     * of frames that are triggered, but not yet retrieved. It's limited by
+     * the MaxNumBuffer of the camera.
+     */
+    int triggers_in_flight_;
+
+    /**
+     * Only relevant for the free-running modes: if true, the grab loop
+     * thread of the pylon InstantCamera retrieves the frames and hands them
+     * to the node through an image event handler as soon as they arrive.
+     * Otherwise the acquisition thread of the node polls the camera with the
+     * desired frame rate.
+     */
+    bool event_driven_grabbing_;
+
+    /**
+     * Number of frames the ring between the acquisition thread and the
+     * publishing stage can hold. Each of these frames occupies one of the
+     * grab buffers, hence it should be smaller than the MaxNumBuffer of the
+     * camera (default 10).
+     */
+    int frame_ring_size_;
+
+    /**
+     * What to do if the publishing stage can't keep up and the frame ring is
+     * full: drop the oldest frame in the ring, drop the newly grabbed frame
+     * or block the acquisition till there is room again.
+     */
+    OVERFLOW_POLICY overflow_policy_;
+
+    /**
+     * Index of the CPU the acquisition thread (or the grab loop thread in
+     * event-driven grabbing) is pinned to, -1 to not pin it. Keeps the
+     * acquisition of several cameras in one process from competing for the
+     * same core.
+     */
+    int cpu_affinity_;
+
+    /**
+     * Which point in time the header stamp of the images refers to. The
+     * exposure start (or mid) is taken from the camera timestamp, mapped to
+     * ROS time by a clock model. Host mode stamps the images with the time
+     * they were retrieved from the camera, which includes the variable
+     * exposure and transfer latency. Host time is used as fallback, as long
+     * as the clock model is not synchronized.
+     */
+    TIMESTAMP_MODE timestamp_mode_;
+
+    /**
+     * Interval in seconds in which the camera clock gets latched to track the
+     * offset and drift between camera and ROS time.
+     */
+    double clock_sync_interval_;
+
+    /**
+     * Flag that indicates if the per-stage latency statistics are recorded
+     * from the start on. Can be switched at runtime by the
+     * 'enable_statistics' service.
+     */
+    bool enable_statistics_;
+
+    /**
+     * Interval in seconds in which the statistics are published
+     */
+    double statistics_interval_;
+
+    /**
+     * Flag that indicates if the camera appends chunk data (exposure time,
+     * gain, frame counter, timestamp and payload CRC) to every frame. The
+     * values are published on the 'frame_info' topic and replace GenApi
+     * reads of the current settings per frame.
+     */
+    bool enable_chunk_data_;
+
+    /**
+     * Flag that indicates if the payload of every frame is verified against
+     * the CRC checksum of the chunk data. This requires a pass over the
+     * whole image on the host.
+     */
+    bool check_payload_crc_;
+
+    /**
+     * Flag that indicates if the fully configured camera is saved as pylon
+     * feature snapshot (.pfs) keyed by its serial number and the startup
+     * parameters. A matching snapshot is restored at the next start in one
+     * bulk load instead of applying the settings one by one.
+     */
+    bool use_startup_snapshots_;
+
+    /**
+     * Directory of the feature snapshots. If empty, '$ROS_HOME/pylon_camera'
+     * is used.
+     */
+    std::string startup_snapshot_dir_;
+
+    /**
+     * Flag that indicates if the remap tables of the rectification are
+     * cached in memory-mapped files keyed by a hash of the calibration and
+     * geometry, so that a restart or a change back to a known binning
+     * doesn't recompute them.
+     */
+    bool use_rectification_cache_;
+
+    /**
+     * Directory of the cached remap tables. If empty, '$ROS_HOME/pylon_camera'
+     * is used.
+     */
+    std::string rectification_cache_dir_;
+
     /**
      * Flag that indicates if the camera has been calibrated and the intrinsic
      * calibration matrices are available
@@ -274,6 +567,19 @@ public:
      */
     bool auto_flash_;
 
+    /**
+     * Interpolation of the host-side demosaicing, which publishes Bayer
+     * images on 'image_color' and 'image_mono'
+     */
+    DEMOSAICING_ALGORITHM demosaicing_algorithm_;
+
+    /**
+     * Encoding of the demosaiced or converted yuv422 images on
+     * 'image_color', 'rgb8' or 'bgr8'.
+     * 16 bit Bayer images are demosaiced to 'rgb16' or 'bgr16'.
+     */
+    std::string color_encoding_;
+
 protected:
     /**
      * Validates the parameter set found on the ros parameter server.
@@ -313,7 +619,8 @@ protected:
      * The encoding of the pixels -- channel meaning, ordering, size taken
      * from the list of strings in include/sensor_msgs/image_encodings.h
      * The supported encodings are 'mono8', 'bgr8', 'rgb8', 'bayer_bggr8',
-     * 'bayer_gbrg8', 'bayer_rggb8' and 'yuv422'
+     * 'bayer_gbrg8', 'bayer_rggb8', 'yuv422', 'mono16' and 'bayer_*16'.
+     * The 16 bit encodings are transmitted as packed 12 or 10 bit pixels.
      */
     std::string image_encoding_;
 };
@@ -0,0 +1,142 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#ifndef PYLON_CAMERA_RECTIFIER_H
+#define PYLON_CAMERA_RECTIFIER_H
+
+#include <cstdint>
+#include <string>
+#include <boost/thread/mutex.hpp>
+#include <opencv2/core/core.hpp>
+#include <sensor_msgs/CameraInfo.h>
+#include <sensor_msgs/Image.h>
+
+namespace pylon_camera
+{
+
+/**
+ * Rectifies the raw images with remap tables, which are computed once per
+ * calibration and image geometry. The tables are stored in the fixed-point
+ * format of OpenCV (CV_16SC2 coordinates plus CV_16UC1 interpolation
+ * weights), which halves the memory traffic of the float maps. The raw image
+ * is wrapped without copying and the rows are remapped in parallel tiles,
+ * directly into the buffer of the rectified image.
+ * Computing the tables takes a noticeable fraction of a second for large
+ * sensors, hence they are optionally cached in files, which are keyed by a
+ * hash of the calibration and geometry and memory-mapped when reused.
+ */
+class Rectifier
+{
+public:
+    Rectifier();
+
+    ~Rectifier();
+
+    /**
+     * Sets the directory of the cached remap tables. The directory is created
+     * when the first tables are saved.
+     * @param dir the directory, an empty string disables the cache
+     */
+    void setCacheDirectory(const std::string& dir);
+
+    /**
+     * Rectifies the raw image. The remap tables are rebuilt if the camera
+     * info differs from the one they were built for, e.g. after a
+     * 'set_camera_info'-service call or a change of the binning or the ROI.
+     * The info must not be modified afterwards, passing the same message
+     * again skips the comparison.
+     * @param cam_info the calibration of the raw image
+     * @param raw the raw image
+     * @param rect the rectified image, its header is copied from the raw image
+     * @return false if the camera isn't calibrated, the distortion model is
+     *         unsupported or the size of the raw image doesn't match the
+     *         camera info
+     */
+    bool rectify(const sensor_msgs::CameraInfoConstPtr& cam_info,
+                 const sensor_msgs::Image& raw,
+                 sensor_msgs::Image& rect);
+
+    /**
+     * Discards the remap tables, they are rebuilt for the next image
+     */
+    void invalidate();
+
+    /**
+     * Number of rows remapped by one task of the parallel loop
+     */
+    static const int TILE_ROWS = 64;
+
+private:
+    /**
+     * True if the remap tables were built for the given camera info
+     */
+    bool isCurrent(const sensor_msgs::CameraInfo& cam_info) const;
+
+    /**
+     * Builds the remap tables for the binned ROI of the camera info, or maps
+     * them from the cache
+     */
+    bool buildMaps(const sensor_msgs::CameraInfo& cam_info);
+
+    /**
+     * Maps the cached tables of the given key into memory. A file that is
+     * truncated, has a wrong size, key or checksum is deleted.
+     * @return false if no valid tables of the given size are cached
+     */
+    bool loadMaps(const std::string& path,
+                  const uint64_t& key,
+                  const cv::Size& size);
+
+    /**
+     * Writes the tables to a temporary file that is renamed afterwards, so
+     * that a concurrent reader never sees a partial file
+     */
+    void saveMaps(const std::string& path, const uint64_t& key) const;
+
+    /**
+     * Releases the tables and unmaps the cache file they reference
+     */
+    void releaseMaps();
+
+    Rectifier(const Rectifier&);
+    Rectifier& operator=(const Rectifier&);
+
+    boost::mutex mutex_;
+    std::string cache_dir_;
+    void* mapped_data_;
+    size_t mapped_size_;
+    bool maps_valid_;
+    sensor_msgs::CameraInfoConstPtr maps_cam_info_;
+    cv::Mat map_coords_;
+    cv::Mat map_weights_;
+};
+
+}  // namespace pylon_camera
+
+#endif  // PYLON_CAMERA_RECTIFIER_H
@@ -0,0 +1,80 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#ifndef PYLON_CAMERA_SIMD_DISPATCH_H
+#define PYLON_CAMERA_SIMD_DISPATCH_H
+
+#include <string>
+
+// The SIMD kernels are compiled in for these platforms and selected at
+// runtime, hence the whole package is still built for the baseline ISA
+#if defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+#define PYLON_CAMERA_SIMD_X86
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define PYLON_CAMERA_SIMD_NEON
+#endif
+
+namespace pylon_camera
+{
+
+/**
+ * Runtime detection of the instruction sets the kernels of the packed pixel
+ * unpacking and of the metering are dispatched to
+ */
+namespace simd_dispatch
+{
+
+enum INSTRUCTION_SET
+{
+    IS_SCALAR = 0,
+    IS_SSE2 = 1,
+    IS_SSSE3 = 2,
+    IS_AVX2 = 3,
+    IS_NEON = 4,
+    NUM_INSTRUCTION_SETS = 5
+};
+
+/**
+ * The CPU is queried only once, the result is cached.
+ * @return true if the kernels of the instruction set are compiled in and the
+ *         CPU supports it. The scalar code is always supported.
+ */
+bool isSupported(const INSTRUCTION_SET& instruction_set);
+
+/**
+ * @return the name of the instruction set, e.g. 'avx2'
+ */
+std::string instructionSetName(const INSTRUCTION_SET& instruction_set);
+
+}  // namespace simd_dispatch
+}  // namespace pylon_camera
+
+#endif  // PYLON_CAMERA_SIMD_DISPATCH_H
@@ -0,0 +1,78 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#ifndef PYLON_CAMERA_UYVY_CONVERSIONS_H
+#define PYLON_CAMERA_UYVY_CONVERSIONS_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <string>
+#include <sensor_msgs/Image.h>
+
+namespace pylon_camera
+{
+
+/**
+ * Conversions of 'yuv422' images, which the camera sends as YUV422Packed:
+ * U0 Y0 V0 Y1 for every two pixels (UYVY).
+ */
+namespace uyvy_conversions
+{
+    /**
+     * Extracts the luma of UYVY pixels. Vectorized with SSE2 or NEON.
+     * @param src num_pixels UYVY pixels (2 byte each)
+     * @param dst num_pixels luma values
+     * @param num_pixels the number of pixels
+     */
+    void extractLuma(const uint8_t* src, uint8_t* dst, const std::size_t& num_pixels);
+
+    /**
+     * Converts a yuv422 image to mono8, which only keeps the luma and hence
+     * halves the size of the image.
+     * @param uyvy the yuv422 image
+     * @param mono the mono8 image, its header is copied
+     * @return false if the image isn't a yuv422 image
+     */
+    bool toMono(const sensor_msgs::Image& uyvy, sensor_msgs::Image& mono);
+
+    /**
+     * Converts a yuv422 image to a color image (ITU-R BT.601).
+     * @param uyvy the yuv422 image
+     * @param color_encoding 'rgb8' or 'bgr8'
+     * @param color the color image, its header is copied
+     * @return false if the image isn't a yuv422 image
+     */
+    bool toColor(const sensor_msgs::Image& uyvy,
+                 const std::string& color_encoding,
+                 sensor_msgs::Image& color);
+
+}  // namespace uyvy_conversions
+}  // namespace pylon_camera
+
+#endif  // PYLON_CAMERA_UYVY_CONVERSIONS_H
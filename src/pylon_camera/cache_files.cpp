@@ -0,0 +1,97 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include <pylon_camera/cache_files.h>
+#include <ros/ros.h>
+#include <sys/stat.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+namespace pylon_camera
+{
+
+namespace cache_files
+{
+
+std::string defaultCacheDir()
+{
+    const char* ros_home = std::getenv("ROS_HOME");
+    const char* home = std::getenv("HOME");
+    if ( ros_home )
+    {
+        return std::string(ros_home) + "/pylon_camera";
+    }
+    else if ( home )
+    {
+        return std::string(home) + "/.ros/pylon_camera";
+    }
+    return "";
+}
+
+bool createDirectories(const std::string& path, const std::string& purpose)
+{
+    std::size_t pos = 0;
+    do
+    {
+        pos = path.find('/', pos + 1);
+        const std::string dir = path.substr(0, pos);
+        if ( mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST )
+        {
+            ROS_WARN_STREAM("Couldn't create the directory " << dir
+                    << " for the " << purpose << ": " << std::strerror(errno));
+            return false;
+        }
+    }
+    while ( pos != std::string::npos );
+    return true;
+}
+
+uint64_t hash(const std::string& key)
+{
+    uint64_t result = FNV_OFFSET_BASIS;
+    for ( std::size_t i = 0; i < key.size(); ++i )
+    {
+        result ^= static_cast<uint8_t>(key[i]);
+        result *= FNV_PRIME;
+    }
+    return result;
+}
+
+std::string hashString(const uint64_t& hash)
+{
+    std::ostringstream ss;
+    ss << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return ss.str();
+}
+
+}  // namespace cache_files
+}  // namespace pylon_camera
@@ -0,0 +1,208 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include <pylon_camera/camera_clock_model.h>
+#include <algorithm>
+#include <cmath>
+
+namespace pylon_camera
+{
+
+namespace
+{
+// a latch round trip longer than this factor times the shortest one in the
+// window is considered to be an outlier
+const double MAX_ROUND_TRIP_FACTOR = 3.0;
+// ... but round trips below this value are always accepted
+const double MIN_ROUND_TRIP_LIMIT = 0.0005;
+// a sample that differs from the prediction by more than this (in seconds)
+// indicates a reset of the camera clock
+const double MAX_PREDICTION_ERROR = 0.01;
+}  // namespace
+
+CameraClockModel::CameraClockModel(const std::size_t& window_size)
+    : window_size_(std::max<std::size_t>(window_size, 2))
+    , tick_frequency_(1e9)
+    , ref_ticks_(0)
+    , ref_host_time_()
+    , samples_()
+    , round_trips_()
+    , offset_(0.0)
+    , drift_(0.0)
+{}
+
+CameraClockModel::~CameraClockModel()
+{}
+
+void CameraClockModel::reset(const double& tick_frequency)
+{
+    if ( tick_frequency > 0.0 )
+    {
+        tick_frequency_ = tick_frequency;
+    }
+    samples_.clear();
+    round_trips_.clear();
+    offset_ = 0.0;
+    drift_ = 0.0;
+}
+
+bool CameraClockModel::addSample(const uint64_t& ticks,
+                                 const ros::Time& host_before,
+                                 const ros::Time& host_after)
+{
+    if ( host_after < host_before )
+    {
+        return false;
+    }
+    const double round_trip = (host_after - host_before).toSec();
+    // the latch happened somewhere in between
+    const ros::Time host_time = host_before + ros::Duration(0.5 * round_trip);
+
+    if ( !samples_.empty() )
+    {
+        bool clock_reset = ticks < ref_ticks_;
+        if ( !clock_reset )
+        {
+            const double predicted = offset_ + (1.0 + drift_) * cameraTime(ticks);
+            const double error = (host_time - ref_host_time_).toSec() - predicted;
+            clock_reset = std::fabs(error) > MAX_PREDICTION_ERROR + round_trip;
+        }
+        if ( clock_reset )
+        {
+            ROS_WARN_STREAM("Camera clock jumped, resetting the clock model");
+            samples_.clear();
+            round_trips_.clear();
+        }
+    }
+
+    // the shortest round trip of the previous samples, the current one is
+    // added afterwards so that even rejected samples age the minimum out
+    const double min_round_trip = round_trips_.empty() ? round_trip :
+            *std::min_element(round_trips_.begin(), round_trips_.end());
+    round_trips_.push_back(round_trip);
+    while ( round_trips_.size() > window_size_ )
+    {
+        round_trips_.pop_front();
+    }
+
+    if ( samples_.empty() )
+    {
+        ref_ticks_ = ticks;
+        ref_host_time_ = host_time;
+    }
+    else if ( round_trip > MIN_ROUND_TRIP_LIMIT &&
+              round_trip > MAX_ROUND_TRIP_FACTOR * min_round_trip )
+    {
+        ROS_DEBUG_STREAM("Rejecting clock sample with a round trip of "
+                << round_trip * 1e3 << "ms");
+        return false;
+    }
+
+    Sample sample;
+    sample.camera_time = cameraTime(ticks);
+    sample.host_time = (host_time - ref_host_time_).toSec();
+    sample.round_trip = round_trip;
+    samples_.push_back(sample);
+    while ( samples_.size() > window_size_ )
+    {
+        samples_.pop_front();
+    }
+
+    fit();
+    return true;
+}
+
+bool CameraClockModel::isValid() const
+{
+    return !samples_.empty();
+}
+
+ros::Time CameraClockModel::toRosTime(const uint64_t& ticks) const
+{
+    if ( !isValid() )
+    {
+        return ros::Time();
+    }
+    // ticks before the reference (e.g. frames exposed right before the
+    // first latch) result in a negative camera time
+    const double camera_time = ticks >= ref_ticks_ ?
+                cameraTime(ticks) :
+                -static_cast<double>(ref_ticks_ - ticks) / tick_frequency_;
+    return ref_host_time_ + ros::Duration(offset_ + (1.0 + drift_) * camera_time);
+}
+
+const double& CameraClockModel::drift() const
+{
+    return drift_;
+}
+
+const double& CameraClockModel::tickFrequency() const
+{
+    return tick_frequency_;
+}
+
+std::size_t CameraClockModel::numSamples() const
+{
+    return samples_.size();
+}
+
+double CameraClockModel::cameraTime(const uint64_t& ticks) const
+{
+    return static_cast<double>(ticks - ref_ticks_) / tick_frequency_;
+}
+
+void CameraClockModel::fit()
+{
+    const double n = static_cast<double>(samples_.size());
+    double mean_camera = 0.0;
+    double mean_host = 0.0;
+    for ( const Sample& sample : samples_ )
+    {
+        mean_camera += sample.camera_time;
+        mean_host += sample.host_time;
+    }
+    mean_camera /= n;
+    mean_host /= n;
+
+    double cov = 0.0;
+    double var = 0.0;
+    for ( const Sample& sample : samples_ )
+    {
+        const double dc = sample.camera_time - mean_camera;
+        cov += dc * (sample.host_time - mean_host);
+        var += dc * dc;
+    }
+
+    // a single sample (or samples without spread) only provides the offset
+    const double slope = var > 0.0 ? cov / var : 1.0;
+    drift_ = slope - 1.0;
+    offset_ = mean_host - slope * mean_camera;
+}
+
+}  // namespace pylon_camera
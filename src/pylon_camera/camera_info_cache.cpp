@@ -0,0 +1,134 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include <pylon_camera/camera_info_cache.h>
+
+namespace pylon_camera
+{
+
+namespace
+{
+
+/**
+ * Compares the content of two infos, the stamp is ignored
+ */
+bool isEqual(const sensor_msgs::CameraInfo& a, const sensor_msgs::CameraInfo& b)
+{
+    return a.header.frame_id == b.header.frame_id &&
+           a.height == b.height &&
+           a.width == b.width &&
+           a.distortion_model == b.distortion_model &&
+           a.D == b.D &&
+           a.K == b.K &&
+           a.R == b.R &&
+           a.P == b.P &&
+           a.binning_x == b.binning_x &&
+           a.binning_y == b.binning_y &&
+           a.roi.x_offset == b.roi.x_offset &&
+           a.roi.y_offset == b.roi.y_offset &&
+           a.roi.height == b.roi.height &&
+           a.roi.width == b.roi.width &&
+           a.roi.do_rectify == b.roi.do_rectify;
+}
+
+}  // namespace
+
+CameraInfoCache::CameraInfoCache()
+    : mutex_()
+    , info_()
+    , version_(0)
+    , published_()
+    , published_versions_()
+{}
+
+bool CameraInfoCache::update(const sensor_msgs::CameraInfo& cam_info)
+{
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    if ( info_ && isEqual(*info_, cam_info) )
+    {
+        return false;
+    }
+    sensor_msgs::CameraInfoPtr info(new sensor_msgs::CameraInfo(cam_info));
+    info->header.stamp = ros::Time();
+    info_ = info;
+    ++version_;
+    return true;
+}
+
+sensor_msgs::CameraInfoConstPtr CameraInfoCache::info() const
+{
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    return info_;
+}
+
+uint64_t CameraInfoCache::version() const
+{
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    return version_;
+}
+
+bool CameraInfoCache::isCalibrated() const
+{
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    // same criterion as camera_info_manager
+    return info_ && info_->K[0] != 0.0;
+}
+
+sensor_msgs::CameraInfoPtr CameraInfoCache::stamped(const ros::Time& stamp)
+{
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    if ( !info_ )
+    {
+        return sensor_msgs::CameraInfoPtr();
+    }
+    for ( std::size_t i = 0; i < published_.size(); ++i )
+    {
+        // only this cache references the message, no subscriber can read it
+        if ( published_[i].use_count() == 1 )
+        {
+            if ( published_versions_[i] != version_ )
+            {
+                *published_[i] = *info_;
+                published_versions_[i] = version_;
+            }
+            published_[i]->header.stamp = stamp;
+            return published_[i];
+        }
+    }
+    sensor_msgs::CameraInfoPtr msg(new sensor_msgs::CameraInfo(*info_));
+    msg->header.stamp = stamp;
+    if ( published_.size() < MAX_RECYCLED )
+    {
+        published_.push_back(msg);
+        published_versions_.push_back(version_);
+    }
+    return msg;
+}
+
+}  // namespace pylon_camera
@@ -0,0 +1,142 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+/*
+ This program measures the host-side demosaicing of Bayer images, which the
+ pylon_camera_node publishes on image_color and image_mono, for 5 MP and
+ 12 MP frames. No camera is needed, the frames are synthetic.
+
+ USAGE: rosrun pylon_camera demosaic_benchmark _iterations:=50
+*/
+
+#include <ros/ros.h>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <sensor_msgs/image_encodings.h>
+#include <opencv2/core/core.hpp>
+#include <pylon_camera/demosaicing.h>
+
+namespace
+{
+
+/**
+ * @return a bayer_rggb8 frame with a gradient and some texture, so that the
+ *         edge-aware interpolation doesn't take shortcuts
+ */
+sensor_msgs::Image syntheticFrame(const int& width, const int& height)
+{
+    sensor_msgs::Image bayer;
+    bayer.width = width;
+    bayer.height = height;
+    bayer.encoding = sensor_msgs::image_encodings::BAYER_RGGB8;
+    bayer.step = width;
+    bayer.data.resize(static_cast<std::size_t>(width) * height);
+    for ( int row = 0; row < height; ++row )
+    {
+        for ( int col = 0; col < width; ++col )
+        {
+            bayer.data[static_cast<std::size_t>(row) * width + col] =
+                static_cast<uint8_t>((row + col) / 16 + ((row * 7 + col * 13) % 32));
+        }
+    }
+    return bayer;
+}
+
+/**
+ * @return the mean duration of a conversion in ms
+ */
+double benchmark(const sensor_msgs::Image& bayer,
+                 const int& iterations,
+                 const pylon_camera::DEMOSAICING_ALGORITHM& algorithm,
+                 const bool& mono)
+{
+    sensor_msgs::Image color;
+    sensor_msgs::Image gray;
+    // warm up the caches and the thread pool
+    pylon_camera::demosaicing::toColor(bayer, algorithm,
+                                       sensor_msgs::image_encodings::RGB8, color);
+    const ros::WallTime start = ros::WallTime::now();
+    for ( int i = 0; i < iterations; ++i )
+    {
+        if ( mono )
+        {
+            pylon_camera::demosaicing::toMono(bayer, gray);
+        }
+        else
+        {
+            pylon_camera::demosaicing::toColor(bayer, algorithm,
+                                               sensor_msgs::image_encodings::RGB8,
+                                               color);
+        }
+    }
+    const double duration = (ros::WallTime::now() - start).toSec();
+    return iterations > 0 ? 1e3 * duration / iterations : 0.0;
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    ros::init(argc, argv, "pylon_camera_demosaic_benchmark");
+    ros::NodeHandle nh("~");
+
+    int iterations;
+    nh.param<int>("iterations", iterations, 50);
+
+    struct FrameSize
+    {
+        const char* name;
+        int width;
+        int height;
+    };
+    const FrameSize frame_sizes[] = { { "5 MP", 2448, 2048 },
+                                      { "12 MP", 4096, 3000 } };
+
+    ROS_INFO_STREAM("Demosaicing with " << cv::getNumThreads() << " threads");
+    for ( const FrameSize& size : frame_sizes )
+    {
+        const sensor_msgs::Image bayer = syntheticFrame(size.width, size.height);
+        const double megapixels = size.width * size.height / 1e6;
+        const double bilinear_ms = benchmark(bayer, iterations,
+                                             pylon_camera::DA_BILINEAR, false);
+        const double edge_aware_ms = benchmark(bayer, iterations,
+                                               pylon_camera::DA_EDGE_AWARE, false);
+        const double mono_ms = benchmark(bayer, iterations,
+                                         pylon_camera::DA_BILINEAR, true);
+        ROS_INFO_STREAM(size.name << " (" << size.width << "x" << size.height
+                << "): bilinear " << bilinear_ms << " ms ("
+                << megapixels / bilinear_ms * 1e3 << " MP/s), edge_aware "
+                << edge_aware_ms << " ms (" << megapixels / edge_aware_ms * 1e3
+                << " MP/s), mono " << mono_ms << " ms ("
+                << megapixels / mono_ms * 1e3 << " MP/s), "
+                << iterations << " iterations");
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,174 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include <pylon_camera/demosaicing.h>
+#include <sensor_msgs/image_encodings.h>
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+namespace pylon_camera
+{
+
+namespace demosaicing
+{
+
+namespace
+{
+
+namespace enc = sensor_msgs::image_encodings;
+
+/**
+ * OpenCV names the patterns by the second row, hence the index of the ROS
+ * pattern into the tables of conversion codes is: RGGB, BGGR, GBRG, GRBG
+ */
+int patternIndex(const std::string& encoding)
+{
+    if ( encoding == enc::BAYER_RGGB8 || encoding == enc::BAYER_RGGB16 )
+    {
+        return 0;
+    }
+    else if ( encoding == enc::BAYER_BGGR8 || encoding == enc::BAYER_BGGR16 )
+    {
+        return 1;
+    }
+    else if ( encoding == enc::BAYER_GBRG8 || encoding == enc::BAYER_GBRG16 )
+    {
+        return 2;
+    }
+    else if ( encoding == enc::BAYER_GRBG8 || encoding == enc::BAYER_GRBG16 )
+    {
+        return 3;
+    }
+    return -1;
+}
+
+const int BAYER_TO_RGB[4] = { cv::COLOR_BayerBG2RGB, cv::COLOR_BayerRG2RGB,
+                              cv::COLOR_BayerGR2RGB, cv::COLOR_BayerGB2RGB };
+const int BAYER_TO_BGR[4] = { cv::COLOR_BayerBG2BGR, cv::COLOR_BayerRG2BGR,
+                              cv::COLOR_BayerGR2BGR, cv::COLOR_BayerGB2BGR };
+const int BAYER_TO_RGB_EA[4] = { cv::COLOR_BayerBG2RGB_EA, cv::COLOR_BayerRG2RGB_EA,
+                                 cv::COLOR_BayerGR2RGB_EA, cv::COLOR_BayerGB2RGB_EA };
+const int BAYER_TO_BGR_EA[4] = { cv::COLOR_BayerBG2BGR_EA, cv::COLOR_BayerRG2BGR_EA,
+                                 cv::COLOR_BayerGR2BGR_EA, cv::COLOR_BayerGB2BGR_EA };
+const int BAYER_TO_GRAY[4] = { cv::COLOR_BayerBG2GRAY, cv::COLOR_BayerRG2GRAY,
+                               cv::COLOR_BayerGR2GRAY, cv::COLOR_BayerGB2GRAY };
+
+/**
+ * Wraps the data of the message without copying it
+ */
+cv::Mat wrap(const sensor_msgs::Image& img, const int& channels)
+{
+    const int depth = enc::bitDepth(img.encoding) == 16 ? CV_16U : CV_8U;
+    return cv::Mat(img.height, img.width, CV_MAKETYPE(depth, channels),
+                   const_cast<uint8_t*>(img.data.data()), img.step);
+}
+
+/**
+ * Allocates the data of the message and wraps it
+ */
+cv::Mat allocate(const sensor_msgs::Image& src,
+                 const std::string& encoding,
+                 sensor_msgs::Image& dst)
+{
+    dst.header = src.header;
+    dst.height = src.height;
+    dst.width = src.width;
+    dst.encoding = encoding;
+    dst.is_bigendian = src.is_bigendian;
+    dst.step = src.width * enc::numChannels(encoding) * (enc::bitDepth(encoding) / 8);
+    dst.data.resize(static_cast<std::size_t>(dst.step) * dst.height);
+    return wrap(dst, enc::numChannels(encoding));
+}
+
+}  // namespace
+
+bool toColor(const sensor_msgs::Image& bayer,
+             const DEMOSAICING_ALGORITHM& algorithm,
+             const std::string& color_encoding,
+             sensor_msgs::Image& color)
+{
+    const int pattern = patternIndex(bayer.encoding);
+    if ( pattern < 0 || bayer.data.empty() )
+    {
+        return false;
+    }
+    const bool bgr = color_encoding == enc::BGR8 || color_encoding == enc::BGR16;
+    const bool is_16_bit = enc::bitDepth(bayer.encoding) == 16;
+    const std::string encoding = bgr ? ( is_16_bit ? enc::BGR16 : enc::BGR8 ) :
+                                       ( is_16_bit ? enc::RGB16 : enc::RGB8 );
+    int code;
+    if ( algorithm == DA_EDGE_AWARE )
+    {
+        code = bgr ? BAYER_TO_BGR_EA[pattern] : BAYER_TO_RGB_EA[pattern];
+    }
+    else
+    {
+        code = bgr ? BAYER_TO_BGR[pattern] : BAYER_TO_RGB[pattern];
+    }
+    cv::Mat dst = allocate(bayer, encoding, color);
+    cv::cvtColor(wrap(bayer, 1), dst, code);
+    return true;
+}
+
+bool toMono(const sensor_msgs::Image& img, sensor_msgs::Image& mono)
+{
+    if ( img.data.empty() )
+    {
+        return false;
+    }
+    const bool is_16_bit = enc::bitDepth(img.encoding) == 16;
+    const std::string encoding = is_16_bit ? enc::MONO16 : enc::MONO8;
+    const int pattern = patternIndex(img.encoding);
+    int code;
+    int channels = 1;
+    if ( pattern >= 0 )
+    {
+        code = BAYER_TO_GRAY[pattern];
+    }
+    else if ( img.encoding == enc::RGB8 || img.encoding == enc::RGB16 )
+    {
+        code = cv::COLOR_RGB2GRAY;
+        channels = 3;
+    }
+    else if ( img.encoding == enc::BGR8 || img.encoding == enc::BGR16 )
+    {
+        code = cv::COLOR_BGR2GRAY;
+        channels = 3;
+    }
+    else
+    {
+        return false;
+    }
+    cv::Mat dst = allocate(img, encoding, mono);
+    cv::cvtColor(wrap(img, channels), dst, code);
+    return true;
+}
+
+}  // namespace demosaicing
+}  // namespace pylon_camera
@@ -73,20 +73,37 @@ bool ros2GenAPI(const std::string& ros_enc, std::string& gen_api_enc)
         
         gen_api_enc = "YUV422Packed";
     }
-    
+    // 16 bit images are transmitted as packed 12 bit pixels and unpacked on
+    // the host, which saves a quarter of the bandwidth
+    else if ( ros_enc == sensor_msgs::image_encodings::MONO16 )
+    {
+        gen_api_enc = "Mono12p";
+    }
+    else if ( ros_enc == sensor_msgs::image_encodings::BAYER_BGGR16 )
+    {
+        gen_api_enc = "BayerBG12p";
+    }
+    else if ( ros_enc == sensor_msgs::image_encodings::BAYER_GBRG16 )
+    {
+        gen_api_enc = "BayerGB12p";
+    }
+    else if ( ros_enc == sensor_msgs::image_encodings::BAYER_RGGB16 )
+    {
+        gen_api_enc = "BayerRG12p";
+    }
+    else if ( ros_enc == sensor_msgs::image_encodings::BAYER_GRBG16 )
+    {
+        gen_api_enc = "BayerGR12p";
+    }
     else
     {
         /* No gen-api pendant existant for following ROS-encodings:
-         * - sensor_msgs::image_encodings::MONO16
          * - sensor_msgs::image_encodings::BGRA8
          * - sensor_msgs::image_encodings::BGR16
          * - sensor_msgs::image_encodings::BGRA16
          * - sensor_msgs::image_encodings::RGBA8
          * - sensor_msgs::image_encodings::RGB16
          * - sensor_msgs::image_encodings::RGBA16
-         * - sensor_msgs::image_encodings::BAYER_BGGR16
-         * - sensor_msgs::image_encodings::BAYER_GBRG16
-         * - sensor_msgs::image_encodings::BAYER_GRBG16
          * - sensor_msgs::image_encodings::BAYER_GRBG8
          * - sensor_msgs::image_encodings::YUV422
          */
@@ -125,29 +142,40 @@ bool genAPI2Ros(const std::string& gen_api_enc, std::string& ros_enc)
     {
         ros_enc = sensor_msgs::image_encodings::YUV422;
     }
+    // packed pixels are unpacked to 16 bit, see packed_pixels.h
+    else if ( gen_api_enc == "Mono10p" || gen_api_enc == "Mono12p" )
+    {
+        ros_enc = sensor_msgs::image_encodings::MONO16;
+    }
+    else if ( gen_api_enc == "BayerBG10p" || gen_api_enc == "BayerBG12p" )
+    {
+        ros_enc = sensor_msgs::image_encodings::BAYER_BGGR16;
+    }
+    else if ( gen_api_enc == "BayerGB10p" || gen_api_enc == "BayerGB12p" )
+    {
+        ros_enc = sensor_msgs::image_encodings::BAYER_GBRG16;
+    }
+    else if ( gen_api_enc == "BayerRG10p" || gen_api_enc == "BayerRG12p" )
+    {
+        ros_enc = sensor_msgs::image_encodings::BAYER_RGGB16;
+    }
+    else if ( gen_api_enc == "BayerGR10p" || gen_api_enc == "BayerGR12p" )
+    {
+        ros_enc = sensor_msgs::image_encodings::BAYER_GRBG16;
+    }
     else
     {
         /* Unsupported are:
          * - Mono10
-         * - Mono10p
          * - Mono12
-         * - Mono12p
          * - BayerGR10
-         * - BayerGR10p
          * - BayerRG10
-         * - BayerRG10p
          * - BayerGB10
-         * - BayerGB10p
          * - BayerBG10
-         * - BayerBG10p
          * - BayerGR12
-         * - BayerGR12p
          * - BayerRG12
-         * - BayerRG12p
          * - BayerGB12
-         * - BayerGB12p
          * - BayerBG12
-         * - BayerBG12p
          * - YCbCr422_8
          */
         return false;
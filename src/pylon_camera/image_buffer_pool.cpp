@@ -0,0 +1,121 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include <ros/ros.h>
+#include <pylon_camera/image_buffer_pool.h>
+
+namespace pylon_camera
+{
+
+ImageBufferPool::ImageBufferPool()
+    : mutex_()
+    , buffers_in_use_()
+    , free_buffers_()
+    , next_buffer_context_(0)
+{}
+
+ImageBufferPool::~ImageBufferPool()
+{}
+
+uint8_t* ImageBufferPool::allocate(const std::size_t& buffer_size,
+                                   intptr_t& buffer_context)
+{
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    sensor_msgs::ImagePtr img;
+    // prefer a recycled buffer which does not need to be reallocated
+    for ( std::vector<sensor_msgs::ImagePtr>::iterator it = free_buffers_.begin();
+          it != free_buffers_.end();
+          ++it )
+    {
+        if ( (*it)->data.capacity() >= buffer_size )
+        {
+            img = *it;
+            free_buffers_.erase(it);
+            break;
+        }
+    }
+    if ( !img )
+    {
+        if ( !free_buffers_.empty() )
+        {
+            img = free_buffers_.back();
+            free_buffers_.pop_back();
+        }
+        else
+        {
+            img.reset(new sensor_msgs::Image());
+        }
+    }
+    img->data.resize(buffer_size);
+
+    buffer_context = next_buffer_context_++;
+    buffers_in_use_[buffer_context] = img;
+    return img->data.data();
+}
+
+void ImageBufferPool::release(const intptr_t& buffer_context)
+{
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    std::map<intptr_t, sensor_msgs::ImagePtr>::iterator it =
+                                        buffers_in_use_.find(buffer_context);
+    if ( it == buffers_in_use_.end() )
+    {
+        ROS_WARN_STREAM("Trying to release the unknown buffer " << buffer_context
+                << " to the image buffer pool");
+        return;
+    }
+    free_buffers_.push_back(it->second);
+    buffers_in_use_.erase(it);
+}
+
+sensor_msgs::ImagePtr ImageBufferPool::image(const intptr_t& buffer_context) const
+{
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    std::map<intptr_t, sensor_msgs::ImagePtr>::const_iterator it =
+                                        buffers_in_use_.find(buffer_context);
+    if ( it == buffers_in_use_.end() )
+    {
+        return sensor_msgs::ImagePtr();
+    }
+    return it->second;
+}
+
+std::size_t ImageBufferPool::numBuffersInUse() const
+{
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    return buffers_in_use_.size();
+}
+
+std::size_t ImageBufferPool::numFreeBuffers() const
+{
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    return free_buffers_.size();
+}
+
+}  // namespace pylon_camera
@@ -0,0 +1,134 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include <pylon_camera/latency_histogram.h>
+#include <algorithm>
+#include <cmath>
+
+namespace pylon_camera
+{
+
+LatencySummary::LatencySummary()
+    : count_(0)
+    , mean_(0.0)
+    , p50_(0.0)
+    , p95_(0.0)
+    , p99_(0.0)
+    , max_(0.0)
+{}
+
+LatencyHistogram::LatencyHistogram()
+    : sum_(0)
+    , max_(0)
+{
+    for ( std::size_t i = 0; i < NUM_BUCKETS; ++i )
+    {
+        buckets_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void LatencyHistogram::record(const uint64_t& duration_ns)
+{
+    buckets_[bucketIndex(duration_ns)].fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(duration_ns, std::memory_order_relaxed);
+    uint64_t max = max_.load(std::memory_order_relaxed);
+    while ( duration_ns > max &&
+            !max_.compare_exchange_weak(max, duration_ns,
+                                        std::memory_order_relaxed) )
+    {}
+}
+
+LatencySummary LatencyHistogram::takeSummary()
+{
+    uint64_t counts[NUM_BUCKETS];
+    LatencySummary summary;
+    for ( std::size_t i = 0; i < NUM_BUCKETS; ++i )
+    {
+        counts[i] = buckets_[i].exchange(0, std::memory_order_relaxed);
+        summary.count_ += counts[i];
+    }
+    const uint64_t sum = sum_.exchange(0, std::memory_order_relaxed);
+    const uint64_t max = max_.exchange(0, std::memory_order_relaxed);
+    if ( summary.count_ == 0 )
+    {
+        return summary;
+    }
+    summary.mean_ = 1e-3 * static_cast<double>(sum) / summary.count_;
+    summary.max_ = 1e-3 * static_cast<double>(max);
+
+    // nearest-rank percentiles
+    const double quantiles[] = {0.5, 0.95, 0.99};
+    double* percentiles[] = {&summary.p50_, &summary.p95_, &summary.p99_};
+    uint64_t cumulated = 0;
+    std::size_t q = 0;
+    for ( std::size_t i = 0; i < NUM_BUCKETS && q < 3; ++i )
+    {
+        cumulated += counts[i];
+        while ( q < 3 &&
+                cumulated >= std::ceil(quantiles[q] * summary.count_) )
+        {
+            // the bucket center might exceed the exact max
+            *percentiles[q] = std::min(1e-3 * bucketValue(i), summary.max_);
+            ++q;
+        }
+    }
+    return summary;
+}
+
+std::size_t LatencyHistogram::bucketIndex(const uint64_t& duration_ns)
+{
+    if ( duration_ns < SUB_BUCKETS )
+    {
+        return static_cast<std::size_t>(duration_ns);
+    }
+    const int msb = 63 - __builtin_clzll(duration_ns);
+    if ( msb >= MAX_BITS )
+    {
+        return NUM_BUCKETS - 1;
+    }
+    // the SUB_BUCKET_BITS bits below the most significant one select the
+    // sub-bucket within the power of two
+    const int shift = msb - SUB_BUCKET_BITS;
+    return static_cast<std::size_t>((shift + 1) * SUB_BUCKETS) +
+           static_cast<std::size_t>((duration_ns >> shift) & (SUB_BUCKETS - 1));
+}
+
+double LatencyHistogram::bucketValue(const std::size_t& index)
+{
+    if ( index < SUB_BUCKETS )
+    {
+        return static_cast<double>(index);
+    }
+    const int shift = static_cast<int>(index / SUB_BUCKETS) - 1;
+    const double lower = std::ldexp(static_cast<double>(SUB_BUCKETS + index % SUB_BUCKETS),
+                                    shift);
+    return lower + 0.5 * std::ldexp(1.0, shift);
+}
+
+}  // namespace pylon_camera
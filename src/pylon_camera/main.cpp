@@ -43,18 +43,19 @@ int main(int argc, char **argv)
 
     pylon_camera::PylonCameraNode pylon_camera_node;
 
-    ros::Rate r(pylon_camera_node.frameRate());
-
     ROS_INFO_STREAM("Start image grabbing if node connects to topic with "
         << "a frame_rate of: " << pylon_camera_node.frameRate() << " Hz");
 
     // Main thread and brightness-service thread
     boost::thread th(boost::bind(&ros::spin));
 
+    // The frames are grabbed by the acquisition thread of the node with the
+    // desired frame rate, or pushed by pylon's grab loop thread as soon as
+    // they arrive in event-driven grabbing. spin() blocks till the next frame
+    // is available and publishes it
     while ( ros::ok() )
     {
         pylon_camera_node.spin();
-        r.sleep();
     }
 
     ROS_INFO("Terminate PylonCameraNode");
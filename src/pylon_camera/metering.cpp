@@ -0,0 +1,799 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include <pylon_camera/metering.h>
+#include <pylon_camera/simd_dispatch.h>
+#include <sensor_msgs/image_encodings.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef PYLON_CAMERA_SIMD_X86
+#include <immintrin.h>
+#endif
+
+#ifdef PYLON_CAMERA_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+namespace pylon_camera
+{
+
+namespace metering
+{
+
+namespace
+{
+
+namespace enc = sensor_msgs::image_encodings;
+
+/**
+ * The histogram is counted in four banks of 32 bit, so that consecutive
+ * samples of the same value don't wait for each other's increment. The
+ * banks are added to the 64 bit histogram before they could overflow.
+ */
+const std::size_t NUM_BANKS = 4;
+const uint64_t MAX_BANKED_SAMPLES = 1ULL << 31;
+
+struct Accumulator
+{
+    Accumulator()
+        : sum_(0)
+        , saturated_(0)
+        , num_samples_(0)
+        , banked_samples_(0)
+    {
+        std::memset(banks_, 0, sizeof(banks_));
+        std::memset(histogram_, 0, sizeof(histogram_));
+    }
+
+    /**
+     * Counts the samples of a row, the banks are flushed before they could
+     * overflow
+     */
+    void countRow(const std::size_t& n)
+    {
+        num_samples_ += n;
+        banked_samples_ += n;
+        if ( banked_samples_ >= MAX_BANKED_SAMPLES )
+        {
+            flushBanks();
+        }
+    }
+
+    void flushBanks()
+    {
+        for ( std::size_t v = 0; v < 256; ++v )
+        {
+            histogram_[v] += static_cast<uint64_t>(banks_[v]) + banks_[256 + v] +
+                             banks_[512 + v] + banks_[768 + v];
+        }
+        std::memset(banks_, 0, sizeof(banks_));
+        banked_samples_ = 0;
+    }
+
+    uint64_t sum_;
+    uint64_t saturated_;
+    uint64_t num_samples_;
+    uint64_t banked_samples_;
+    uint32_t banks_[NUM_BANKS * 256];
+    uint64_t histogram_[256];
+};
+
+/**
+ * Counts 16 samples into the banks
+ */
+inline void countSamples(const uint8_t* samples, uint32_t* banks)
+{
+    for ( std::size_t k = 0; k < 16; k += NUM_BANKS )
+    {
+        ++banks[samples[k]];
+        ++banks[256 + samples[k + 1]];
+        ++banks[512 + samples[k + 2]];
+        ++banks[768 + samples[k + 3]];
+    }
+}
+
+/**
+ * Meters the samples [begin, n) of a row, sample k is the byte
+ * row[offset + k * stride]
+ */
+void rowScalar(const uint8_t* row,
+               const std::size_t& begin,
+               const std::size_t& n,
+               const SampleLayout& layout,
+               Accumulator& acc)
+{
+    for ( std::size_t k = begin; k < n; ++k )
+    {
+        const uint8_t v = row[layout.offset_ + k * layout.stride_];
+        acc.sum_ += v;
+        acc.saturated_ += v == 255;
+        ++acc.banks_[v];
+    }
+}
+
+#ifdef PYLON_CAMERA_SIMD_X86
+/*
+ * The SIMD kernels gather 16 (32) brightness bytes per iteration. Bytes of a
+ * 16 bit lane are separated by masking or shifting and packing, which
+ * reorders them within 128 bit lanes, irrelevant for the statistics. The
+ * sum and the count of saturated bytes (as multiple of 255) are accumulated
+ * by psadbw into 64 bit lanes. Loads start at the row, hence they stay
+ * within the row even if the brightness is the upper byte.
+ */
+__attribute__((target("sse2")))
+std::size_t rowSSE2(const uint8_t* row,
+                    const std::size_t& n,
+                    const SampleLayout& layout,
+                    Accumulator& acc)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i max = _mm_set1_epi8(static_cast<char>(0xFF));
+    const __m128i low_bytes = _mm_set1_epi16(0x00FF);
+    __m128i sum = zero;
+    __m128i saturated = zero;
+    uint8_t samples[16] __attribute__((aligned(16)));
+    std::size_t k = 0;
+    for ( ; k + 16 <= n; k += 16 )
+    {
+        __m128i v;
+        if ( layout.stride_ == 1 )
+        {
+            v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + k));
+        }
+        else
+        {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + 2 * k));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + 2 * k + 16));
+            if ( layout.offset_ == 1 )
+            {
+                a = _mm_srli_epi16(a, 8);
+                b = _mm_srli_epi16(b, 8);
+            }
+            else
+            {
+                a = _mm_and_si128(a, low_bytes);
+                b = _mm_and_si128(b, low_bytes);
+            }
+            v = _mm_packus_epi16(a, b);
+        }
+        sum = _mm_add_epi64(sum, _mm_sad_epu8(v, zero));
+        saturated = _mm_add_epi64(saturated,
+                                  _mm_sad_epu8(_mm_cmpeq_epi8(v, max), zero));
+        _mm_store_si128(reinterpret_cast<__m128i*>(samples), v);
+        countSamples(samples, acc.banks_);
+    }
+    uint64_t lanes[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), sum);
+    acc.sum_ += lanes[0] + lanes[1];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), saturated);
+    acc.saturated_ += (lanes[0] + lanes[1]) / 255;
+    return k;
+}
+
+__attribute__((target("avx2")))
+std::size_t rowAVX2(const uint8_t* row,
+                    const std::size_t& n,
+                    const SampleLayout& layout,
+                    Accumulator& acc)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i max = _mm256_set1_epi8(static_cast<char>(0xFF));
+    const __m256i low_bytes = _mm256_set1_epi16(0x00FF);
+    __m256i sum = zero;
+    __m256i saturated = zero;
+    uint8_t samples[32] __attribute__((aligned(32)));
+    std::size_t k = 0;
+    for ( ; k + 32 <= n; k += 32 )
+    {
+        __m256i v;
+        if ( layout.stride_ == 1 )
+        {
+            v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + k));
+        }
+        else
+        {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + 2 * k));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + 2 * k + 32));
+            if ( layout.offset_ == 1 )
+            {
+                a = _mm256_srli_epi16(a, 8);
+                b = _mm256_srli_epi16(b, 8);
+            }
+            else
+            {
+                a = _mm256_and_si256(a, low_bytes);
+                b = _mm256_and_si256(b, low_bytes);
+            }
+            v = _mm256_packus_epi16(a, b);
+        }
+        sum = _mm256_add_epi64(sum, _mm256_sad_epu8(v, zero));
+        saturated = _mm256_add_epi64(saturated,
+                                     _mm256_sad_epu8(_mm256_cmpeq_epi8(v, max), zero));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(samples), v);
+        countSamples(samples, acc.banks_);
+        countSamples(samples + 16, acc.banks_);
+    }
+    uint64_t lanes[4];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), sum);
+    acc.sum_ += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), saturated);
+    acc.saturated_ += (lanes[0] + lanes[1] + lanes[2] + lanes[3]) / 255;
+    return k;
+}
+#endif
+
+#ifdef PYLON_CAMERA_SIMD_NEON
+std::size_t rowNEON(const uint8_t* row,
+                    const std::size_t& n,
+                    const SampleLayout& layout,
+                    Accumulator& acc)
+{
+    const uint8x16_t max = vdupq_n_u8(255);
+    uint8_t samples[16] __attribute__((aligned(16)));
+    std::size_t k = 0;
+    for ( ; k + 16 <= n; k += 16 )
+    {
+        uint8x16_t v;
+        if ( layout.stride_ == 1 )
+        {
+            v = vld1q_u8(row + k);
+        }
+        else
+        {
+            const uint8x16x2_t pairs = vld2q_u8(row + 2 * k);
+            v = layout.offset_ == 1 ? pairs.val[1] : pairs.val[0];
+        }
+        acc.sum_ += vaddlvq_u8(v);
+        acc.saturated_ += vaddvq_u8(vshrq_n_u8(vceqq_u8(v, max), 7));
+        vst1q_u8(samples, v);
+        countSamples(samples, acc.banks_);
+    }
+    return k;
+}
+#endif
+
+simd_dispatch::INSTRUCTION_SET instructionSet(const METERING_KERNEL& kernel)
+{
+    switch ( kernel )
+    {
+        case MK_SSE2:
+            return simd_dispatch::IS_SSE2;
+        case MK_AVX2:
+            return simd_dispatch::IS_AVX2;
+        case MK_NEON:
+            return simd_dispatch::IS_NEON;
+        default:
+            return simd_dispatch::IS_SCALAR;
+    }
+}
+
+/**
+ * Meters the n brightness bytes of a row with the kernel, the samples left
+ * by the SIMD kernels are metered by the scalar code
+ */
+void meterRow(const uint8_t* row,
+              const std::size_t& n,
+              const SampleLayout& layout,
+              const METERING_KERNEL& kernel,
+              Accumulator& acc)
+{
+    std::size_t done = 0;
+    switch ( kernel )
+    {
+#ifdef PYLON_CAMERA_SIMD_X86
+        case MK_AVX2:
+            done = rowAVX2(row, n, layout, acc);
+            break;
+        case MK_SSE2:
+            done = rowSSE2(row, n, layout, acc);
+            break;
+#endif
+#ifdef PYLON_CAMERA_SIMD_NEON
+        case MK_NEON:
+            done = rowNEON(row, n, layout, acc);
+            break;
+#endif
+        default:
+            break;
+    }
+    rowScalar(row, done, n, layout, acc);
+}
+
+/**
+ * @return false if the image can't be metered with the kernel
+ */
+bool isMeterable(const sensor_msgs::Image& img,
+                 const METERING_KERNEL& kernel,
+                 SampleLayout& layout)
+{
+    return isSupported(kernel) && img.width != 0 && img.height != 0 &&
+           img.data.size() >= static_cast<std::size_t>(img.step) * img.height &&
+           sampleLayout(img.encoding, img.is_bigendian != 0, layout);
+}
+
+void storeResult(Accumulator& acc, MeteringResult& result)
+{
+    acc.flushBanks();
+    result.num_samples_ = acc.num_samples_;
+    result.mean_ = static_cast<double>(acc.sum_) / acc.num_samples_;
+    result.metered_mean_ = result.mean_;
+    result.saturated_fraction_ = static_cast<double>(acc.saturated_) /
+                                 acc.num_samples_;
+    std::memcpy(result.histogram_, acc.histogram_, sizeof(result.histogram_));
+}
+
+const std::size_t GRID_TILES = 16;
+const double SPOT_SIZE = 0.15;
+const double MATRIX_HIGHLIGHT_RATIO = 2.0;
+
+/**
+ * Weights the tiles of the matrix metering down which are much brighter than
+ * the median tile of the frame
+ */
+void suppressHighlights(const std::vector<uint64_t>& sums,
+                        const std::vector<uint64_t>& counts,
+                        std::vector<float>& weights)
+{
+    std::vector<double> means(sums.size(), -1.0);
+    std::vector<double> metered;
+    metered.reserve(sums.size());
+    for ( std::size_t t = 0; t < sums.size(); ++t )
+    {
+        if ( counts[t] > 0 )
+        {
+            means[t] = static_cast<double>(sums[t]) / counts[t];
+            metered.push_back(means[t]);
+        }
+    }
+    if ( metered.empty() )
+    {
+        return;
+    }
+    std::nth_element(metered.begin(),
+                     metered.begin() + metered.size() / 2,
+                     metered.end());
+    const double limit = MATRIX_HIGHLIGHT_RATIO *
+                         std::max(1.0, metered[metered.size() / 2]);
+    for ( std::size_t t = 0; t < weights.size(); ++t )
+    {
+        if ( means[t] > limit )
+        {
+            const double ratio = limit / means[t];
+            weights[t] *= static_cast<float>(ratio * ratio);
+        }
+    }
+}
+
+}  // namespace
+
+MeteringResult::MeteringResult()
+    : mean_(0.0)
+    , metered_mean_(0.0)
+    , saturated_fraction_(0.0)
+    , num_samples_(0)
+{
+    std::memset(histogram_, 0, sizeof(histogram_));
+}
+
+bool sampleLayout(const std::string& encoding,
+                  const bool& is_bigendian,
+                  SampleLayout& layout)
+{
+    if ( encoding == enc::YUV422 )
+    {
+        // UYVY, the luma is the second byte of each pixel
+        layout.offset_ = 1;
+        layout.stride_ = 2;
+        layout.per_pixel_ = 1;
+        return true;
+    }
+    int bit_depth = 0;
+    int channels = 0;
+    try
+    {
+        bit_depth = enc::bitDepth(encoding);
+        channels = enc::numChannels(encoding);
+    }
+    catch ( const std::runtime_error& )
+    {
+        return false;
+    }
+    if ( channels < 1 )
+    {
+        return false;
+    }
+    layout.per_pixel_ = static_cast<std::size_t>(channels);
+    if ( bit_depth == 8 )
+    {
+        layout.offset_ = 0;
+        layout.stride_ = 1;
+        return true;
+    }
+    else if ( bit_depth == 16 )
+    {
+        // the 16 bit pixels are MSB aligned, the upper byte is the brightness
+        layout.offset_ = is_bigendian ? 0 : 1;
+        layout.stride_ = 2;
+        return true;
+    }
+    return false;
+}
+
+bool meter(const sensor_msgs::Image& img,
+           const std::size_t& step_x,
+           const std::size_t& step_y,
+           MeteringResult& result)
+{
+    return meter(img, step_x, step_y, result, bestKernel());
+}
+
+bool meter(const sensor_msgs::Image& img,
+           const std::size_t& step_x,
+           const std::size_t& step_y,
+           MeteringResult& result,
+           const METERING_KERNEL& kernel)
+{
+    SampleLayout layout;
+    if ( !isMeterable(img, kernel, layout) )
+    {
+        return false;
+    }
+    const std::size_t dx = std::max<std::size_t>(1, step_x);
+    const std::size_t dy = std::max<std::size_t>(1, step_y);
+    const std::size_t samples_per_row = dx == 1 ?
+                img.width * layout.per_pixel_ :
+                ((img.width + dx - 1) / dx) * layout.per_pixel_;
+
+    Accumulator acc;
+    for ( std::size_t y = 0; y < img.height; y += dy )
+    {
+        const uint8_t* row = img.data.data() + y * img.step;
+        if ( dx == 1 )
+        {
+            meterRow(row, samples_per_row, layout, kernel, acc);
+        }
+        else
+        {
+            for ( std::size_t x = 0; x < img.width; x += dx )
+            {
+                rowScalar(row + x * layout.per_pixel_ * layout.stride_, 0,
+                          layout.per_pixel_, layout, acc);
+            }
+        }
+        acc.countRow(samples_per_row);
+    }
+    storeResult(acc, result);
+    return true;
+}
+
+bool meter(const sensor_msgs::Image& img,
+           const std::size_t& step_x,
+           const std::size_t& step_y,
+           const WeightMask& mask,
+           MeteringResult& result)
+{
+    return meter(img, step_x, step_y, mask, result, bestKernel());
+}
+
+bool meter(const sensor_msgs::Image& img,
+           const std::size_t& step_x,
+           const std::size_t& step_y,
+           const WeightMask& mask,
+           MeteringResult& result,
+           const METERING_KERNEL& kernel)
+{
+    SampleLayout layout;
+    const std::vector<std::size_t>& cols = mask.colEdges();
+    const std::vector<std::size_t>& rows = mask.rowEdges();
+    if ( !isMeterable(img, kernel, layout) ||
+         cols.back() != img.width || rows.back() != img.height )
+    {
+        return false;
+    }
+    const std::size_t dx = std::max<std::size_t>(1, step_x);
+    const std::size_t dy = std::max<std::size_t>(1, step_y);
+    const std::size_t tiles_x = mask.tilesX();
+    const std::size_t pixel_bytes = layout.per_pixel_ * layout.stride_;
+    std::vector<uint64_t> sums(mask.weights().size(), 0);
+    std::vector<uint64_t> counts(mask.weights().size(), 0);
+
+    Accumulator acc;
+    std::size_t ty = 0;
+    for ( std::size_t y = 0; y < img.height; y += dy )
+    {
+        while ( y >= rows[ty + 1] )
+        {
+            ++ty;
+        }
+        const uint8_t* row = img.data.data() + y * img.step;
+        std::size_t row_samples = 0;
+        for ( std::size_t tx = 0; tx < tiles_x; ++tx )
+        {
+            // the sum of the segment is the increase of the row sum
+            const uint64_t sum_before = acc.sum_;
+            std::size_t n = 0;
+            if ( dx == 1 )
+            {
+                n = (cols[tx + 1] - cols[tx]) * layout.per_pixel_;
+                meterRow(row + cols[tx] * pixel_bytes, n, layout, kernel, acc);
+            }
+            else
+            {
+                for ( std::size_t x = (cols[tx] + dx - 1) / dx * dx;
+                      x < cols[tx + 1];
+                      x += dx )
+                {
+                    rowScalar(row + x * pixel_bytes, 0, layout.per_pixel_,
+                              layout, acc);
+                    n += layout.per_pixel_;
+                }
+            }
+            sums[ty * tiles_x + tx] += acc.sum_ - sum_before;
+            counts[ty * tiles_x + tx] += n;
+            row_samples += n;
+        }
+        acc.countRow(row_samples);
+    }
+    storeResult(acc, result);
+
+    std::vector<float> weights(mask.weights());
+    if ( mask.mode() == MM_MATRIX )
+    {
+        suppressHighlights(sums, counts, weights);
+    }
+    double weighted_sum = 0.0;
+    double weighted_count = 0.0;
+    for ( std::size_t t = 0; t < weights.size(); ++t )
+    {
+        weighted_sum += weights[t] * static_cast<double>(sums[t]);
+        weighted_count += weights[t] * static_cast<double>(counts[t]);
+    }
+    if ( weighted_count > 0.0 )
+    {
+        // a region smaller than the sampling grid may contain no sample
+        result.metered_mean_ = weighted_sum / weighted_count;
+    }
+    return true;
+}
+
+WeightMask::WeightMask(const METERING_MODE& mode,
+                       const sensor_msgs::RegionOfInterest& roi,
+                       const std::size_t& width,
+                       const std::size_t& height)
+    : mode_(mode)
+    , roi_(roi)
+    , width_(width)
+    , height_(height)
+    , is_valid_(true)
+    , col_edges_()
+    , row_edges_()
+    , weights_()
+{
+    switch ( mode )
+    {
+        case MM_CENTER_WEIGHTED:
+        {
+            setUniformEdges(GRID_TILES, GRID_TILES);
+            for ( std::size_t ty = 0; ty < GRID_TILES; ++ty )
+            {
+                // distance of the tile center to the image center, 1 at the
+                // borders
+                const double ry = (row_edges_[ty] + row_edges_[ty + 1]) /
+                                  std::max<double>(1.0, height) - 1.0;
+                for ( std::size_t tx = 0; tx < GRID_TILES; ++tx )
+                {
+                    const double rx = (col_edges_[tx] + col_edges_[tx + 1]) /
+                                      std::max<double>(1.0, width) - 1.0;
+                    weights_[ty * GRID_TILES + tx] =
+                            static_cast<float>(std::exp(-2.0 * (rx * rx + ry * ry)));
+                }
+            }
+            break;
+        }
+        case MM_SPOT:
+        case MM_ROI:
+        {
+            std::size_t x0, x1, y0, y1;
+            if ( mode == MM_SPOT )
+            {
+                x0 = static_cast<std::size_t>(width * (1.0 - SPOT_SIZE) / 2.0);
+                y0 = static_cast<std::size_t>(height * (1.0 - SPOT_SIZE) / 2.0);
+                x1 = width - x0;
+                y1 = height - y0;
+            }
+            else
+            {
+                // a width or height of zero selects the rest of the image
+                x0 = std::min<std::size_t>(roi.x_offset, width);
+                y0 = std::min<std::size_t>(roi.y_offset, height);
+                x1 = roi.width == 0 ? width : std::min<std::size_t>(x0 + roi.width, width);
+                y1 = roi.height == 0 ? height : std::min<std::size_t>(y0 + roi.height, height);
+            }
+            if ( x1 <= x0 || y1 <= y0 )
+            {
+                is_valid_ = false;
+                setUniformEdges(1, 1);
+                break;
+            }
+            // 3x3 tiles, only the central one is metered
+            col_edges_ = {0, x0, x1, width};
+            row_edges_ = {0, y0, y1, height};
+            weights_.assign(9, 0.0f);
+            weights_[4] = 1.0f;
+            break;
+        }
+        case MM_MATRIX:
+            setUniformEdges(GRID_TILES, GRID_TILES);
+            break;
+        default:
+            setUniformEdges(1, 1);
+            break;
+    }
+}
+
+bool WeightMask::matches(const METERING_MODE& mode,
+                         const sensor_msgs::RegionOfInterest& roi,
+                         const std::size_t& width,
+                         const std::size_t& height) const
+{
+    if ( mode != mode_ || width != width_ || height != height_ )
+    {
+        return false;
+    }
+    return mode != MM_ROI ||
+           ( roi.x_offset == roi_.x_offset && roi.y_offset == roi_.y_offset &&
+             roi.width == roi_.width && roi.height == roi_.height );
+}
+
+bool WeightMask::isValid() const
+{
+    return is_valid_;
+}
+
+const METERING_MODE& WeightMask::mode() const
+{
+    return mode_;
+}
+
+std::size_t WeightMask::tilesX() const
+{
+    return col_edges_.size() - 1;
+}
+
+std::size_t WeightMask::tilesY() const
+{
+    return row_edges_.size() - 1;
+}
+
+const std::vector<std::size_t>& WeightMask::colEdges() const
+{
+    return col_edges_;
+}
+
+const std::vector<std::size_t>& WeightMask::rowEdges() const
+{
+    return row_edges_;
+}
+
+const std::vector<float>& WeightMask::weights() const
+{
+    return weights_;
+}
+
+void WeightMask::setUniformEdges(const std::size_t& tiles_x,
+                                 const std::size_t& tiles_y)
+{
+    col_edges_.resize(tiles_x + 1);
+    for ( std::size_t i = 0; i <= tiles_x; ++i )
+    {
+        col_edges_[i] = i * width_ / tiles_x;
+    }
+    row_edges_.resize(tiles_y + 1);
+    for ( std::size_t i = 0; i <= tiles_y; ++i )
+    {
+        row_edges_[i] = i * height_ / tiles_y;
+    }
+    weights_.assign(tiles_x * tiles_y, 1.0f);
+}
+
+bool meteringModeFromString(const std::string& name, METERING_MODE& mode)
+{
+    if ( name == "average" )
+    {
+        mode = MM_AVERAGE;
+    }
+    else if ( name == "center_weighted" )
+    {
+        mode = MM_CENTER_WEIGHTED;
+    }
+    else if ( name == "spot" )
+    {
+        mode = MM_SPOT;
+    }
+    else if ( name == "roi" )
+    {
+        mode = MM_ROI;
+    }
+    else if ( name == "matrix" )
+    {
+        mode = MM_MATRIX;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+std::string meteringModeString(const METERING_MODE& mode)
+{
+    switch ( mode )
+    {
+        case MM_CENTER_WEIGHTED:
+            return "center_weighted";
+        case MM_SPOT:
+            return "spot";
+        case MM_ROI:
+            return "roi";
+        case MM_MATRIX:
+            return "matrix";
+        default:
+            return "average";
+    }
+}
+
+bool isSupported(const METERING_KERNEL& kernel)
+{
+    return simd_dispatch::isSupported(instructionSet(kernel));
+}
+
+METERING_KERNEL bestKernel()
+{
+    // ordered from the fastest to the slowest kernel
+    const METERING_KERNEL kernels[] = { MK_AVX2, MK_SSE2, MK_NEON };
+    for ( const METERING_KERNEL& kernel : kernels )
+    {
+        if ( isSupported(kernel) )
+        {
+            return kernel;
+        }
+    }
+    return MK_SCALAR;
+}
+
+std::string kernelName(const METERING_KERNEL& kernel)
+{
+    return simd_dispatch::instructionSetName(instructionSet(kernel));
+}
+
+}  // namespace metering
+}  // namespace pylon_camera
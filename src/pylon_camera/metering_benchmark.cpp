@@ -0,0 +1,304 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+/*
+ This program verifies the SIMD metering kernels against the scalar kernel
+ and compares them with the previous brightness computation of the
+ pylon_camera_node (sampled indices for mono, std::accumulate into an int for
+ all other encodings) for 5 MP and 12 MP frames. The weighted metering
+ modes are verified against the plain metering and timed as well. No camera
+ is needed, the frames are synthetic.
+
+ USAGE: rosrun pylon_camera metering_benchmark _iterations:=50 _grid_step:=4
+*/
+
+#include <ros/ros.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+#include <string>
+#include <vector>
+#include <sensor_msgs/image_encodings.h>
+#include <pylon_camera/metering.h>
+
+namespace
+{
+
+namespace enc = sensor_msgs::image_encodings;
+using pylon_camera::metering::MeteringResult;
+
+/**
+ * @return a frame with a gradient, some texture and a saturated band
+ */
+sensor_msgs::Image syntheticFrame(const int& width,
+                                  const int& height,
+                                  const std::string& encoding)
+{
+    sensor_msgs::Image img;
+    img.width = width;
+    img.height = height;
+    img.encoding = encoding;
+    img.is_bigendian = 0;
+    const int bytes_per_pixel = encoding == enc::YUV422 ? 2 :
+                                enc::numChannels(encoding) * enc::bitDepth(encoding) / 8;
+    img.step = width * bytes_per_pixel;
+    img.data.resize(static_cast<std::size_t>(img.step) * height);
+    for ( int row = 0; row < height; ++row )
+    {
+        for ( int col = 0; col < static_cast<int>(img.step); ++col )
+        {
+            const bool saturated = row > height - height / 20;
+            img.data[static_cast<std::size_t>(row) * img.step + col] = saturated ? 255 :
+                static_cast<uint8_t>((row + col) / 32 + ((row * 7 + col * 13) % 64));
+        }
+    }
+    return img;
+}
+
+/**
+ * The sampling indices of the previous implementation, which subdivides the
+ * image recursively till the windows are rows / downsampling_factor high
+ */
+void genSamplingIndicesRec(std::vector<std::size_t>& indices,
+                           const std::size_t& cols,
+                           const std::size_t& min_window_height,
+                           const int& sx, const int& sy,
+                           const int& ex, const int& ey)
+{
+    if ( static_cast<std::size_t>(std::abs(ey - sy)) <= min_window_height )
+    {
+        return;
+    }
+    const int dx = (ex - sx) / 2;
+    const int dy = (ey - sy) / 2;
+    const int ax = sx + dx;
+    const int ay = sy + dy;
+    indices.push_back((sy + 3 * dy / 2) * cols + ax);
+    indices.push_back(ay * cols + sx + dx / 2);
+    indices.push_back((sy + dy / 2) * cols + ax);
+    indices.push_back(ay * cols + sx + 3 * dx / 2);
+    genSamplingIndicesRec(indices, cols, min_window_height, sx, sy, ax, ay);
+    genSamplingIndicesRec(indices, cols, min_window_height, ax, ay, ex, ey);
+    genSamplingIndicesRec(indices, cols, min_window_height, sx, ay, ax, ey);
+    genSamplingIndicesRec(indices, cols, min_window_height, ax, sy, ex, ay);
+}
+
+/**
+ * The brightness computation of the previous implementation
+ */
+float legacyBrightness(const sensor_msgs::Image& img,
+                       const std::vector<std::size_t>& sampling_indices)
+{
+    const std::vector<uint8_t>& data = img.data;
+    const bool is_yuv = img.encoding == enc::YUV422;
+    const bool is_16_bit = is_yuv || enc::bitDepth(img.encoding) == 16;
+    float sum = 0.0;
+    if ( enc::isMono(img.encoding) || is_yuv )
+    {
+        for ( const std::size_t& idx : sampling_indices )
+        {
+            sum += is_16_bit ? data.at(2 * idx + 1) : data.at(idx);
+        }
+        sum /= static_cast<float>(sampling_indices.size());
+    }
+    else if ( is_16_bit )
+    {
+        for ( std::size_t i = 1; i < data.size(); i += 2 )
+        {
+            sum += data[i];
+        }
+        sum /= static_cast<float>(data.size() / 2);
+    }
+    else
+    {
+        sum = std::accumulate(data.begin(), data.end(), 0);
+        sum /= static_cast<float>(data.size());
+    }
+    return sum;
+}
+
+bool isEqual(const MeteringResult& a, const MeteringResult& b)
+{
+    return a.num_samples_ == b.num_samples_ &&
+           a.mean_ == b.mean_ &&
+           a.saturated_fraction_ == b.saturated_fraction_ &&
+           std::memcmp(a.histogram_, b.histogram_, sizeof(a.histogram_)) == 0;
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    ros::init(argc, argv, "pylon_camera_metering_benchmark");
+    ros::NodeHandle nh("~");
+
+    int iterations;
+    nh.param<int>("iterations", iterations, 50);
+    int grid_step;
+    nh.param<int>("grid_step", grid_step, 4);
+    iterations = std::max(1, iterations);
+    grid_step = std::max(1, grid_step);
+
+    namespace metering = pylon_camera::metering;
+    const metering::METERING_KERNEL best = metering::bestKernel();
+    ROS_INFO_STREAM("Best metering kernel: " << metering::kernelName(best));
+
+    struct FrameSize
+    {
+        const char* name;
+        int width;
+        int height;
+    };
+    const FrameSize frame_sizes[] = { { "5 MP", 2448, 2048 },
+                                      { "12 MP", 4096, 3000 } };
+    const std::string encodings[] = { enc::MONO8, enc::BAYER_RGGB8, enc::RGB8,
+                                      enc::YUV422, enc::MONO16 };
+
+    bool success = true;
+    for ( const FrameSize& size : frame_sizes )
+    {
+        std::vector<std::size_t> sampling_indices;
+        sampling_indices.push_back(size.height / 2 * size.width + size.width / 2);
+        genSamplingIndicesRec(sampling_indices, size.width, size.height / 20,
+                              0, 0, size.width, size.height);
+        std::sort(sampling_indices.begin(), sampling_indices.end());
+
+        for ( const std::string& encoding : encodings )
+        {
+            const sensor_msgs::Image img = syntheticFrame(size.width, size.height,
+                                                          encoding);
+            // all kernels have to produce the same statistics as the scalar one
+            for ( int kernel = metering::MK_SSE2; kernel <= metering::MK_NEON; ++kernel )
+            {
+                const metering::METERING_KERNEL k =
+                                static_cast<metering::METERING_KERNEL>(kernel);
+                if ( !metering::isSupported(k) )
+                {
+                    continue;
+                }
+                for ( int step = 1; step <= grid_step; step += std::max(1, grid_step - 1) )
+                {
+                    MeteringResult reference;
+                    MeteringResult result;
+                    metering::meter(img, step, step, reference, metering::MK_SCALAR);
+                    metering::meter(img, step, step, result, k);
+                    if ( !isEqual(reference, result) )
+                    {
+                        ROS_ERROR_STREAM("Kernel " << metering::kernelName(k)
+                                << " differs from the scalar kernel for "
+                                << encoding << ", grid step " << step);
+                        success = false;
+                    }
+                }
+            }
+
+            float legacy = 0.0;
+            ros::WallTime start = ros::WallTime::now();
+            for ( int i = 0; i < iterations; ++i )
+            {
+                legacy = legacyBrightness(img, sampling_indices);
+            }
+            const double legacy_ms = 1e3 * (ros::WallTime::now() - start).toSec() / iterations;
+
+            MeteringResult result;
+            start = ros::WallTime::now();
+            for ( int i = 0; i < iterations; ++i )
+            {
+                metering::meter(img, 1, 1, result, metering::MK_SCALAR);
+            }
+            const double scalar_ms = 1e3 * (ros::WallTime::now() - start).toSec() / iterations;
+
+            start = ros::WallTime::now();
+            for ( int i = 0; i < iterations; ++i )
+            {
+                metering::meter(img, 1, 1, result, best);
+            }
+            const double best_ms = 1e3 * (ros::WallTime::now() - start).toSec() / iterations;
+            const double full_mean = result.mean_;
+
+            start = ros::WallTime::now();
+            for ( int i = 0; i < iterations; ++i )
+            {
+                metering::meter(img, grid_step, grid_step, result, best);
+            }
+            const double grid_ms = 1e3 * (ros::WallTime::now() - start).toSec() / iterations;
+
+            ROS_INFO_STREAM(size.name << " " << encoding << ": previous "
+                    << legacy_ms << " ms (mean " << legacy << "), scalar "
+                    << scalar_ms << " ms, " << metering::kernelName(best) << " "
+                    << best_ms << " ms (mean " << full_mean << ", saturated "
+                    << 100.0 * result.saturated_fraction_ << " %), grid step "
+                    << grid_step << " " << grid_ms << " ms (mean " << result.mean_
+                    << ")");
+        }
+
+        // the weighted metering of the average mode has to reproduce the
+        // plain metering, the other modes are timed on a mono8 frame
+        const sensor_msgs::Image img = syntheticFrame(size.width, size.height,
+                                                      enc::MONO8);
+        sensor_msgs::RegionOfInterest roi;
+        roi.x_offset = size.width / 2;
+        roi.y_offset = size.height / 2;
+        const pylon_camera::METERING_MODE modes[] = { pylon_camera::MM_AVERAGE,
+                                                      pylon_camera::MM_CENTER_WEIGHTED,
+                                                      pylon_camera::MM_SPOT,
+                                                      pylon_camera::MM_ROI,
+                                                      pylon_camera::MM_MATRIX };
+        for ( const pylon_camera::METERING_MODE& mode : modes )
+        {
+            const metering::WeightMask mask(mode, roi, size.width, size.height);
+            MeteringResult reference;
+            MeteringResult result;
+            metering::meter(img, grid_step, grid_step, reference, best);
+            metering::meter(img, grid_step, grid_step, mask, result);
+            if ( !isEqual(reference, result) ||
+                 ( mode == pylon_camera::MM_AVERAGE &&
+                   result.metered_mean_ != reference.mean_ ) )
+            {
+                ROS_ERROR_STREAM("Weighted metering ("
+                        << metering::meteringModeString(mode)
+                        << ") differs from the plain metering");
+                success = false;
+            }
+
+            ros::WallTime start = ros::WallTime::now();
+            for ( int i = 0; i < iterations; ++i )
+            {
+                metering::meter(img, grid_step, grid_step, mask, result);
+            }
+            const double mode_ms = 1e3 * (ros::WallTime::now() - start).toSec() / iterations;
+            ROS_INFO_STREAM(size.name << " " << enc::MONO8 << " "
+                    << metering::meteringModeString(mode) << ": grid step "
+                    << grid_step << " " << mode_ms << " ms (metered mean "
+                    << result.metered_mean_ << ", mean " << result.mean_ << ")");
+        }
+    }
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,206 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include <pylon_camera/multi_camera_host.h>
+#include <string>
+#include <vector>
+
+namespace pylon_camera
+{
+
+MultiCameraHost::Camera::Camera(const std::string& name,
+                                const ros::NodeHandle& parent_nh)
+    : name_(name),
+      callback_queue_(),
+      nh_(parent_nh, name),
+      spinner_(),
+      pylon_camera_(nullptr),
+      node_(nullptr),
+      strand_(),
+      control_thread_()
+{
+    nh_.setCallbackQueue(&callback_queue_);
+}
+
+MultiCameraHost::MultiCameraHost(const ros::NodeHandle& nh)
+    : nh_(nh),
+      cameras_(),
+      io_service_(),
+      work_(),
+      workers_(),
+      is_running_(false)
+{}
+
+MultiCameraHost::~MultiCameraHost()
+{
+    stop();
+}
+
+bool MultiCameraHost::start()
+{
+    std::vector<std::string> camera_names;
+    nh_.param<std::vector<std::string> >("cameras", camera_names,
+                                         std::vector<std::string>());
+    if ( camera_names.empty() )
+    {
+        ROS_ERROR_STREAM("No cameras configured, the parameter '"
+                << nh_.resolveName("cameras") << "' has to contain the list "
+                << "of camera names");
+        return false;
+    }
+
+    int num_worker_threads;
+    nh_.param<int>("num_worker_threads", num_worker_threads, 2);
+    if ( num_worker_threads < 1 )
+    {
+        ROS_WARN_STREAM("Number of worker threads has to be at least 1, but "
+                << "is " << num_worker_threads << ". Will reset it to default "
+                << "value (2)");
+        num_worker_threads = 2;
+        nh_.setParam("num_worker_threads", num_worker_threads);
+    }
+
+    std::vector<std::string> device_user_ids;
+    for ( const std::string& name : camera_names )
+    {
+        boost::shared_ptr<Camera> camera(new Camera(name, nh_));
+        std::string device_user_id;
+        camera->nh_.param<std::string>("device_user_id", device_user_id, "");
+        device_user_ids.push_back(device_user_id);
+        camera->strand_.reset(new boost::asio::io_service::strand(io_service_));
+        cameras_.push_back(camera);
+    }
+
+    // a single enumeration for all cameras, the ones that are not found yet
+    // are waited for by their nodes
+    const ros::WallTime enumeration_start = ros::WallTime::now();
+    std::vector<PylonCamera*> pylon_cameras = PylonCamera::create(device_user_ids);
+    ROS_INFO_STREAM("Enumerating the devices for " << cameras_.size()
+            << " cameras took "
+            << (ros::WallTime::now() - enumeration_start).toSec() << "s");
+
+    is_running_ = true;
+    work_.reset(new boost::asio::io_service::work(io_service_));
+    for ( int i = 0; i < num_worker_threads; ++i )
+    {
+        workers_.create_thread([this]() { io_service_.run(); });
+    }
+
+    for ( std::size_t i = 0; i < cameras_.size(); ++i )
+    {
+        Camera* camera = cameras_.at(i).get();
+        camera->pylon_camera_ = pylon_cameras.at(i);
+        camera->spinner_.reset(new ros::AsyncSpinner(1, &camera->callback_queue_));
+        camera->spinner_->start();
+        camera->control_thread_ = boost::thread(
+                    boost::bind(&MultiCameraHost::controlLoop, this, camera));
+    }
+    ROS_INFO_STREAM("Started " << cameras_.size() << " cameras with "
+            << num_worker_threads << " worker threads");
+    return true;
+}
+
+void MultiCameraHost::stop()
+{
+    is_running_ = false;
+    for ( boost::shared_ptr<Camera>& camera : cameras_ )
+    {
+        if ( camera->control_thread_.joinable() )
+        {
+            camera->control_thread_.join();
+        }
+        if ( camera->node_ )
+        {
+            camera->node_->setFrameReadyCallback(boost::function<void ()>());
+        }
+    }
+
+    // the pending publishing jobs refer to the nodes
+    work_.reset();
+    io_service_.stop();
+    workers_.join_all();
+
+    for ( boost::shared_ptr<Camera>& camera : cameras_ )
+    {
+        if ( camera->spinner_ )
+        {
+            camera->spinner_->stop();
+        }
+        if ( camera->node_ )
+        {
+            delete camera->node_;
+            camera->node_ = nullptr;
+        }
+        if ( camera->pylon_camera_ )
+        {
+            delete camera->pylon_camera_;
+            camera->pylon_camera_ = nullptr;
+        }
+    }
+    cameras_.clear();
+}
+
+void MultiCameraHost::controlLoop(Camera* camera)
+{
+    // the node takes the ownership of the camera
+    PylonCamera* pylon_camera = camera->pylon_camera_;
+    camera->pylon_camera_ = nullptr;
+    camera->node_ = new PylonCameraNode(
+                camera->nh_, false, pylon_camera,
+                boost::bind(&MultiCameraHost::isStopping, this));
+    if ( !camera->node_->isInitialized() )
+    {
+        ROS_ERROR_STREAM("Initializing camera '" << camera->name_ << "' failed");
+        return;
+    }
+
+    camera->node_->setFrameReadyCallback(
+                boost::bind(&MultiCameraHost::schedulePublishing, this, camera));
+    // the frames grabbed before the callback has been set
+    schedulePublishing(camera);
+
+    while ( ros::ok() && is_running_ )
+    {
+        camera->node_->resetIfCameraRemoved();
+        ros::WallDuration(0.1).sleep();
+    }
+}
+
+void MultiCameraHost::schedulePublishing(Camera* camera)
+{
+    camera->strand_->post(boost::bind(&PylonCameraNode::publishPendingFrames,
+                                      camera->node_));
+}
+
+bool MultiCameraHost::isStopping() const
+{
+    return !is_running_;
+}
+
+}  // namespace pylon_camera
@@ -0,0 +1,303 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include <pylon_camera/packed_pixels.h>
+#include <pylon_camera/simd_dispatch.h>
+
+#ifdef PYLON_CAMERA_SIMD_X86
+#include <immintrin.h>
+#endif
+
+#ifdef PYLON_CAMERA_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+namespace pylon_camera
+{
+
+namespace packed_pixels
+{
+
+namespace
+{
+
+/**
+ * Describes how 8 pixels are unpacked from 'bits' byte by the SIMD kernels:
+ * The shuffle gathers the two bytes containing each pixel into a 16 bit
+ * lane. Each lane is then shifted to the left by a multiplication, such that
+ * the pixel ends at the most significant bit, and the bits of the
+ * neighbouring pixel below it are masked out.
+ */
+struct Layout
+{
+    int bits;
+    uint8_t shuffle[16];
+    uint16_t multiplier[8];
+    uint16_t mask;
+};
+
+const Layout LAYOUT_10P =
+{
+    10,
+    { 0, 1, 1, 2, 2, 3, 3, 4, 5, 6, 6, 7, 7, 8, 8, 9 },
+    { 64, 16, 4, 1, 64, 16, 4, 1 },
+    0xFFC0
+};
+
+const Layout LAYOUT_12P =
+{
+    12,
+    { 0, 1, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 9, 10, 10, 11 },
+    { 16, 1, 16, 1, 16, 1, 16, 1 },
+    0xFFF0
+};
+
+void unpackScalar(const uint8_t* src,
+                  uint16_t* dst,
+                  const std::size_t& begin,
+                  const std::size_t& end,
+                  const int& bits)
+{
+    const uint16_t max_value = static_cast<uint16_t>((1 << bits) - 1);
+    for ( std::size_t i = begin; i < end; ++i )
+    {
+        // a 10 or 12 bit pixel always spans two bytes
+        const std::size_t bit = i * bits;
+        const std::size_t byte = bit >> 3;
+        const uint16_t word = static_cast<uint16_t>(src[byte] | (src[byte + 1] << 8));
+        dst[i] = static_cast<uint16_t>(((word >> (bit & 7)) & max_value) << (16 - bits));
+    }
+}
+
+#ifdef PYLON_CAMERA_SIMD_X86
+/**
+ * @return the number of unpacked pixels, the caller unpacks the rest
+ */
+__attribute__((target("ssse3")))
+std::size_t unpackSSSE3(const uint8_t* src,
+                        uint16_t* dst,
+                        const std::size_t& num_pixels,
+                        const std::size_t& src_size,
+                        const Layout& layout)
+{
+    const __m128i shuffle = _mm_loadu_si128(
+                            reinterpret_cast<const __m128i*>(layout.shuffle));
+    const __m128i multiplier = _mm_loadu_si128(
+                            reinterpret_cast<const __m128i*>(layout.multiplier));
+    const __m128i mask = _mm_set1_epi16(static_cast<int16_t>(layout.mask));
+    std::size_t i = 0;
+    std::size_t offset = 0;
+    // 8 pixels are taken from a 16 byte load, which must not exceed the
+    // source buffer
+    while ( i + 8 <= num_pixels && offset + 16 <= src_size )
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + offset));
+        v = _mm_shuffle_epi8(v, shuffle);
+        v = _mm_and_si128(_mm_mullo_epi16(v, multiplier), mask);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), v);
+        i += 8;
+        offset += layout.bits;
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+std::size_t unpackAVX2(const uint8_t* src,
+                       uint16_t* dst,
+                       const std::size_t& num_pixels,
+                       const std::size_t& src_size,
+                       const Layout& layout)
+{
+    // the byte shuffle works within each 128 bit lane, hence each lane gets
+    // its own load of 8 pixels
+    const __m128i shuffle_128 = _mm_loadu_si128(
+                            reinterpret_cast<const __m128i*>(layout.shuffle));
+    const __m128i multiplier_128 = _mm_loadu_si128(
+                            reinterpret_cast<const __m128i*>(layout.multiplier));
+    const __m256i shuffle = _mm256_broadcastsi128_si256(shuffle_128);
+    const __m256i multiplier = _mm256_broadcastsi128_si256(multiplier_128);
+    const __m256i mask = _mm256_set1_epi16(static_cast<int16_t>(layout.mask));
+    std::size_t i = 0;
+    std::size_t offset = 0;
+    while ( i + 16 <= num_pixels && offset + layout.bits + 16 <= src_size )
+    {
+        const __m128i lo = _mm_loadu_si128(
+                            reinterpret_cast<const __m128i*>(src + offset));
+        const __m128i hi = _mm_loadu_si128(
+                            reinterpret_cast<const __m128i*>(src + offset + layout.bits));
+        __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+        v = _mm256_shuffle_epi8(v, shuffle);
+        v = _mm256_and_si256(_mm256_mullo_epi16(v, multiplier), mask);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), v);
+        i += 16;
+        offset += 2 * layout.bits;
+    }
+    // the remaining full blocks of 8 pixels
+    return i + unpackSSSE3(src + offset, dst + i, num_pixels - i,
+                           src_size - offset, layout);
+}
+#endif
+
+#ifdef PYLON_CAMERA_SIMD_NEON
+std::size_t unpackNEON(const uint8_t* src,
+                       uint16_t* dst,
+                       const std::size_t& num_pixels,
+                       const std::size_t& src_size,
+                       const Layout& layout)
+{
+    const uint8x16_t shuffle = vld1q_u8(layout.shuffle);
+    const uint16x8_t multiplier = vld1q_u16(layout.multiplier);
+    const uint16x8_t mask = vdupq_n_u16(layout.mask);
+    std::size_t i = 0;
+    std::size_t offset = 0;
+    while ( i + 8 <= num_pixels && offset + 16 <= src_size )
+    {
+        const uint8x16_t bytes = vqtbl1q_u8(vld1q_u8(src + offset), shuffle);
+        uint16x8_t v = vreinterpretq_u16_u8(bytes);
+        v = vandq_u16(vmulq_u16(v, multiplier), mask);
+        vst1q_u16(dst + i, v);
+        i += 8;
+        offset += layout.bits;
+    }
+    return i;
+}
+#endif
+
+simd_dispatch::INSTRUCTION_SET instructionSet(const UNPACK_KERNEL& kernel)
+{
+    switch ( kernel )
+    {
+        case UK_SSSE3:
+            return simd_dispatch::IS_SSSE3;
+        case UK_AVX2:
+            return simd_dispatch::IS_AVX2;
+        case UK_NEON:
+            return simd_dispatch::IS_NEON;
+        default:
+            return simd_dispatch::IS_SCALAR;
+    }
+}
+
+}  // namespace
+
+int packedBits(const std::string& gen_api_enc)
+{
+    if ( gen_api_enc.size() < 4 ||
+         gen_api_enc.compare(gen_api_enc.size() - 1, 1, "p") != 0 ||
+         ( gen_api_enc.compare(0, 4, "Mono") != 0 &&
+           gen_api_enc.compare(0, 5, "Bayer") != 0 ) )
+    {
+        return 0;
+    }
+    if ( gen_api_enc.compare(gen_api_enc.size() - 3, 3, "10p") == 0 )
+    {
+        return 10;
+    }
+    if ( gen_api_enc.compare(gen_api_enc.size() - 3, 3, "12p") == 0 )
+    {
+        return 12;
+    }
+    return 0;
+}
+
+std::size_t packedSize(const std::size_t& num_pixels, const int& bits)
+{
+    return (num_pixels * bits + 7) / 8;
+}
+
+bool unpack(const uint8_t* src,
+            uint16_t* dst,
+            const std::size_t& num_pixels,
+            const int& bits)
+{
+    return unpack(src, dst, num_pixels, bits, bestKernel());
+}
+
+bool unpack(const uint8_t* src,
+            uint16_t* dst,
+            const std::size_t& num_pixels,
+            const int& bits,
+            const UNPACK_KERNEL& kernel)
+{
+    if ( ( bits != 10 && bits != 12 ) || !isSupported(kernel) )
+    {
+        return false;
+    }
+    const Layout& layout = bits == 10 ? LAYOUT_10P : LAYOUT_12P;
+    const std::size_t src_size = packedSize(num_pixels, bits);
+    std::size_t done = 0;
+    switch ( kernel )
+    {
+#ifdef PYLON_CAMERA_SIMD_X86
+        case UK_AVX2:
+            done = unpackAVX2(src, dst, num_pixels, src_size, layout);
+            break;
+        case UK_SSSE3:
+            done = unpackSSSE3(src, dst, num_pixels, src_size, layout);
+            break;
+#endif
+#ifdef PYLON_CAMERA_SIMD_NEON
+        case UK_NEON:
+            done = unpackNEON(src, dst, num_pixels, src_size, layout);
+            break;
+#endif
+        default:
+            break;
+    }
+    // the SIMD kernels leave the pixels whose loads would exceed the buffer
+    unpackScalar(src, dst, done, num_pixels, bits);
+    return true;
+}
+
+bool isSupported(const UNPACK_KERNEL& kernel)
+{
+    return simd_dispatch::isSupported(instructionSet(kernel));
+}
+
+UNPACK_KERNEL bestKernel()
+{
+    // ordered from the fastest to the slowest kernel
+    const UNPACK_KERNEL kernels[] = { UK_AVX2, UK_SSSE3, UK_NEON };
+    for ( const UNPACK_KERNEL& kernel : kernels )
+    {
+        if ( isSupported(kernel) )
+        {
+            return kernel;
+        }
+    }
+    return UK_SCALAR;
+}
+
+std::string kernelName(const UNPACK_KERNEL& kernel)
+{
+    return simd_dispatch::instructionSetName(instructionSet(kernel));
+}
+
+}  // namespace packed_pixels
+}  // namespace pylon_camera
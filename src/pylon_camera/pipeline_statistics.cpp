@@ -0,0 +1,129 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include <pylon_camera/pipeline_statistics.h>
+#include <string>
+
+namespace pylon_camera
+{
+
+PipelineStatistics::PipelineStatistics()
+    : enabled_(false)
+{
+    for ( int i = 0; i < NUM_FRAME_COUNTERS; ++i )
+    {
+        counters_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void PipelineStatistics::setEnabled(const bool& enabled)
+{
+    enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+bool PipelineStatistics::isEnabled() const
+{
+    return enabled_.load(std::memory_order_relaxed);
+}
+
+void PipelineStatistics::record(const LATENCY_STAGE& stage,
+                                const uint64_t& duration_ns)
+{
+    if ( isEnabled() )
+    {
+        histograms_[stage].record(duration_ns);
+    }
+}
+
+void PipelineStatistics::count(const FRAME_COUNTER& counter,
+                               const uint64_t& amount)
+{
+    if ( isEnabled() )
+    {
+        counters_[counter].fetch_add(amount, std::memory_order_relaxed);
+    }
+}
+
+LatencySummary PipelineStatistics::takeSummary(const LATENCY_STAGE& stage)
+{
+    return histograms_[stage].takeSummary();
+}
+
+uint64_t PipelineStatistics::takeCount(const FRAME_COUNTER& counter)
+{
+    return counters_[counter].exchange(0, std::memory_order_relaxed);
+}
+
+std::string PipelineStatistics::stageName(const LATENCY_STAGE& stage)
+{
+    switch ( stage )
+    {
+        case LS_TRIGGER_WAIT:
+            return "trigger_wait";
+        case LS_RETRIEVE:
+            return "retrieve_result";
+        case LS_BUFFER:
+            return "buffer";
+        case LS_BRIGHTNESS:
+            return "brightness";
+        case LS_RECTIFY:
+            return "rectify";
+        case LS_PUBLISH:
+            return "publish";
+        case LS_STAMP_TO_PUBLISH:
+            return "stamp_to_publish";
+        case LS_CONVERT:
+            return "convert";
+        default:
+            return "unknown";
+    }
+}
+
+std::string PipelineStatistics::counterName(const FRAME_COUNTER& counter)
+{
+    switch ( counter )
+    {
+        case FC_GRABBED:
+            return "frames_grabbed";
+        case FC_GRAB_ERRORS:
+            return "grab_errors";
+        case FC_PUBLISHED:
+            return "frames_published";
+        case FC_MISSED:
+            return "frames_missed";
+        case FC_CRC_ERRORS:
+            return "crc_errors";
+        case FC_SKIPPED:
+            return "frames_skipped";
+        default:
+            return "unknown";
+    }
+}
+
+}  // namespace pylon_camera
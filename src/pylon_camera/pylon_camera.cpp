@@ -28,6 +28,7 @@
  *****************************************************************************/
 
 #include <pylon_camera/internal/pylon_camera.h>
+#include <boost/thread/mutex.hpp>
 #include <string>
 #include <vector>
 
@@ -39,20 +40,31 @@ enum PYLON_CAM_TYPE
     GIGE = 1,
     USB = 2,
     DART = 3,
+    CAMEMU = 4,
     UNKNOWN = -1,
 };
 
 PylonCamera::PylonCamera()
     : device_user_id_("")
+    , serial_number_("")
     , img_rows_(0)
     , img_cols_(0)
     , img_size_byte_(0)
+    , packed_bits_(0)
+    , state_()
+    , num_published_states_(0)
+    , state_mutex_()
+    , acquisition_mode_(AM_SOFTWARE_TRIGGER)
+    , clock_model_()
+    , statistics_(nullptr)
     , grab_timeout_(-1.0)
     , is_ready_(false)
     , is_binary_exposure_search_running_(false)
     , max_brightness_tolerance_(2.5)
     , binary_exp_search_(nullptr)
-{}
+{
+    publishState(new CameraStateSnapshot());
+}
 
 PYLON_CAM_TYPE detectPylonCamType(const Pylon::CDeviceInfo& device_info)
 {
@@ -92,11 +104,18 @@ PYLON_CAM_TYPE detectPylonCamType(const Pylon::CDeviceInfo& device_info)
                 return UNKNOWN;
             }
         }
+        else if ( device_class == "BaslerCamEmu" )
+        {
+            // the emulator of the pylon SDK (enabled by PYLON_CAMEMU) follows
+            // the SFNC 3 feature names of the USB cameras, but only provides
+            // a subset of their features
+            return CAMEMU;
+        }
         else
         {
-            ROS_ERROR_STREAM("Detected Camera Type is neither 'BaslerUsb', nor "
-                << "'BaslerGigE'. Up to now, other cameras not supported by "
-                << "this pkg!");
+            ROS_ERROR_STREAM("Detected Camera Type is neither 'BaslerUsb', "
+                << "'BaslerGigE' nor 'BaslerCamEmu'. Up to now, other cameras "
+                << "are not supported by this pkg!");
             return UNKNOWN;
         }
     }
@@ -118,85 +137,280 @@ PylonCamera* createFromDevice(PYLON_CAM_TYPE cam_type, Pylon::IPylonDevice* devi
             return new PylonUSBCamera(device);
         case DART:
             return new PylonDARTCamera(device);
+        case CAMEMU:
+            return new PylonCamEmuCamera(device);
         case UNKNOWN:
         default:
             return nullptr;
     }
 }
 
+bool matchesDeviceUserID(const std::string& device_user_id_found,
+                         const std::string& device_user_id_to_open)
+{
+    // either the full ID or its suffix has to match
+    return (0 == device_user_id_to_open.compare(device_user_id_found)) ||
+           (device_user_id_to_open.length() < device_user_id_found.length() &&
+           (0 == device_user_id_found.compare(device_user_id_found.length() -
+                                               device_user_id_to_open.length(),
+                                               device_user_id_to_open.length(),
+                                               device_user_id_to_open) ));
+}
+
+void keepPylonInitialized()
+{
+    // Every camera holds a reference to the pylon runtime, which it releases
+    // on destruction. This one keeps the runtime initialized till the
+    // process exits, so that retries don't initialize and terminate it again.
+    static Pylon::PylonAutoInitTerm auto_init_term;
+}
+
+/**
+ * Enumerates the devices of one transport layer, respectively of all if the
+ * device class is empty. The result is cached for a short time, so that the
+ * cameras opened in a row (e.g. by the nodelets of one manager) share a
+ * single enumeration.
+ */
+void enumerateDevices(const std::string& device_class,
+                      const bool& use_cache,
+                      Pylon::DeviceInfoList_t& device_list)
+{
+    static boost::mutex cache_mutex;
+    static std::string cached_device_class;
+    static Pylon::DeviceInfoList_t cached_device_list;
+    static ros::WallTime cache_stamp;
+
+    boost::lock_guard<boost::mutex> lock(cache_mutex);
+    if ( use_cache && !cached_device_list.empty() &&
+         cached_device_class == device_class &&
+         ros::WallTime::now() - cache_stamp < ros::WallDuration(2.0) )
+    {
+        device_list = cached_device_list;
+        return;
+    }
+
+    Pylon::CTlFactory& tl_factory = Pylon::CTlFactory::GetInstance();
+    device_list.clear();
+    if ( device_class.empty() )
+    {
+        tl_factory.EnumerateDevices(device_list);
+    }
+    else
+    {
+        Pylon::ITransportLayer* tl = tl_factory.CreateTl(device_class.c_str());
+        if ( tl )
+        {
+            tl->EnumerateDevices(device_list);
+            tl_factory.ReleaseTl(tl);
+        }
+    }
+    cached_device_class = device_class;
+    cached_device_list = device_list;
+    cache_stamp = ros::WallTime::now();
+}
+
+/**
+ * Searches the device with the given DeviceUserID, the first one if it's
+ * empty. A cached enumeration is only trusted if it contains the device.
+ * @return false if the device has not been found
+ */
+bool findDeviceByUserID(const std::string& device_user_id_to_open,
+                        const std::string& device_class,
+                        Pylon::CDeviceInfo& device_info)
+{
+    Pylon::DeviceInfoList_t device_list;
+    for ( int attempt = 0; attempt < 2; ++attempt )
+    {
+        enumerateDevices(device_class, attempt == 0, device_list);
+        for ( Pylon::DeviceInfoList_t::const_iterator it = device_list.begin();
+              it != device_list.end(); ++it )
+        {
+            std::string device_user_id_found(it->GetUserDefinedName());
+            if ( device_user_id_to_open.empty() ||
+                 matchesDeviceUserID(device_user_id_found, device_user_id_to_open) )
+            {
+                device_info = *it;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * Creates the device and the matching PylonCamera instance. The device info
+ * is either the result of an enumeration, or only holds the properties that
+ * identify the device, in which case pylon searches it directly.
+ * @param device_info the device to create
+ * @param start the time the creation has been started, for logging
+ * @param found the time the device info has been set up, for logging
+ * @return new PylonCamera instance or NULL if the device couldn't be created
+ */
+PylonCamera* createFromDeviceInfo(const Pylon::CDeviceInfo& device_info,
+                                  const ros::WallTime& start,
+                                  const ros::WallTime& found)
+{
+    Pylon::CTlFactory& tl_factory = Pylon::CTlFactory::GetInstance();
+    Pylon::IPylonDevice* device = tl_factory.CreateDevice(device_info);
+    const ros::WallTime created = ros::WallTime::now();
+
+    const Pylon::CDeviceInfo& created_device_info = device->GetDeviceInfo();
+    PYLON_CAM_TYPE cam_type = detectPylonCamType(created_device_info);
+    if ( cam_type == UNKNOWN )
+    {
+        tl_factory.DestroyDevice(device);
+        return nullptr;
+    }
+    // the reference is released by the destructor of the camera
+    Pylon::PylonInitialize();
+    PylonCamera* new_cam_ptr = createFromDevice(cam_type, device);
+
+    ROS_INFO_STREAM("Created camera " << created_device_info.GetModelName()
+            << " with serial number " << created_device_info.GetSerialNumber()
+            << " and DeviceUserID " << created_device_info.GetUserDefinedName()
+            << " in " << 1e3 * (ros::WallTime::now() - start).toSec() << " ms ("
+            << "lookup: " << 1e3 * (found - start).toSec() << " ms, "
+            << "device creation: " << 1e3 * (created - found).toSec() << " ms)");
+    return new_cam_ptr;
+}
+
 PylonCamera* PylonCamera::create(const std::string& device_user_id_to_open)
 {
     try
     {
-        // Before using any pylon methods, the pylon runtime must be initialized.
-        Pylon::PylonInitialize();
+        keepPylonInitialized();
+        const ros::WallTime start = ros::WallTime::now();
+        Pylon::CDeviceInfo device_info;
+        if ( !findDeviceByUserID(device_user_id_to_open, "", device_info) )
+        {
+            ROS_ERROR_STREAM("Couldn't find the camera that matches the "
+                << "given DeviceUserID: " << device_user_id_to_open << "! "
+                << "Either the ID is wrong or the cam is not yet connected");
+            return nullptr;
+        }
+        return createFromDeviceInfo(device_info, start, ros::WallTime::now());
+    }
+    catch ( GenICam::GenericException &e )
+    {
+        ROS_ERROR_STREAM("An exception while opening the desired camera with "
+            << "DeviceUserID: " << device_user_id_to_open << " occurred: \r\n"
+            << e.GetDescription());
+        return nullptr;
+    }
+}
 
-        Pylon::CTlFactory& tl_factory = Pylon::CTlFactory::GetInstance();
-        Pylon::DeviceInfoList_t device_list;
+PylonCamera* PylonCamera::create(const PylonCameraParameter& parameters)
+{
+    try
+    {
+        keepPylonInitialized();
+        const ros::WallTime start = ros::WallTime::now();
 
-        // EnumerateDevices() returns the number of devices found
-        if ( 0 == tl_factory.EnumerateDevices(device_list) )
+        Pylon::CDeviceInfo device_info;
+        if ( !parameters.ip_address_.empty() )
         {
-            Pylon::PylonTerminate();
-            ROS_ERROR_ONCE("No camera present");
-            return nullptr;
+            // unicast discovery of a single GigE device, no enumeration
+            device_info.SetDeviceClass("BaslerGigE");
+            device_info.SetIpAddress(parameters.ip_address_.c_str());
         }
-        else
+        else if ( !parameters.serial_number_.empty() )
         {
-            Pylon::DeviceInfoList_t::const_iterator it;
-            if ( device_user_id_to_open.empty() )
+            // pylon only searches the transport layer of the device class
+            device_info.SetSerialNumber(parameters.serial_number_.c_str());
+            if ( !parameters.device_class_.empty() )
             {
-                ROS_INFO_STREAM("Found camera with DeviceUserID "
-                            << device_list.front().GetUserDefinedName() << ": "
-                            << device_list.front().GetModelName());
-                PYLON_CAM_TYPE cam_type = detectPylonCamType(device_list.front());
-                PylonCamera* new_cam_ptr = createFromDevice(cam_type,
-                                        tl_factory.CreateDevice(device_list.front()));
-                new_cam_ptr->device_user_id_ = device_list.front().GetUserDefinedName();
-                return new_cam_ptr;
+                device_info.SetDeviceClass(parameters.device_class_.c_str());
             }
-            bool found_desired_device = false;
-            for ( it = device_list.begin(); it != device_list.end(); ++it )
+        }
+        else if ( !findDeviceByUserID(parameters.deviceUserID(),
+                                      parameters.device_class_,
+                                      device_info) )
+        {
+            ROS_ERROR_STREAM("Couldn't find the camera that matches the "
+                << "given DeviceUserID: " << parameters.deviceUserID() << "! "
+                << "Either the ID is wrong or the cam is not yet connected");
+            return nullptr;
+        }
+        return createFromDeviceInfo(device_info, start, ros::WallTime::now());
+    }
+    catch ( GenICam::GenericException &e )
+    {
+        ROS_ERROR_STREAM("An exception while opening the desired camera "
+            << "occurred: \r\n" << e.GetDescription());
+        return nullptr;
+    }
+}
+
+std::vector<PylonCamera*> PylonCamera::create(
+                    const std::vector<std::string>& device_user_ids_to_open)
+{
+    std::vector<PylonCamera*> cameras(device_user_ids_to_open.size(), nullptr);
+    try
+    {
+        // The runtime is reference counted and every camera terminates it
+        // once on destruction, hence it's initialized once per created
+        // camera on top of the one kept for the whole process.
+        keepPylonInitialized();
+
+        Pylon::CTlFactory& tl_factory = Pylon::CTlFactory::GetInstance();
+        Pylon::DeviceInfoList_t device_list;
+        enumerateDevices("", false, device_list);
+
+        // each device can only be opened once
+        std::vector<bool> is_device_used(device_list.size(), false);
+        for ( std::size_t i = 0; i < device_user_ids_to_open.size(); ++i )
+        {
+            const std::string& device_user_id_to_open = device_user_ids_to_open.at(i);
+            for ( std::size_t j = 0; j < device_list.size(); ++j )
             {
-                std::string device_user_id_found(it->GetUserDefinedName());
-                if ( (0 == device_user_id_to_open.compare(device_user_id_found)) ||
-                     (device_user_id_to_open.length() < device_user_id_found.length() &&
-                     (0 == device_user_id_found.compare(device_user_id_found.length() -
-                                                         device_user_id_to_open.length(),
-                                                         device_user_id_to_open.length(),
-                                                         device_user_id_to_open) )
-                     )
-                   )
+                std::string device_user_id_found(device_list[j].GetUserDefinedName());
+                if ( is_device_used.at(j) ||
+                     !( device_user_id_to_open.empty() ||
+                        matchesDeviceUserID(device_user_id_found,
+                                            device_user_id_to_open) ) )
                 {
-                    found_desired_device = true;
-                    break;
+                    continue;
                 }
-            }
-            if ( found_desired_device )
-            {
                 ROS_INFO_STREAM("Found the desired camera with DeviceUserID "
-                            << device_user_id_to_open << ": "
-                            << it->GetModelName());
-                PYLON_CAM_TYPE cam_type = detectPylonCamType(*it);
-                return createFromDevice(cam_type,
-                                        tl_factory.CreateDevice(*it));
+                            << device_user_id_found << ": "
+                            << device_list[j].GetModelName());
+                PYLON_CAM_TYPE cam_type = detectPylonCamType(device_list[j]);
+                if ( cam_type == UNKNOWN )
+                {
+                    break;
+                }
+                Pylon::PylonInitialize();
+                cameras.at(i) = createFromDevice(cam_type,
+                                    tl_factory.CreateDevice(device_list[j]));
+                cameras.at(i)->device_user_id_ = device_user_id_found;
+                is_device_used.at(j) = true;
+                break;
             }
-            else
+            if ( cameras.at(i) == nullptr )
             {
                 ROS_ERROR_STREAM("Couldn't find the camera that matches the "
                     << "given DeviceUserID: " << device_user_id_to_open << "! "
                     << "Either the ID is wrong or the cam is not yet connected");
-                return nullptr;
             }
         }
     }
     catch ( GenICam::GenericException &e )
     {
-        ROS_ERROR_STREAM("An exception while opening the desired camera with "
-            << "DeviceUserID: " << device_user_id_to_open << " occurred: \r\n"
-            << e.GetDescription());
-        return nullptr;
+        ROS_ERROR_STREAM("An exception while opening the desired cameras "
+            << "occurred: \r\n" << e.GetDescription());
     }
+    return cameras;
+}
+
+const ACQUISITION_MODE& PylonCamera::acquisitionMode() const
+{
+    return acquisition_mode_;
+}
+
+bool PylonCamera::isFreeRunning() const
+{
+    return acquisition_mode_ == AM_FREE_RUN_ONE_BY_ONE ||
+           acquisition_mode_ == AM_FREE_RUN_LATEST_IMAGE_ONLY;
 }
 
 const std::string& PylonCamera::deviceUserID() const
@@ -204,6 +418,11 @@ const std::string& PylonCamera::deviceUserID() const
     return device_user_id_;
 }
 
+const std::string& PylonCamera::serialNumber() const
+{
+    return serial_number_;
+}
+
 const size_t& PylonCamera::imageRows() const
 {
     return img_rows_;
@@ -239,6 +458,35 @@ const std::vector<float>& PylonCamera::sequencerExposureTimes() const
     return seq_exp_times_;
 }
 
+const CameraClockModel& PylonCamera::clockModel() const
+{
+    return clock_model_;
+}
+
+void PylonCamera::setStatistics(PipelineStatistics* statistics)
+{
+    statistics_ = statistics;
+}
+
+CameraStateSnapshotConstPtr PylonCamera::state() const
+{
+    boost::lock_guard<boost::mutex> lock(state_mutex_);
+    return state_;
+}
+
+void PylonCamera::publishState(CameraStateSnapshot* state)
+{
+    CameraStateSnapshotConstPtr replaced;
+    {
+        boost::lock_guard<boost::mutex> lock(state_mutex_);
+        state->generation_ = num_published_states_++;
+        replaced = state_;
+        state_.reset(state);
+    }
+    // the replaced snapshot is freed outside of the lock, unless a reader
+    // still holds it
+}
+
 const bool& PylonCamera::isBinaryExposureSearchRunning() const
 {
     return is_binary_exposure_search_running_;
@@ -28,9 +28,18 @@
  *****************************************************************************/
 
 #include <pylon_camera/pylon_camera_node.h>
+#include <pylon_camera/cache_files.h>
 #include <GenApi/GenApi.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
 #include <algorithm>
 #include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <sstream>
+#include <string>
 #include <vector>
 #include "boost/multi_array.hpp"
 
@@ -40,12 +49,30 @@ namespace pylon_camera
 using sensor_msgs::CameraInfo;
 using sensor_msgs::CameraInfoPtr;
 
+namespace
+{
+// pause between failed attempts to reopen a recovered camera, it is doubled
+// with every failure up to the max
+const int MIN_RECOVERY_RETRY_DELAY_MS = 500;
+const int MAX_RECOVERY_RETRY_DELAY_MS = 8000;
+}  // namespace
+
 PylonCameraNode::PylonCameraNode()
-    : nh_("~"),
+    : PylonCameraNode(ros::NodeHandle("~"), true)
+{}
+
+PylonCameraNode::PylonCameraNode(const ros::NodeHandle& nh,
+                                 const bool& shutdown_on_error,
+                                 PylonCamera* pylon_camera,
+                                 const boost::function<bool ()>& stop_requested)
+    : nh_(nh),
       pylon_camera_parameter_set_(),
       set_binning_srv_(nh_.advertiseService("set_binning",
                                             &PylonCameraNode::setBinningCallback,
                                             this)),
+      set_decimation_srv_(nh_.advertiseService("set_decimation",
+                                               &PylonCameraNode::setDecimationCallback,
+                                               this)),
       set_exposure_srv_(nh_.advertiseService("set_exposure",
                                              &PylonCameraNode::setExposureCallback,
                                              this)),
@@ -58,13 +85,27 @@ PylonCameraNode::PylonCameraNode()
       set_brightness_srv_(nh_.advertiseService("set_brightness",
                                                &PylonCameraNode::setBrightnessCallback,
                                                this)),
+      set_metered_brightness_srv_(nh_.advertiseService("set_metered_brightness",
+                                                       &PylonCameraNode::setMeteredBrightnessCallback,
+                                                       this)),
       set_sleeping_srv_(nh_.advertiseService("set_sleeping",
                                              &PylonCameraNode::setSleepingCallback,
                                              this)),
+      enable_statistics_srv_(nh_.advertiseService("enable_statistics",
+                                                  &PylonCameraNode::enableStatisticsCallback,
+                                                  this)),
+      set_configuration_srv_(nh_.advertiseService("set_configuration",
+                                                  &PylonCameraNode::setConfigurationCallback,
+                                                  this)),
+      set_roi_srv_(nh_.advertiseService("set_roi",
+                                        &PylonCameraNode::setROICallback,
+                                        this)),
       set_user_output_srvs_(),
-      pylon_camera_(nullptr),
+      pylon_camera_(pylon_camera),
       it_(new image_transport::ImageTransport(nh_)),
       img_raw_pub_(it_->advertiseCamera("image_raw", 1)),
+      img_color_pub_(it_->advertise("image_color", 1)),
+      img_mono_pub_(it_->advertise("image_mono", 1)),
       img_rect_pub_(nullptr),
       grab_imgs_raw_as_(
               nh_,
@@ -74,14 +115,50 @@ PylonCameraNode::PylonCameraNode()
                           _1),
               false),
       grab_imgs_rect_as_(nullptr),
-      pinhole_model_(nullptr),
-      cv_bridge_img_rect_(nullptr),
+      rectifier_(nullptr),
+      camera_info_cache_(),
+      next_camera_info_refresh_(),
+      frame_ring_(nullptr),
+      acquisition_thread_(),
+      stop_acquisition_(false),
+      next_clock_sync_(),
+      last_num_dropped_(0),
+      num_skipped_(0),
+      publish_mutex_(),
+      frame_ready_mutex_(),
+      frame_ready_cb_(),
+      statistics_(),
+      statistics_pub_(nh_.advertise<diagnostic_msgs::DiagnosticStatus>("statistics", 1)),
+      diagnostics_pub_(nh_.advertise<diagnostic_msgs::DiagnosticArray>("/diagnostics", 1)),
+      statistics_timer_(),
+      statistics_num_dropped_(0),
+      frame_info_pub_(nh_.advertise<pylon_camera::FrameInfo>("frame_info", 10)),
+      has_last_frame_counter_(false),
+      last_frame_counter_(0),
+      recovery_thread_(),
+      recovery_mutex_(),
+      recovery_cond_(),
+      camera_removed_(false),
+      stop_recovery_(false),
+      is_recovering_(false),
+      startup_snapshot_dir_(),
+      startup_snapshot_file_(),
+      snapshot_restored_(false),
+      startup_time_(ros::WallTime::now()),
+      first_frame_published_(false),
       camera_info_manager_(new camera_info_manager::CameraInfoManager(nh_)),
-      sampling_indices_(),
       brightness_exp_lut_(),
-      is_sleeping_(false)
+      brightness_exp_lut_mode_(MM_AVERAGE),
+      brightness_exp_lut_roi_(),
+      metering_mask_(),
+      is_sleeping_(false),
+      is_initialized_(false),
+      shutdown_on_error_(shutdown_on_error),
+      stop_requested_(stop_requested)
 {
     init();
+    recovery_thread_ = boost::thread(
+                        boost::bind(&PylonCameraNode::recoveryLoop, this));
 }
 
 void PylonCameraNode::init()
@@ -93,44 +170,295 @@ void PylonCameraNode::init()
     // in case they are provided
     pylon_camera_parameter_set_.readFromRosParameterServer(nh_);
 
+    statistics_.setEnabled(pylon_camera_parameter_set_.enable_statistics_);
+    if ( !statistics_timer_.isValid() )
+    {
+        statistics_timer_ = nh_.createWallTimer(
+                    ros::WallDuration(pylon_camera_parameter_set_.statistics_interval_),
+                    &PylonCameraNode::publishStatistics,
+                    this);
+    }
+
     // creating the target PylonCamera-Object with the specified
-    // device_user_id, registering the Software-Trigger-Mode, starting the
+    // device_user_id, registering the acquisition mode, starting the
     // communication with the device and enabling the desired startup-settings
+    is_initialized_ = false;
+    const ros::WallTime start = ros::WallTime::now();
     if ( !initAndRegister() )
     {
-        ros::shutdown();
+        handleInitError();
         return;
     }
+    const ros::WallTime opened = ros::WallTime::now();
 
     // starting the grabbing procedure with the desired image-settings
     if ( !startGrabbing() )
+    {
+        handleInitError();
+        return;
+    }
+
+    startAcquisition();
+    is_initialized_ = true;
+    const ros::WallTime ready = ros::WallTime::now();
+    ROS_INFO_STREAM("Camera ready after "
+            << 1e3 * (ready - start).toSec() << " ms (opening "
+            << "and configuration: " << 1e3 * (opened - start).toSec()
+            << " ms, start of grabbing: "
+            << 1e3 * (ready - opened).toSec() << " ms)");
+}
+
+const bool& PylonCameraNode::isInitialized() const
+{
+    return is_initialized_;
+}
+
+bool PylonCameraNode::isStopRequested() const
+{
+    return !ros::ok() || ( stop_requested_ && stop_requested_() );
+}
+
+void PylonCameraNode::handleInitError()
+{
+    if ( shutdown_on_error_ )
     {
         ros::shutdown();
+    }
+    else
+    {
+        ROS_ERROR("Initializing the camera failed, stop spinning");
+    }
+}
+
+void PylonCameraNode::startAcquisition()
+{
+    stopAcquisition();
+    {
+        boost::lock_guard<boost::mutex> lock(publish_mutex_);
+        frame_ring_ = new FrameRing<sensor_msgs::ImagePtr>(
+                                pylon_camera_parameter_set_.frame_ring_size_,
+                                pylon_camera_parameter_set_.overflow_policy_);
+    }
+    stop_acquisition_ = false;
+    next_clock_sync_ = ros::WallTime::now();
+    last_num_dropped_ = 0;
+    num_skipped_ = 0;
+    if ( pylon_camera_parameter_set_.event_driven_grabbing_ )
+    {
+        pylon_camera_->setImageCallback(
+                boost::bind(&PylonCameraNode::imageCallback, this, _1, _2));
+        ROS_INFO_STREAM("Started event-driven acquisition with a frame ring "
+                << "of size " << frame_ring_->capacity() << " and overflow "
+                << "policy '" << pylon_camera_parameter_set_.overflowPolicyString()
+                << "'");
+        return;
+    }
+    acquisition_thread_ = boost::thread(
+                        boost::bind(&PylonCameraNode::acquisitionLoop, this));
+    ROS_INFO_STREAM("Started acquisition thread with a frame ring of size "
+            << frame_ring_->capacity() << " and overflow policy '"
+            << pylon_camera_parameter_set_.overflowPolicyString() << "'");
+}
+
+void PylonCameraNode::stopAcquisition()
+{
+    stop_acquisition_ = true;
+    if ( frame_ring_ )
+    {
+        // wakes up the acquisition thread or the image callback if it is
+        // blocked by a full ring
+        frame_ring_->close();
+    }
+    if ( acquisition_thread_.joinable() )
+    {
+        acquisition_thread_.join();
+    }
+    if ( pylon_camera_ )
+    {
+        // waits till a running image callback has returned
+        pylon_camera_->setImageCallback(PylonCamera::ImageCallback());
+    }
+    boost::lock_guard<boost::mutex> lock(publish_mutex_);
+    if ( frame_ring_ )
+    {
+        // the remaining frames hand their grab buffers back
+        delete frame_ring_;
+        frame_ring_ = nullptr;
+    }
+}
+
+void PylonCameraNode::acquisitionLoop()
+{
+    pinAcquisitionThread();
+    ros::Rate r(frameRate());
+    while ( ros::ok() && !stop_acquisition_ )
+    {
+        // keep track of the camera clock drift, also while nobody is
+        // subscribed, so that the first frames are stamped correctly
+        {
+            boost::lock_guard<boost::recursive_mutex> lock(grab_mutex_);
+            syncClockIfDue();
+        }
+
+        // frames are only grabbed if subscribers are available, the
+        // GrabImages-Actions grab on their own
+        if ( !isSleeping() && ( img_raw_pub_.getNumSubscribers() || getNumSubscribersRect() ||
+                                getNumSubscribersConverted() ) )
+        {
+            sensor_msgs::ImagePtr img;
+            {
+                boost::lock_guard<boost::recursive_mutex> lock(grab_mutex_);
+                if ( grabImage() )
+                {
+                    img = img_raw_ptr_;
+                }
+            }
+            if ( img )
+            {
+                pushFrame(img);
+            }
+        }
+        else
+        {
+            // the next grabbed frame doesn't follow the last one
+            boost::lock_guard<boost::recursive_mutex> lock(grab_mutex_);
+            has_last_frame_counter_ = false;
+        }
+        // In the free-running acquisition modes the camera streams with the
+        // same frame rate, hence grabbing already blocks till the next frame
+        // has been retrieved and the rate only throttles the loop while
+        // nobody is subscribed
+        r.sleep();
+    }
+}
+
+void PylonCameraNode::imageCallback(const sensor_msgs::ImagePtr& img,
+                                    const FrameMetadata& metadata)
+{
+    statistics_.count(FC_GRABBED);
+    // Blocking the grab loop thread would stall the camera, and it would
+    // deadlock with StopGrabbing() or grab() calls holding the mutex
+    boost::unique_lock<boost::recursive_mutex> lock(grab_mutex_,
+                                                    boost::try_to_lock);
+    if ( stop_acquisition_ )
+    {
+        return;
+    }
+    if ( !lock.owns_lock() )
+    {
+        // the frame is lost for the subscribers just like an overflow of
+        // the frame ring, hence it must not vanish silently
+        statistics_.count(FC_SKIPPED);
+        const uint64_t num_skipped = ++num_skipped_;
+        ROS_WARN_STREAM_THROTTLE(5.0, "Skipped " << num_skipped << " frames "
+                << "so far, because they arrived while the camera was busy "
+                << "with a reconfiguration, an action or the brightness search");
+        return;
+    }
+    // pylon starts a new grab loop thread whenever grabbing is restarted
+    static thread_local bool is_pinned = false;
+    if ( !is_pinned )
+    {
+        pinAcquisitionThread();
+        is_pinned = true;
+    }
+    syncClockIfDue();
+
+    if ( isSleeping() || !( img_raw_pub_.getNumSubscribers() || getNumSubscribersRect() ||
+                            getNumSubscribersConverted() ) )
+    {
+        has_last_frame_counter_ = false;
+        return;
+    }
+    if ( !isPayloadValid(metadata) )
+    {
         return;
     }
+    setupImageMsg(img, metadata);
+    publishFrameInfo(img->header, metadata);
+    lock.unlock();
+    pushFrame(img);
+}
+
+void PylonCameraNode::syncClockIfDue()
+{
+    if ( pylon_camera_parameter_set_.timestamp_mode_ != TM_HOST &&
+         ros::WallTime::now() >= next_clock_sync_ )
+    {
+        pylon_camera_->syncClock();
+        next_clock_sync_ = ros::WallTime::now() + ros::WallDuration(
+                            pylon_camera_parameter_set_.clock_sync_interval_);
+    }
+}
+
+void PylonCameraNode::pinAcquisitionThread()
+{
+    const int cpu = pylon_camera_parameter_set_.cpu_affinity_;
+    if ( cpu < 0 )
+    {
+        return;
+    }
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(cpu, &cpu_set);
+    if ( pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpu_set) != 0 )
+    {
+        ROS_WARN_STREAM("Can't pin the acquisition thread to CPU " << cpu);
+        return;
+    }
+    ROS_INFO_STREAM("Pinned the acquisition thread to CPU " << cpu);
+}
+
+void PylonCameraNode::pushFrame(const sensor_msgs::ImagePtr& img)
+{
+    frame_ring_->push(img);
+    boost::function<void ()> frame_ready_cb;
+    {
+        boost::lock_guard<boost::mutex> lock(frame_ready_mutex_);
+        frame_ready_cb = frame_ready_cb_;
+    }
+    if ( frame_ready_cb )
+    {
+        frame_ready_cb();
+    }
+
+    const uint64_t num_dropped = frame_ring_->numDropped();
+    if ( num_dropped != last_num_dropped_ )
+    {
+        ROS_WARN_STREAM_THROTTLE(5.0, "Publishing can't keep up with "
+                << "the acquisition: dropped " << num_dropped << " of "
+                << frame_ring_->numPushed() << " frames so far");
+        last_num_dropped_ = num_dropped;
+    }
 }
 
 bool PylonCameraNode::initAndRegister()
 {
-    pylon_camera_ = PylonCamera::create(
-                                    pylon_camera_parameter_set_.deviceUserID());
+    // the camera might have been passed to the constructor
+    if ( pylon_camera_ == nullptr )
+    {
+        pylon_camera_ = PylonCamera::create(pylon_camera_parameter_set_);
+    }
 
     if ( pylon_camera_ == nullptr )
     {
         // wait and retry until a camera is present
         ros::Time end = ros::Time::now() + ros::Duration(15.0);
         ros::Rate r(0.5);
-        while ( ros::ok() && pylon_camera_ == nullptr )
+        while ( !isStopRequested() && pylon_camera_ == nullptr )
         {
-            pylon_camera_ = PylonCamera::create(
-                                    pylon_camera_parameter_set_.deviceUserID());
+            pylon_camera_ = PylonCamera::create(pylon_camera_parameter_set_);
             if ( ros::Time::now() > end )
             {
                 ROS_WARN_STREAM("No camera present. Keep waiting ...");
                 end = ros::Time::now() + ros::Duration(15.0);
             }
             r.sleep();
-            ros::spinOnce();
+            // the callbacks of a nodelet are processed by the manager
+            if ( nh_.getCallbackQueue() == ros::getGlobalCallbackQueue() )
+            {
+                ros::spinOnce();
+            }
         }
     }
 
@@ -139,15 +467,20 @@ bool PylonCameraNode::initAndRegister()
         pylon_camera_parameter_set_.adaptDeviceUserId(nh_, pylon_camera_->deviceUserID());
     }
 
-    if ( !ros::ok() )
+    if ( isStopRequested() )
     {
         return false;
     }
 
-    if ( !pylon_camera_->registerCameraConfiguration() )
+    pylon_camera_->setStatistics(&statistics_);
+    pylon_camera_->setRemovalCallback(
+                    boost::bind(&PylonCameraNode::onCameraRemoved, this));
+
+    if ( !pylon_camera_->registerCameraConfiguration(
+                            pylon_camera_parameter_set_.acquisition_mode_) )
     {
         ROS_ERROR_STREAM("Error while registering the camera configuration to "
-            << "software-trigger mode!");
+            << pylon_camera_parameter_set_.acquisitionModeString() << " mode!");
         return false;
     }
 
@@ -157,16 +490,105 @@ bool PylonCameraNode::initAndRegister()
         return false;
     }
 
+    return applyStartupSettings();
+}
+
+bool PylonCameraNode::applyStartupSettings()
+{
+    snapshot_restored_ = false;
+    startup_snapshot_file_.clear();
+    if ( pylon_camera_parameter_set_.use_startup_snapshots_ )
+    {
+        startup_snapshot_dir_ = pylon_camera_parameter_set_.startup_snapshot_dir_;
+        if ( startup_snapshot_dir_.empty() )
+        {
+            startup_snapshot_dir_ = cache_files::defaultCacheDir();
+        }
+        if ( !startup_snapshot_dir_.empty() )
+        {
+            startup_snapshot_file_ = startup_snapshot_dir_ + "/"
+                    + pylon_camera_->serialNumber() + "_"
+                    + pylon_camera_parameter_set_.startupSnapshotHash() + ".pfs";
+        }
+    }
+
+    if ( !startup_snapshot_file_.empty() &&
+         access(startup_snapshot_file_.c_str(), R_OK) == 0 )
+    {
+        const ros::WallTime start = ros::WallTime::now();
+        if ( pylon_camera_->loadFeatureSnapshot(startup_snapshot_file_) )
+        {
+            snapshot_restored_ = true;
+            ROS_INFO_STREAM("Restored the feature snapshot "
+                    << startup_snapshot_file_ << " in "
+                    << 1e3 * (ros::WallTime::now() - start).toSec() << " ms");
+            return true;
+        }
+        // the default user set loaded below resets a partially restored
+        // snapshot, which is saved again once the camera is configured
+        ROS_WARN_STREAM("Will configure the camera without the snapshot");
+        std::remove(startup_snapshot_file_.c_str());
+    }
+
     if ( !pylon_camera_->applyCamSpecificStartupSettings(pylon_camera_parameter_set_) )
     {
         ROS_ERROR_STREAM("Error while applying the cam specific startup settings "
                 << "(e.g. mtu size for GigE, ...) to the camera!");
         return false;
     }
-
     return true;
 }
 
+void PylonCameraNode::saveStartupSnapshot()
+{
+    if ( !cache_files::createDirectories(startup_snapshot_dir_, "feature snapshots") )
+    {
+        return;
+    }
+    if ( pylon_camera_->saveFeatureSnapshot(startup_snapshot_file_) )
+    {
+        ROS_INFO_STREAM("Saved the feature snapshot " << startup_snapshot_file_);
+        removeOutdatedStartupSnapshots();
+    }
+}
+
+void PylonCameraNode::removeOutdatedStartupSnapshots()
+{
+    DIR* dir = opendir(startup_snapshot_dir_.c_str());
+    if ( dir == nullptr )
+    {
+        return;
+    }
+    // the parameters changed at runtime are part of the hash, hence every
+    // recovery after a change would leave another snapshot behind
+    const std::string prefix = pylon_camera_->serialNumber() + "_";
+    const std::string suffix = ".pfs";
+    const std::string current = startup_snapshot_file_.substr(
+                                    startup_snapshot_dir_.size() + 1);
+    std::vector<std::string> outdated;
+    while ( const struct dirent* entry = readdir(dir) )
+    {
+        const std::string name = entry->d_name;
+        if ( name != current &&
+             name.size() > prefix.size() + suffix.size() &&
+             name.compare(0, prefix.size(), prefix) == 0 &&
+             name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0 )
+        {
+            outdated.push_back(name);
+        }
+    }
+    closedir(dir);
+
+    for ( const std::string& name : outdated )
+    {
+        const std::string file = startup_snapshot_dir_ + "/" + name;
+        if ( std::remove(file.c_str()) == 0 )
+        {
+            ROS_DEBUG_STREAM("Removed the outdated feature snapshot " << file);
+        }
+    }
+}
+
 bool PylonCameraNode::startGrabbing()
 {
     if ( !pylon_camera_->startGrabbing(pylon_camera_parameter_set_) )
@@ -175,11 +597,19 @@ bool PylonCameraNode::startGrabbing()
         return false;
     }
 
-    set_user_output_srvs_.resize(pylon_camera_->numUserOutputs());
-    for ( int i = 0; i < set_user_output_srvs_.size(); ++i )
+    // the services are kept when the camera is recovered
+    if ( set_user_output_srvs_.size() != pylon_camera_->numUserOutputs() )
+    {
+        for ( ros::ServiceServer& user_output_srv : set_user_output_srvs_ )
+        {
+            user_output_srv.shutdown();
+        }
+        set_user_output_srvs_.clear();
+    }
+    for ( int i = set_user_output_srvs_.size(); i < pylon_camera_->numUserOutputs(); ++i )
     {
         std::string srv_name = "set_user_output_" + std::to_string(i);
-        set_user_output_srvs_.at(i) =
+        set_user_output_srvs_.push_back(
             nh_.advertiseService< camera_control_msgs::SetBool::Request,
                                   camera_control_msgs::SetBool::Response >(
                                     srv_name,
@@ -187,7 +617,7 @@ bool PylonCameraNode::startGrabbing()
                                                 this,
                                                 i,
                                                 _1,
-                                                _2));
+                                                _2)));
     }
 
     img_raw_msg_.header.frame_id = pylon_camera_parameter_set_.cameraFrame();
@@ -207,12 +637,11 @@ bool PylonCameraNode::startGrabbing()
                 << "] name not valid for camera_info_manager");
     }
 
-    setupSamplingIndices(sampling_indices_,
-                         pylon_camera_->imageRows(),
-                         pylon_camera_->imageCols(),
-                         pylon_camera_parameter_set_.downsampling_factor_exp_search_);
-
-    grab_imgs_raw_as_.start();
+    // the action server keeps running while the camera is recovered
+    if ( !is_initialized_ )
+    {
+        grab_imgs_raw_as_.start();
+    }
 
     // Initial setting of the CameraInfo-msg, assuming no calibration given
     CameraInfo initial_cam_info;
@@ -248,28 +677,74 @@ bool PylonCameraNode::startGrabbing()
             ROS_WARN("Will only provide distorted /image_raw images!");
         }
     }
-
-    if ( pylon_camera_parameter_set_.binning_x_given_ )
-    {
-        size_t reached_binning_x;
-        setBinningX(pylon_camera_parameter_set_.binning_x_, reached_binning_x);
-        ROS_INFO_STREAM("Setting horizontal binning_x to "
-                << pylon_camera_parameter_set_.binning_x_);
-        ROS_WARN_STREAM("The image width of the camera_info-msg will "
-            << "be adapted, so that the binning_x value in this msg remains 1");
+    refreshCameraInfoCache(true);
+
+    if ( ( pylon_camera_parameter_set_.binning_x_given_ ||
+           pylon_camera_parameter_set_.binning_y_given_ ||
+           pylon_camera_parameter_set_.decimation_x_given_ ||
+           pylon_camera_parameter_set_.decimation_y_given_ ||
+           pylon_camera_parameter_set_.downsampling_given_ ||
+           pylon_camera_parameter_set_.roi_given_ ) && !snapshot_restored_ )
+    {
+        // binning, decimation and region of interest are applied with a
+        // single restart of grabbing
+        CameraConfiguration target, reached;
+        target.has_binning_ = true;
+        target.binning_x_ = pylon_camera_->currentBinningX();
+        target.binning_y_ = pylon_camera_->currentBinningY();
+        target.has_decimation_ = true;
+        target.decimation_x_ = pylon_camera_->currentDecimationX();
+        target.decimation_y_ = pylon_camera_->currentDecimationY();
+        if ( pylon_camera_parameter_set_.downsampling_given_ )
+        {
+            pylon_camera_->resolveDownsampling(
+                    pylon_camera_parameter_set_.downsampling_x_,
+                    pylon_camera_parameter_set_.downsampling_y_,
+                    pylon_camera_parameter_set_.downsampling_preference_ == DP_FRAME_RATE,
+                    target);
+        }
+        // explicitly given factors override the downsampling
+        if ( pylon_camera_parameter_set_.binning_x_given_ )
+        {
+            target.binning_x_ = pylon_camera_parameter_set_.binning_x_;
+        }
+        if ( pylon_camera_parameter_set_.binning_y_given_ )
+        {
+            target.binning_y_ = pylon_camera_parameter_set_.binning_y_;
+        }
+        if ( pylon_camera_parameter_set_.decimation_x_given_ )
+        {
+            target.decimation_x_ = pylon_camera_parameter_set_.decimation_x_;
+        }
+        if ( pylon_camera_parameter_set_.decimation_y_given_ )
+        {
+            target.decimation_y_ = pylon_camera_parameter_set_.decimation_y_;
+        }
+        target.has_roi_ = pylon_camera_parameter_set_.roi_given_;
+        target.roi_offset_x_ = pylon_camera_parameter_set_.roi_offset_x_;
+        target.roi_offset_y_ = pylon_camera_parameter_set_.roi_offset_y_;
+        target.roi_width_ = pylon_camera_parameter_set_.roi_width_;
+        target.roi_height_ = pylon_camera_parameter_set_.roi_height_;
+        reconfigure(target, reached);
+        ROS_INFO_STREAM("Setting binning to [" << target.binning_x_ << ", "
+                << target.binning_y_ << "], reached: [" << reached.binning_x_
+                << ", " << reached.binning_y_ << "]");
+        ROS_INFO_STREAM("Setting decimation to [" << target.decimation_x_
+                << ", " << target.decimation_y_ << "], reached: ["
+                << reached.decimation_x_ << ", " << reached.decimation_y_ << "]");
+        if ( target.has_roi_ )
+        {
+            ROS_INFO_STREAM("Setting region of interest to "
+                << reached.roi_width_ << "x" << reached.roi_height_ << "+"
+                << reached.roi_offset_x_ << "+" << reached.roi_offset_y_);
+        }
     }
-
-    if ( pylon_camera_parameter_set_.binning_y_given_ )
+    else
     {
-        size_t reached_binning_y;
-        setBinningY(pylon_camera_parameter_set_.binning_y_, reached_binning_y);
-        ROS_INFO_STREAM("Setting vertical binning_y to "
-                << pylon_camera_parameter_set_.binning_y_);
-        ROS_WARN_STREAM("The image height of the camera_info-msg will "
-            << "be adapted, so that the binning_y value in this msg remains 1");
+        updateImageGeometry();
     }
 
-    if ( pylon_camera_parameter_set_.exposure_given_ )
+    if ( pylon_camera_parameter_set_.exposure_given_ && !snapshot_restored_ )
     {
         float reached_exposure;
         setExposure(pylon_camera_parameter_set_.exposure_, reached_exposure);
@@ -278,7 +753,7 @@ bool PylonCameraNode::startGrabbing()
                 << reached_exposure);
     }
 
-    if ( pylon_camera_parameter_set_.gain_given_ )
+    if ( pylon_camera_parameter_set_.gain_given_ && !snapshot_restored_ )
     {
         float reached_gain;
         setGain(pylon_camera_parameter_set_.gain_, reached_gain);
@@ -287,7 +762,7 @@ bool PylonCameraNode::startGrabbing()
                 << reached_gain);
     }
 
-    if ( pylon_camera_parameter_set_.gamma_given_ )
+    if ( pylon_camera_parameter_set_.gamma_given_ && !snapshot_restored_ )
     {
         float reached_gamma;
         setGamma(pylon_camera_parameter_set_.gamma_, reached_gamma);
@@ -301,7 +776,9 @@ bool PylonCameraNode::startGrabbing()
         setBrightness(pylon_camera_parameter_set_.brightness_,
                       reached_brightness,
                       pylon_camera_parameter_set_.exposure_auto_,
-                      pylon_camera_parameter_set_.gain_auto_);
+                      pylon_camera_parameter_set_.gain_auto_,
+                      pylon_camera_parameter_set_.metering_mode_,
+                      pylon_camera_parameter_set_.metering_roi_);
         ROS_INFO_STREAM("Setting brightness to: "
                 << pylon_camera_parameter_set_.brightness_ << ", reached: "
                 << reached_brightness);
@@ -326,11 +803,22 @@ bool PylonCameraNode::startGrabbing()
             << "encoding = '" << pylon_camera_->currentROSEncoding() << "', "
             << "binning = [" << pylon_camera_->currentBinningX() << ", "
             << pylon_camera_->currentBinningY() << "], "
+            << "decimation = [" << pylon_camera_->currentDecimationX() << ", "
+            << pylon_camera_->currentDecimationY() << "], "
             << "exposure = " << pylon_camera_->currentExposure() << ", "
             << "gain = " << pylon_camera_->currentGain() << ", "
             << "gamma = " <<  pylon_camera_->currentGamma() << ", "
             << "shutter mode = "
-            << pylon_camera_parameter_set_.shutterModeString());
+            << pylon_camera_parameter_set_.shutterModeString() << ", "
+            << "acquisition mode = "
+            << pylon_camera_parameter_set_.acquisitionModeString() << ", "
+            << "timestamp mode = "
+            << pylon_camera_parameter_set_.timestampModeString());
+
+    if ( !startup_snapshot_file_.empty() && !snapshot_restored_ )
+    {
+        saveStartupSnapshot();
+    }
 
     // Framerate Settings
     if ( pylon_camera_->maxPossibleFramerate() < pylon_camera_parameter_set_.frameRate() )
@@ -373,18 +861,21 @@ void PylonCameraNode::setupRectification()
         grab_imgs_rect_as_->start();
     }
 
-    if ( !pinhole_model_ )
+    if ( !rectifier_ )
     {
-        pinhole_model_ = new image_geometry::PinholeCameraModel();
+        rectifier_ = new Rectifier();
     }
-
-    pinhole_model_->fromCameraInfo(camera_info_manager_->getCameraInfo());
-    if ( !cv_bridge_img_rect_ )
+    std::string cache_dir;
+    if ( pylon_camera_parameter_set_.use_rectification_cache_ )
     {
-        cv_bridge_img_rect_ = new cv_bridge::CvImage();
+        cache_dir = pylon_camera_parameter_set_.rectification_cache_dir_;
+        if ( cache_dir.empty() )
+        {
+            cache_dir = cache_files::defaultCacheDir();
+        }
     }
-    cv_bridge_img_rect_->header = img_raw_msg_.header;
-    cv_bridge_img_rect_->encoding = img_raw_msg_.encoding;
+    rectifier_->setCacheDirectory(cache_dir);
+    rectifier_->invalidate();
 }
 
 
@@ -422,71 +913,378 @@ void PylonCameraNode::spin()
         ROS_INFO_ONCE("Camera not calibrated");
     }
 
-    if ( pylon_camera_->isCamRemoved() )
+    if ( resetIfCameraRemoved() )
     {
-        ROS_ERROR("Pylon camera has been removed, trying to reset");
-        delete pylon_camera_;
-        pylon_camera_ = nullptr;
-        for ( ros::ServiceServer& user_output_srv : set_user_output_srvs_ )
+        // the camera is recovered in the background
+        ros::WallDuration(0.1).sleep();
+        return;
+    }
+
+    // the acquisition thread only grabs if subscribers are available. The
+    // recovery thread replaces the ring, but closing it wakes up pop()
+    sensor_msgs::ImagePtr img;
+    {
+        boost::lock_guard<boost::mutex> lock(publish_mutex_);
+        if ( !frame_ring_ || !frame_ring_->pop(img, ros::Duration(0.1).toBoost()) )
         {
-            user_output_srv.shutdown();
+            return;
         }
-        set_user_output_srvs_.clear();
-        ros::Duration(0.5).sleep();  // sleep for half a second
-        init();
-        return;
     }
-    // images were published if subscribers are available or if someone calls
-    // the GrabImages Action
-    if ( !isSleeping() && (img_raw_pub_.getNumSubscribers() || getNumSubscribersRect() ) )
+    publishFrame(img);
+}
+
+bool PylonCameraNode::resetIfCameraRemoved()
+{
+    if ( is_recovering_ )
+    {
+        return true;
+    }
+    if ( !pylon_camera_ || !pylon_camera_->isCamRemoved() )
+    {
+        return false;
+    }
+    onCameraRemoved();
+    return true;
+}
+
+void PylonCameraNode::onCameraRemoved()
+{
+    // acquisition and reconnection are handled by the recovery thread,
+    // because the camera must not be accessed from pylon's thread
+    boost::lock_guard<boost::mutex> lock(recovery_mutex_);
+    camera_removed_ = true;
+    is_recovering_ = true;
+    recovery_cond_.notify_all();
+}
+
+void PylonCameraNode::recoveryLoop()
+{
+    int retry_delay_ms = MIN_RECOVERY_RETRY_DELAY_MS;
+    while ( true )
     {
-        if ( getNumSubscribersRaw() || getNumSubscribersRect())
         {
-            if (!grabImage() )
+            boost::unique_lock<boost::mutex> lock(recovery_mutex_);
+            while ( !camera_removed_ && !stop_recovery_ )
+            {
+                recovery_cond_.wait(lock);
+            }
+            if ( stop_recovery_ )
             {
                 return;
             }
+            camera_removed_ = false;
         }
-    
-        if ( img_raw_pub_.getNumSubscribers() > 0 )
+        if ( recoverCamera() )
         {
-            // get actual cam_info-object in every frame, because it might have
-            // changed due to a 'set_camera_info'-service call
-            sensor_msgs::CameraInfoPtr cam_info(
-                        new sensor_msgs::CameraInfo(
-                                        camera_info_manager_->getCameraInfo()));
-            cam_info->header.stamp = img_raw_msg_.header.stamp;
+            is_recovering_ = false;
+            retry_delay_ms = MIN_RECOVERY_RETRY_DELAY_MS;
+            continue;
+        }
+        if ( isStopRequested() )
+        {
+            return;
+        }
+        // retry after a pause unless the node is shutting down, every attempt
+        // destroys and attaches the device again
+        boost::unique_lock<boost::mutex> lock(recovery_mutex_);
+        const boost::system_time retry_time = boost::get_system_time() +
+                            boost::posix_time::milliseconds(retry_delay_ms);
+        while ( !stop_recovery_ && recovery_cond_.timed_wait(lock, retry_time) )
+        {}
+        if ( stop_recovery_ )
+        {
+            return;
+        }
+        camera_removed_ = true;
+        retry_delay_ms = std::min(2 * retry_delay_ms, MAX_RECOVERY_RETRY_DELAY_MS);
+    }
+}
+
+bool PylonCameraNode::recoverCamera()
+{
+    const ros::WallTime removal_time = ros::WallTime::now();
+    ROS_WARN("Pylon camera has been removed, waiting for it to reappear");
+    stopAcquisition();
+    {
+        boost::lock_guard<boost::recursive_mutex> lock(grab_mutex_);
+        // hands the last grab buffer back to the pool
+        img_raw_ptr_.reset();
+        has_last_frame_counter_ = false;
+    }
+
+    // the enumeration of a single transport layer takes most of the time,
+    // hence the device is polled without a long pause
+    ros::WallRate r(20.0);
+    while ( true )
+    {
+        {
+            boost::lock_guard<boost::mutex> lock(recovery_mutex_);
+            if ( stop_recovery_ || isStopRequested() )
+            {
+                return false;
+            }
+        }
+        {
+            boost::lock_guard<boost::recursive_mutex> lock(grab_mutex_);
+            if ( pylon_camera_->reconnect() )
+            {
+                break;
+            }
+        }
+        ROS_WARN_STREAM_THROTTLE(15.0, "Camera with serial number "
+                << pylon_camera_->serialNumber() << " not present. Keep waiting ...");
+        r.sleep();
+    }
+
+    const ros::WallTime found_time = ros::WallTime::now();
+    {
+        // the parameter set has been updated with the settings changed at
+        // runtime, hence startGrabbing() applies the last known ones
+        boost::lock_guard<boost::recursive_mutex> lock(grab_mutex_);
+        if ( !pylon_camera_->openCamera() ||
+             !applyStartupSettings() ||
+             !startGrabbing() )
+        {
+            ROS_ERROR("Error while reopening the recovered camera, will retry");
+            return false;
+        }
+    }
+    startAcquisition();
+    ROS_INFO_STREAM("Recovered the camera " << (found_time - removal_time).toSec()
+            << " s after its removal, reopening took "
+            << (ros::WallTime::now() - found_time).toSec() << " s");
+    return true;
+}
+
+void PylonCameraNode::setFrameReadyCallback(const boost::function<void ()>& callback)
+{
+    boost::lock_guard<boost::mutex> lock(frame_ready_mutex_);
+    frame_ready_cb_ = callback;
+}
+
+void PylonCameraNode::publishPendingFrames()
+{
+    boost::lock_guard<boost::mutex> lock(publish_mutex_);
+    if ( !frame_ring_ )
+    {
+        return;
+    }
+    sensor_msgs::ImagePtr img;
+    while ( frame_ring_->tryPop(img) )
+    {
+        publishFrame(img);
+    }
+}
+
+void PylonCameraNode::publishFrame(const sensor_msgs::ImagePtr& img)
+{
+    if ( !first_frame_published_ )
+    {
+        first_frame_published_ = true;
+        ROS_INFO_STREAM("Cold start to first frame took "
+                << 1e3 * (ros::WallTime::now() - startup_time_).toSec()
+                << " ms (feature snapshot "
+                << (snapshot_restored_ ? "restored" : "not restored") << ")");
+    }
+
+    // the cam_info might have changed due to a 'set_camera_info'-service call
+    refreshCameraInfoCache(false);
+
+    if ( img_raw_pub_.getNumSubscribers() > 0 )
+    {
+        // a recycled message, which holds the cached cam_info
+        sensor_msgs::CameraInfoPtr cam_info = camera_info_cache_.stamped(
+                                                        img->header.stamp);
 
-            // Publish via image_transport
-            img_raw_pub_.publish(img_raw_msg_, *cam_info);
+        // Publish via image_transport. The message is passed as shared
+        // pointer, hence it is not copied for intraprocess subscribers
+        {
+            ScopedLatency latency(&statistics_, LS_PUBLISH);
+            img_raw_pub_.publish(img, cam_info);
         }
+        if ( statistics_.isEnabled() )
+        {
+            const ros::Duration stamp_to_publish = ros::Time::now() - img->header.stamp;
+            if ( stamp_to_publish > ros::Duration(0.0) )
+            {
+                statistics_.record(LS_STAMP_TO_PUBLISH,
+                                   static_cast<uint64_t>(stamp_to_publish.toNSec()));
+            }
+        }
+    }
+
+    if ( rectifier_ && getNumSubscribersRect() > 0 && camera_info_cache_.isCalibrated() )
+    {
+        ScopedLatency latency(&statistics_, LS_RECTIFY);
+        // publishing a fresh message per frame as shared pointer prevents the
+        // serialization for intraprocess subscribers
+        sensor_msgs::ImagePtr img_rect(new sensor_msgs::Image());
+        if ( rectifier_->rectify(camera_info_cache_.info(), *img, *img_rect) )
+        {
+            img_rect_pub_->publish(img_rect);
+        }
+    }
 
-        if ( getNumSubscribersRect() > 0 && camera_info_manager_->isCalibrated() )
+    if ( getNumSubscribersConverted() > 0 &&
+         ( sensor_msgs::image_encodings::isBayer(img->encoding) ||
+           img->encoding == sensor_msgs::image_encodings::YUV422 ) )
+    {
+        ScopedLatency latency(&statistics_, LS_CONVERT);
+        publishConverted(img);
+    }
+    statistics_.count(FC_PUBLISHED);
+}
+
+void PylonCameraNode::publishConverted(const sensor_msgs::ImagePtr& img)
+{
+    // the camera keeps sending the Bayer or YUV image, which is a third or
+    // two thirds of the bytes of a color image
+    const bool is_yuv = img->encoding == sensor_msgs::image_encodings::YUV422;
+    sensor_msgs::ImagePtr color;
+    if ( img_color_pub_.getNumSubscribers() > 0 )
+    {
+        color.reset(new sensor_msgs::Image());
+        if ( is_yuv )
+        {
+            uyvy_conversions::toColor(*img,
+                                      pylon_camera_parameter_set_.color_encoding_,
+                                      *color);
+        }
+        else
         {
-            cv_bridge_img_rect_->header.stamp = img_raw_msg_.header.stamp;
-            assert(pinhole_model_->initialized());
-            cv_bridge::CvImagePtr cv_img_raw = cv_bridge::toCvCopy(
-                    img_raw_msg_,
-                    img_raw_msg_.encoding);
-            pinhole_model_->fromCameraInfo(camera_info_manager_->getCameraInfo());
-            pinhole_model_->rectifyImage(cv_img_raw->image, cv_bridge_img_rect_->image);
-            img_rect_pub_->publish(*cv_bridge_img_rect_);
+            demosaicing::toColor(*img,
+                                 pylon_camera_parameter_set_.demosaicing_algorithm_,
+                                 pylon_camera_parameter_set_.color_encoding_,
+                                 *color);
         }
+        img_color_pub_.publish(color);
+    }
+    if ( img_mono_pub_.getNumSubscribers() > 0 )
+    {
+        sensor_msgs::ImagePtr mono(new sensor_msgs::Image());
+        if ( is_yuv )
+        {
+            // the luma plane is the mono image
+            uyvy_conversions::toMono(*img, *mono);
+        }
+        else
+        {
+            // converting the color image is cheaper than demosaicing once more
+            demosaicing::toMono(color ? *color : *img, *mono);
+        }
+        img_mono_pub_.publish(mono);
     }
 }
 
 bool PylonCameraNode::grabImage()
 {
     boost::lock_guard<boost::recursive_mutex> lock(grab_mutex_);
-    if ( !pylon_camera_->grab(img_raw_msg_.data) )
+    sensor_msgs::ImagePtr img;
+    FrameMetadata metadata;
+    if ( !pylon_camera_->grab(img, metadata) )
     {
+        statistics_.count(FC_GRAB_ERRORS);
         ROS_WARN("Pylon camera returned invalid image! Skipping");
         return false;
     }
-    img_raw_msg_.header.stamp = ros::Time::now();
+    statistics_.count(FC_GRABBED);
+    if ( !isPayloadValid(metadata) )
+    {
+        return false;
+    }
+    setupImageMsg(img, metadata);
+    publishFrameInfo(img->header, metadata);
     return true;
 }
 
+void PylonCameraNode::setupImageMsg(const sensor_msgs::ImagePtr& img,
+                                    const FrameMetadata& metadata)
+{
+    img_raw_msg_.header.stamp = frameStamp(metadata);
+
+    // the grabbed message only contains the data, the meta data is taken
+    // from img_raw_msg_
+    img->header = img_raw_msg_.header;
+    img->encoding = img_raw_msg_.encoding;
+    img->height = img_raw_msg_.height;
+    img->width = img_raw_msg_.width;
+    img->step = img_raw_msg_.step;
+    img->is_bigendian = img_raw_msg_.is_bigendian;
+
+    // releasing the previous image hands its buffer back to the grabber
+    // unless a subscriber still holds it
+    img_raw_ptr_ = img;
+}
+
+ros::Time PylonCameraNode::frameStamp(const FrameMetadata& metadata)
+{
+    if ( pylon_camera_parameter_set_.timestamp_mode_ == TM_HOST ||
+         !metadata.has_camera_stamp_ )
+    {
+        return metadata.host_stamp_;
+    }
+    if ( pylon_camera_parameter_set_.timestamp_mode_ == TM_EXPOSURE_MID )
+    {
+        // exposure is given in microseconds, the chunk data saves reading
+        // it from the device
+        const float exposure = metadata.has_exposure_time_ ?
+                               metadata.exposure_time_ :
+                               pylon_camera_->currentExposure();
+        return metadata.camera_stamp_ + ros::Duration(0.5e-6 * exposure);
+    }
+    return metadata.camera_stamp_;
+}
+
+bool PylonCameraNode::isPayloadValid(const FrameMetadata& metadata)
+{
+    if ( !metadata.has_crc_ || metadata.crc_ok_ )
+    {
+        return true;
+    }
+    statistics_.count(FC_CRC_ERRORS);
+    ROS_WARN_STREAM_THROTTLE(5.0, "Dropping a frame with a wrong payload CRC");
+    return false;
+}
+
+void PylonCameraNode::publishFrameInfo(const std_msgs::Header& header,
+                                       const FrameMetadata& metadata)
+{
+    uint32_t frames_missed = 0;
+    if ( metadata.has_frame_counter_ )
+    {
+        // frames skipped by the grab engine on purpose are not lost, and
+        // a smaller counter means the camera has restarted counting
+        if ( has_last_frame_counter_ &&
+             pylon_camera_parameter_set_.acquisition_mode_ != AM_FREE_RUN_LATEST_IMAGE_ONLY &&
+             metadata.frame_counter_ > last_frame_counter_ + 1 )
+        {
+            frames_missed = static_cast<uint32_t>(
+                            metadata.frame_counter_ - last_frame_counter_ - 1);
+            statistics_.count(FC_MISSED, frames_missed);
+            ROS_WARN_STREAM_THROTTLE(5.0, "The camera lost " << frames_missed
+                    << " frame(s) before frame " << metadata.frame_counter_);
+        }
+        has_last_frame_counter_ = true;
+        last_frame_counter_ = metadata.frame_counter_;
+    }
+
+    if ( frame_info_pub_.getNumSubscribers() == 0 )
+    {
+        return;
+    }
+    pylon_camera::FrameInfoPtr info(new pylon_camera::FrameInfo());
+    info->header = header;
+    info->exposure_time = metadata.has_exposure_time_ ? metadata.exposure_time_ : -1.0;
+    info->gain = metadata.has_gain_ ? metadata.gain_ : -1.0;
+    info->has_frame_counter = metadata.has_frame_counter_;
+    info->frame_counter = metadata.frame_counter_;
+    info->frames_missed = frames_missed;
+    info->camera_ticks = metadata.camera_ticks_;
+    info->crc_checked = metadata.has_crc_;
+    info->crc_ok = metadata.crc_ok_;
+    frame_info_pub_.publish(info);
+}
+
 void PylonCameraNode::grabImagesRawActionExecuteCB(
                     const camera_control_msgs::GrabImagesGoal::ConstPtr& goal)
 {
@@ -514,17 +1312,18 @@ void PylonCameraNode::grabImagesRectActionExecuteCB(
             return;
         }
 
+        refreshCameraInfoCache(true);
+        const sensor_msgs::CameraInfoConstPtr cam_info = camera_info_cache_.info();
         for ( std::size_t i = 0; i < result.images.size(); ++i)
         {
-            cv_bridge::CvImagePtr cv_img_raw = cv_bridge::toCvCopy(
-                                                        result.images[i],
-                                                        result.images[i].encoding);
-            pinhole_model_->fromCameraInfo(camera_info_manager_->getCameraInfo());
-            cv_bridge::CvImage cv_bridge_img_rect;
-            cv_bridge_img_rect.header = result.images[i].header;
-            cv_bridge_img_rect.encoding = result.images[i].encoding;
-            pinhole_model_->rectifyImage(cv_img_raw->image, cv_bridge_img_rect.image);
-            cv_bridge_img_rect.toImageMsg(result.images[i]);
+            sensor_msgs::Image img_rect;
+            if ( !rectifier_->rectify(cam_info, result.images[i], img_rect) )
+            {
+                result.success = false;
+                break;
+            }
+            result.images[i].data.swap(img_rect.data);
+            result.images[i].step = img_rect.step;
         }
         grab_imgs_rect_as_->setSucceeded(result);
     }
@@ -660,6 +1459,10 @@ camera_control_msgs::GrabImagesResult PylonCameraNode::grabImagesRaw(
         previous_exp = pylon_camera_->currentExposure();
     }
 
+    // changing exposure, gain, gamma or brightness doesn't affect the image
+    // format, hence the snapshot of the camera state stays valid
+    const CameraStateSnapshotConstPtr state = pylon_camera_->state();
+
     for ( std::size_t i = 0; i < n_images; ++i )
     {
         if ( goal->exposure_given )
@@ -683,11 +1486,11 @@ camera_control_msgs::GrabImagesResult PylonCameraNode::grabImagesRaw(
             result.success = setBrightness(goal->brightness_values[i],
                                            reached_brightness,
                                            goal->exposure_auto,
-                                           goal->gain_auto);
+                                           goal->gain_auto,
+                                           pylon_camera_parameter_set_.metering_mode_,
+                                           pylon_camera_parameter_set_.metering_roi_);
             result.reached_brightness_values[i] = static_cast<float>(
                                                             reached_brightness);
-            result.reached_exposure_times[i] = pylon_camera_->currentExposure();
-            result.reached_gain_values[i] = pylon_camera_->currentGain();
         }
         if ( !result.success )
         {
@@ -697,20 +1500,32 @@ camera_control_msgs::GrabImagesResult PylonCameraNode::grabImagesRaw(
         }
 
         sensor_msgs::Image& img = result.images[i];
-        img.encoding = pylon_camera_->currentROSEncoding();
-        img.height = pylon_camera_->imageRows();
-        img.width = pylon_camera_->imageCols();
-        // step = full row length in bytes, img_size = (step * rows), imagePixelDepth
+        img.encoding = state->ros_encoding_;
+        img.height = state->rows_;
+        img.width = state->cols_;
+        // step = full row length in bytes, img_size = (step * rows), pixel_depth_
         // already contains the number of channels
-        img.step = img.width * pylon_camera_->imagePixelDepth();
+        img.step = img.width * state->pixel_depth_;
 
-        if ( !pylon_camera_->grab(img.data) )
+        FrameMetadata metadata;
+        if ( !pylon_camera_->grab(img.data, metadata) || !isPayloadValid(metadata) )
         {
             result.success = false;
             break;
         }
 
-        img.header.stamp = ros::Time::now();
+        if ( goal->brightness_given )
+        {
+            // the chunk data holds the exact settings of this frame
+            result.reached_exposure_times[i] = metadata.has_exposure_time_ ?
+                                               metadata.exposure_time_ :
+                                               pylon_camera_->currentExposure();
+            result.reached_gain_values[i] = metadata.has_gain_ ?
+                                            metadata.gain_ :
+                                            pylon_camera_->currentGain();
+        }
+
+        img.header.stamp = frameStamp(metadata);
         img.header.frame_id = cameraFrame();
         feedback.curr_nr_images_taken = i+1;
 
@@ -772,9 +1587,15 @@ uint32_t PylonCameraNode::getNumSubscribersRect() const
     return camera_info_manager_->isCalibrated() ? img_rect_pub_->getNumSubscribers() : 0;
 }
 
+uint32_t PylonCameraNode::getNumSubscribersConverted() const
+{
+    return img_color_pub_.getNumSubscribers() + img_mono_pub_.getNumSubscribers();
+}
+
 uint32_t PylonCameraNode::getNumSubscribers() const
 {
-    return img_raw_pub_.getNumSubscribers() + img_rect_pub_->getNumSubscribers();
+    return img_raw_pub_.getNumSubscribers() + img_rect_pub_->getNumSubscribers() +
+           getNumSubscribersConverted();
 }
 
 void PylonCameraNode::setupInitialCameraInfo(sensor_msgs::CameraInfo& cam_info_msg)
@@ -791,9 +1612,22 @@ void PylonCameraNode::setupInitialCameraInfo(sensor_msgs::CameraInfo& cam_info_m
 
     // The image dimensions with which the camera was calibrated. Normally
     // this will be the full camera resolution in pixels. They remain fix, even
-    // if binning is applied
-    cam_info_msg.height = pylon_camera_->imageRows();
-    cam_info_msg.width = pylon_camera_->imageCols();
+    // if binning, decimation or a region of interest is applied
+    const size_t downsampling_x = std::max<size_t>(1, pylon_camera_->currentBinningX()) *
+                                  std::max<size_t>(1, pylon_camera_->currentDecimationX());
+    const size_t downsampling_y = std::max<size_t>(1, pylon_camera_->currentBinningY()) *
+                                  std::max<size_t>(1, pylon_camera_->currentDecimationY());
+    CameraConfiguration roi;
+    if ( pylon_camera_->currentROI(roi) )
+    {
+        cam_info_msg.height = roi.roi_height_max_ * downsampling_y;
+        cam_info_msg.width = roi.roi_width_max_ * downsampling_x;
+    }
+    else
+    {
+        cam_info_msg.height = pylon_camera_->imageRows();
+        cam_info_msg.width = pylon_camera_->imageCols();
+    }
 
     // The distortion model used. Supported models are listed in
     // sensor_msgs/distortion_models.h. For most cameras, "plumb_bob" - a
@@ -851,17 +1685,17 @@ void PylonCameraNode::setupInitialCameraInfo(sensor_msgs::CameraInfo& cam_info_m
     // neighborhoods of pixels into larger "super-pixels." It reduces the
     // resolution of the output image to (width / binning_x) x (height / binning_y).
     // The default values binning_x = binning_y = 0 is considered the same as
-    // binning_x = binning_y = 1 (no subsampling).
-    cam_info_msg.binning_x = pylon_camera_->currentBinningX();
-    cam_info_msg.binning_y = pylon_camera_->currentBinningY();
+    // binning_x = binning_y = 1 (no subsampling). Decimation subsamples as
+    // well, hence the factors are the product of binning and decimation.
+    cam_info_msg.binning_x = downsampling_x;
+    cam_info_msg.binning_y = downsampling_y;
 
     // Region of interest (subwindow of full camera resolution), given in full
     // resolution (unbinned) image coordinates. A particular ROI always denotes
     // the same window of pixels on the camera sensor, regardless of binning
     // settings. The default setting of roi (all values 0) is considered the same
     // as full resolution (roi.width = width, roi.height = height).
-    cam_info_msg.roi.x_offset = cam_info_msg.roi.y_offset = 0;
-    cam_info_msg.roi.height = cam_info_msg.roi.width = 0;
+    setCameraInfoROI(cam_info_msg);
 }
 
 /**
@@ -898,107 +1732,249 @@ bool PylonCameraNode::waitForCamera(const ros::Duration& timeout) const
     return result;
 }
 
-bool PylonCameraNode::setBinningX(const size_t& target_binning_x,
-                                  size_t& reached_binning_x)
+bool PylonCameraNode::reconfigure(const CameraConfiguration& target,
+                                  CameraConfiguration& reached)
 {
     boost::lock_guard<boost::recursive_mutex> lock(grab_mutex_);
-    if ( !pylon_camera_->setBinningX(target_binning_x, reached_binning_x) )
+    if ( !pylon_camera_->isReady() )
     {
-        // retry till timeout
+        ROS_WARN("Error in reconfigure(): pylon_camera_ is not ready!");
+        return false;
+    }
+
+    bool retry = false;
+    bool success = pylon_camera_->reconfigure(target, reached, retry);
+    if ( !success && retry )
+    {
+        // retry temporary errors till timeout
         ros::Rate r(10.0);
         ros::Time timeout(ros::Time::now() + ros::Duration(2.0));
-        while ( ros::ok() )
+        while ( ros::ok() && retry && ros::Time::now() <= timeout )
         {
-            if ( pylon_camera_->setBinningX(target_binning_x, reached_binning_x) )
+            r.sleep();
+            if ( pylon_camera_->reconfigure(target, reached, retry) )
             {
+                success = true;
                 break;
             }
-            if ( ros::Time::now() > timeout )
-            {
-                ROS_ERROR_STREAM("Error in setBinningX(): Unable to set target "
-                << "binning_x factor before timeout");
-                CameraInfoPtr cam_info(new CameraInfo(camera_info_manager_->getCameraInfo()));
-                cam_info->binning_x = pylon_camera_->currentBinningX();
-                camera_info_manager_->setCameraInfo(*cam_info);
-                img_raw_msg_.width = pylon_camera_->imageCols();
-                // step = full row length in bytes, img_size = (step * rows), imagePixelDepth
-                // already contains the number of channels
-                img_raw_msg_.step = img_raw_msg_.width * pylon_camera_->imagePixelDepth();
-                return false;
-            }
-            r.sleep();
+        }
+        if ( !success )
+        {
+            ROS_ERROR_STREAM("Error in reconfigure(): Unable to apply the "
+                << "configuration before timeout");
         }
     }
+    // the image geometry is updated once for the whole transaction
+    updateImageGeometry();
+    return success;
+}
+
+void PylonCameraNode::updateImageGeometry()
+{
     CameraInfoPtr cam_info(new CameraInfo(camera_info_manager_->getCameraInfo()));
-    cam_info->binning_x = pylon_camera_->currentBinningX();
+    // decimation subsamples as well as binning
+    cam_info->binning_x = std::max<size_t>(1, pylon_camera_->currentBinningX()) *
+                          std::max<size_t>(1, pylon_camera_->currentDecimationX());
+    cam_info->binning_y = std::max<size_t>(1, pylon_camera_->currentBinningY()) *
+                          std::max<size_t>(1, pylon_camera_->currentDecimationY());
+    setCameraInfoROI(*cam_info);
     camera_info_manager_->setCameraInfo(*cam_info);
+    refreshCameraInfoCache(true);
+
+    img_raw_msg_.encoding = pylon_camera_->currentROSEncoding();
+    img_raw_msg_.height = pylon_camera_->imageRows();
     img_raw_msg_.width = pylon_camera_->imageCols();
     // step = full row length in bytes, img_size = (step * rows), imagePixelDepth
     // already contains the number of channels
     img_raw_msg_.step = img_raw_msg_.width * pylon_camera_->imagePixelDepth();
-    setupSamplingIndices(sampling_indices_,
-                         pylon_camera_->imageRows(),
-                         pylon_camera_->imageCols(),
-                         pylon_camera_parameter_set_.downsampling_factor_exp_search_);
-    return true;
+    if ( rectifier_ )
+    {
+        // the binning or the ROI may have changed
+        rectifier_->invalidate();
+    }
 }
 
-bool PylonCameraNode::setBinningY(const size_t& target_binning_y,
-                                  size_t& reached_binning_y)
+void PylonCameraNode::refreshCameraInfoCache(const bool& force)
 {
-    boost::lock_guard<boost::recursive_mutex> lock(grab_mutex_);
-    if ( !pylon_camera_->setBinningY(target_binning_y, reached_binning_y) )
+    if ( !force )
     {
-        // retry till timeout
-        ros::Rate r(10.0);
-        ros::Time timeout(ros::Time::now() + ros::Duration(2.0));
-        while ( ros::ok() )
+        const ros::WallTime now = ros::WallTime::now();
+        if ( now < next_camera_info_refresh_ )
         {
-            if ( pylon_camera_->setBinningY(target_binning_y, reached_binning_y) )
-            {
-                break;
-            }
-            if ( ros::Time::now() > timeout )
-            {
-                ROS_ERROR_STREAM("Error in setBinningY(): Unable to set target "
-                    << "binning_y factor before timeout");
-                CameraInfoPtr cam_info(new CameraInfo(camera_info_manager_->getCameraInfo()));
-                cam_info->binning_y = pylon_camera_->currentBinningY();
-                camera_info_manager_->setCameraInfo(*cam_info);
-                img_raw_msg_.height = pylon_camera_->imageRows();
-                // step = full row length in bytes, img_size = (step * rows), imagePixelDepth
-                // already contains the number of channels
-                img_raw_msg_.step = img_raw_msg_.width * pylon_camera_->imagePixelDepth();
-                return false;
-            }
-            r.sleep();
+            return;
         }
+        next_camera_info_refresh_ = now + ros::WallDuration(0.5);
+    }
+    if ( camera_info_cache_.update(camera_info_manager_->getCameraInfo()) )
+    {
+        ROS_DEBUG_STREAM("CameraInfo changed, version "
+                << camera_info_cache_.version());
+    }
+}
+
+void PylonCameraNode::setCameraInfoROI(sensor_msgs::CameraInfo& cam_info_msg)
+{
+    CameraConfiguration roi;
+    if ( !pylon_camera_->currentROI(roi) )
+    {
+        return;
+    }
+    if ( roi.roi_offset_x_ == 0 && roi.roi_offset_y_ == 0 &&
+         roi.roi_width_ == roi.roi_width_max_ &&
+         roi.roi_height_ == roi.roi_height_max_ )
+    {
+        // all values 0 denote the full resolution
+        cam_info_msg.roi.x_offset = cam_info_msg.roi.y_offset = 0;
+        cam_info_msg.roi.height = cam_info_msg.roi.width = 0;
+        return;
+    }
+    const size_t binning_x = std::max<size_t>(1, cam_info_msg.binning_x);
+    const size_t binning_y = std::max<size_t>(1, cam_info_msg.binning_y);
+    cam_info_msg.roi.x_offset = roi.roi_offset_x_ * binning_x;
+    cam_info_msg.roi.y_offset = roi.roi_offset_y_ * binning_y;
+    cam_info_msg.roi.width = roi.roi_width_ * binning_x;
+    cam_info_msg.roi.height = roi.roi_height_ * binning_y;
+}
+
+void PylonCameraNode::rememberConfiguration(const CameraConfiguration& target,
+                                            const CameraConfiguration& reached)
+{
+    // remembered for the recovery after a device removal
+    if ( target.has_binning_ )
+    {
+        pylon_camera_parameter_set_.binning_x_given_ = true;
+        pylon_camera_parameter_set_.binning_x_ = reached.binning_x_;
+        pylon_camera_parameter_set_.binning_y_given_ = true;
+        pylon_camera_parameter_set_.binning_y_ = reached.binning_y_;
+    }
+    if ( target.has_decimation_ )
+    {
+        pylon_camera_parameter_set_.decimation_x_given_ = true;
+        pylon_camera_parameter_set_.decimation_x_ = reached.decimation_x_;
+        pylon_camera_parameter_set_.decimation_y_given_ = true;
+        pylon_camera_parameter_set_.decimation_y_ = reached.decimation_y_;
+    }
+    if ( target.has_roi_ )
+    {
+        pylon_camera_parameter_set_.roi_given_ = true;
+        pylon_camera_parameter_set_.roi_offset_x_ = reached.roi_offset_x_;
+        pylon_camera_parameter_set_.roi_offset_y_ = reached.roi_offset_y_;
+        pylon_camera_parameter_set_.roi_width_ = reached.roi_width_;
+        pylon_camera_parameter_set_.roi_height_ = reached.roi_height_;
+    }
+    if ( target.has_image_encoding_ )
+    {
+        pylon_camera_parameter_set_.setImageEncoding(nh_, reached.image_encoding_);
+    }
+    if ( target.has_exposure_ )
+    {
+        pylon_camera_parameter_set_.exposure_given_ = true;
+        pylon_camera_parameter_set_.exposure_ = reached.exposure_;
+        pylon_camera_parameter_set_.brightness_given_ = false;
+    }
+    if ( target.has_gain_ )
+    {
+        pylon_camera_parameter_set_.gain_given_ = true;
+        pylon_camera_parameter_set_.gain_ = reached.gain_;
+        pylon_camera_parameter_set_.brightness_given_ = false;
     }
-    CameraInfoPtr cam_info(new CameraInfo(camera_info_manager_->getCameraInfo()));
-    cam_info->binning_y = pylon_camera_->currentBinningY();
-    camera_info_manager_->setCameraInfo(*cam_info);
-    img_raw_msg_.height = pylon_camera_->imageRows();
-    // step = full row length in bytes, img_size = (step * rows), imagePixelDepth
-    // already contains the number of channels
-    img_raw_msg_.step = img_raw_msg_.width * pylon_camera_->imagePixelDepth();
-    setupSamplingIndices(sampling_indices_,
-                         pylon_camera_->imageRows(),
-                         pylon_camera_->imageCols(),
-                         pylon_camera_parameter_set_.downsampling_factor_exp_search_);
-    return true;
 }
 
 bool PylonCameraNode::setBinningCallback(camera_control_msgs::SetBinning::Request &req,
                                          camera_control_msgs::SetBinning::Response &res)
 {
-    size_t reached_binning_x, reached_binning_y;
-    bool success_x = setBinningX(req.target_binning_x,
-                                 reached_binning_x);
-    bool success_y = setBinningY(req.target_binning_y,
-                                 reached_binning_y);
-    res.reached_binning_x = static_cast<uint32_t>(reached_binning_x);
-    res.reached_binning_y = static_cast<uint32_t>(reached_binning_y);
-    res.success = success_x && success_y;
+    // both factors are applied with a single restart of grabbing
+    CameraConfiguration target, reached;
+    target.has_binning_ = true;
+    target.binning_x_ = req.target_binning_x;
+    target.binning_y_ = req.target_binning_y;
+    res.success = reconfigure(target, reached);
+    res.reached_binning_x = static_cast<uint32_t>(reached.binning_x_);
+    res.reached_binning_y = static_cast<uint32_t>(reached.binning_y_);
+    if ( res.success )
+    {
+        rememberConfiguration(target, reached);
+    }
+    return true;
+}
+
+bool PylonCameraNode::setDecimationCallback(camera_control_msgs::SetBinning::Request &req,
+                                            camera_control_msgs::SetBinning::Response &res)
+{
+    // decimation has the same service type as binning
+    CameraConfiguration target, reached;
+    target.has_decimation_ = true;
+    target.decimation_x_ = req.target_binning_x;
+    target.decimation_y_ = req.target_binning_y;
+    res.success = reconfigure(target, reached);
+    res.reached_binning_x = static_cast<uint32_t>(reached.decimation_x_);
+    res.reached_binning_y = static_cast<uint32_t>(reached.decimation_y_);
+    if ( res.success )
+    {
+        rememberConfiguration(target, reached);
+    }
+    return true;
+}
+
+bool PylonCameraNode::setConfigurationCallback(pylon_camera::SetConfiguration::Request &req,
+                                               pylon_camera::SetConfiguration::Response &res)
+{
+    CameraConfiguration target, reached;
+    target.has_binning_ = req.set_binning;
+    target.binning_x_ = req.target_binning_x;
+    target.binning_y_ = req.target_binning_y;
+    target.has_decimation_ = req.set_decimation;
+    target.decimation_x_ = req.target_decimation_x;
+    target.decimation_y_ = req.target_decimation_y;
+    target.has_roi_ = req.set_roi;
+    target.roi_offset_x_ = req.target_roi_offset_x;
+    target.roi_offset_y_ = req.target_roi_offset_y;
+    target.roi_width_ = req.target_roi_width;
+    target.roi_height_ = req.target_roi_height;
+    target.has_image_encoding_ = req.set_image_encoding;
+    target.image_encoding_ = req.target_image_encoding;
+    target.has_exposure_ = req.set_exposure;
+    target.exposure_ = req.target_exposure;
+    target.has_gain_ = req.set_gain;
+    target.gain_ = req.target_gain;
+
+    res.success = reconfigure(target, reached);
+    res.reached_binning_x = static_cast<uint32_t>(reached.binning_x_);
+    res.reached_binning_y = static_cast<uint32_t>(reached.binning_y_);
+    res.reached_decimation_x = static_cast<uint32_t>(reached.decimation_x_);
+    res.reached_decimation_y = static_cast<uint32_t>(reached.decimation_y_);
+    res.reached_roi_offset_x = static_cast<uint32_t>(reached.roi_offset_x_);
+    res.reached_roi_offset_y = static_cast<uint32_t>(reached.roi_offset_y_);
+    res.reached_roi_width = static_cast<uint32_t>(reached.roi_width_);
+    res.reached_roi_height = static_cast<uint32_t>(reached.roi_height_);
+    res.reached_image_encoding = reached.image_encoding_;
+    res.reached_exposure = reached.exposure_;
+    res.reached_gain = reached.gain_;
+    if ( res.success )
+    {
+        rememberConfiguration(target, reached);
+    }
+    return true;
+}
+
+bool PylonCameraNode::setROICallback(pylon_camera::SetROI::Request &req,
+                                     pylon_camera::SetROI::Response &res)
+{
+    CameraConfiguration target, reached;
+    target.has_roi_ = true;
+    target.roi_offset_x_ = req.target_offset_x;
+    target.roi_offset_y_ = req.target_offset_y;
+    target.roi_width_ = req.target_width;
+    target.roi_height_ = req.target_height;
+    res.success = reconfigure(target, reached);
+    res.reached_offset_x = static_cast<uint32_t>(reached.roi_offset_x_);
+    res.reached_offset_y = static_cast<uint32_t>(reached.roi_offset_y_);
+    res.reached_width = static_cast<uint32_t>(reached.roi_width_);
+    res.reached_height = static_cast<uint32_t>(reached.roi_height_);
+    if ( res.success )
+    {
+        rememberConfiguration(target, reached);
+    }
     return true;
 }
 
@@ -1046,6 +2022,13 @@ bool PylonCameraNode::setExposureCallback(camera_control_msgs::SetExposure::Requ
                                           camera_control_msgs::SetExposure::Response &res)
 {
     res.success = setExposure(req.target_exposure, res.reached_exposure);
+    if ( res.success )
+    {
+        // remembered for the recovery after a device removal
+        pylon_camera_parameter_set_.exposure_given_ = true;
+        pylon_camera_parameter_set_.exposure_ = res.reached_exposure;
+        pylon_camera_parameter_set_.brightness_given_ = false;
+    }
     return true;
 }
 
@@ -1090,6 +2073,13 @@ bool PylonCameraNode::setGainCallback(camera_control_msgs::SetGain::Request &req
                                       camera_control_msgs::SetGain::Response &res)
 {
     res.success = setGain(req.target_gain, res.reached_gain);
+    if ( res.success )
+    {
+        // remembered for the recovery after a device removal
+        pylon_camera_parameter_set_.gain_given_ = true;
+        pylon_camera_parameter_set_.gain_ = res.reached_gain;
+        pylon_camera_parameter_set_.brightness_given_ = false;
+    }
     return true;
 }
 
@@ -1134,13 +2124,21 @@ bool PylonCameraNode::setGammaCallback(camera_control_msgs::SetGamma::Request &r
                                        camera_control_msgs::SetGamma::Response &res)
 {
     res.success = setGamma(req.target_gamma, res.reached_gamma);
+    if ( res.success )
+    {
+        // remembered for the recovery after a device removal
+        pylon_camera_parameter_set_.gamma_given_ = true;
+        pylon_camera_parameter_set_.gamma_ = res.reached_gamma;
+    }
     return true;
 }
 
 bool PylonCameraNode::setBrightness(const int& target_brightness,
                                     int& reached_brightness,
                                     const bool& exposure_auto,
-                                    const bool& gain_auto)
+                                    const bool& gain_auto,
+                                    const METERING_MODE& mode,
+                                    const sensor_msgs::RegionOfInterest& roi)
 {
     boost::lock_guard<boost::recursive_mutex> lock(grab_mutex_);
     ros::Time begin = ros::Time::now();  // time measurement for the exposure search
@@ -1156,6 +2154,22 @@ bool PylonCameraNode::setBrightness(const int& target_brightness,
     }
 
     int target_brightness_co = std::min(255, target_brightness);
+
+    // the region is only relevant for MM_ROI, hence it's ignored otherwise
+    const sensor_msgs::RegionOfInterest region = mode == MM_ROI ?
+                                                 roi : sensor_msgs::RegionOfInterest();
+    if ( mode != brightness_exp_lut_mode_ ||
+         region.x_offset != brightness_exp_lut_roi_.x_offset ||
+         region.y_offset != brightness_exp_lut_roi_.y_offset ||
+         region.width != brightness_exp_lut_roi_.width ||
+         region.height != brightness_exp_lut_roi_.height )
+    {
+        // the remembered exposures were reached with another metering
+        brightness_exp_lut_.fill(0.0);
+        brightness_exp_lut_mode_ = mode;
+        brightness_exp_lut_roi_ = region;
+    }
+
     // smart brightness search initially sets the last rememberd exposure time
     if ( brightness_exp_lut_.at(target_brightness_co) != 0.0 )
     {
@@ -1173,16 +2187,17 @@ bool PylonCameraNode::setBrightness(const int& target_brightness,
         }
     }
 
-    // get actual image -> fills img_raw_msg_.data vector
+    // get actual image -> fills img_raw_ptr_
     if ( !grabImage() )
     {
         ROS_ERROR("Failed to grab image, can't calculate current brightness!");
         return false;
     }
 
-    // calculates current brightness by generating the mean over all pixels
-    // stored in img_raw_msg_.data vector
-    float current_brightness = calcCurrentBrightness();
+    // calculates current brightness by generating the metered mean of the
+    // pixels stored in img_raw_ptr_
+    float image_brightness = 0.0;
+    float current_brightness = calcCurrentBrightness(mode, region, image_brightness);
 
     ROS_DEBUG_STREAM("New brightness request for target brightness "
             << target_brightness_co << ", current brightness = "
@@ -1258,9 +2273,18 @@ bool PylonCameraNode::setBrightness(const int& target_brightness,
         // calling setBrightness in every cycle would not be necessary for the pylon auto
         // brightness search. But for the case that the target brightness is out of the
         // pylon range which is from [50 - 205] a binary exposure search will be executed
-        // where we have to update the search parameter in every cycle
-        if ( !pylon_camera_->setBrightness(target_brightness_co,
-                                           current_brightness,
+        // where we have to update the search parameter in every cycle.
+        // The camera meters the whole image, hence it has to reach the image
+        // brightness that corresponds to the target of the metered pixels.
+        int camera_target = target_brightness_co;
+        if ( mode != MM_AVERAGE )
+        {
+            camera_target = static_cast<int>(std::round(target_brightness_co *
+                    image_brightness / std::max(1.0f, current_brightness)));
+            camera_target = std::max(1, std::min(255, camera_target));
+        }
+        if ( !pylon_camera_->setBrightness(camera_target,
+                                           image_brightness,
                                            exposure_auto,
                                            gain_auto) )
         {
@@ -1285,7 +2309,7 @@ bool PylonCameraNode::setBrightness(const int& target_brightness,
             continue;
         }
 
-        current_brightness = calcCurrentBrightness();
+        current_brightness = calcCurrentBrightness(mode, region, image_brightness);
         is_brightness_reached = fabs(current_brightness - static_cast<float>(target_brightness_co))
                                 < pylon_camera_->maxBrightnessTolerance();
 
@@ -1359,116 +2383,133 @@ bool PylonCameraNode::setBrightness(const int& target_brightness,
     return is_brightness_reached;
 }
 
-bool PylonCameraNode::setBrightnessCallback(camera_control_msgs::SetBrightness::Request &req,
-                                            camera_control_msgs::SetBrightness::Response &res)
+bool PylonCameraNode::reachBrightness(const int& target_brightness,
+                                      const bool& brightness_continuous,
+                                      const bool& exposure_auto,
+                                      const bool& gain_auto,
+                                      const METERING_MODE& mode,
+                                      const sensor_msgs::RegionOfInterest& roi,
+                                      int& reached_brightness)
 {
-    res.success = setBrightness(req.target_brightness,
-                                res.reached_brightness,
-                                req.exposure_auto,
-                                req.gain_auto);
-    if ( req.brightness_continuous )
-    {
-        if ( req.exposure_auto )
+    const bool success = setBrightness(target_brightness,
+                                       reached_brightness,
+                                       exposure_auto,
+                                       gain_auto,
+                                       mode,
+                                       roi);
+    if ( brightness_continuous )
+    {
+        if ( exposure_auto )
         {
             pylon_camera_->enableContinuousAutoExposure();
         }
-        if ( req.gain_auto )
+        if ( gain_auto )
         {
             pylon_camera_->enableContinuousAutoGain();
         }
     }
+    if ( success )
+    {
+        // remembered for the recovery after a device removal
+        pylon_camera_parameter_set_.brightness_given_ = true;
+        pylon_camera_parameter_set_.brightness_ = target_brightness;
+        pylon_camera_parameter_set_.exposure_auto_ = exposure_auto;
+        pylon_camera_parameter_set_.gain_auto_ = gain_auto;
+        pylon_camera_parameter_set_.brightness_continuous_ = brightness_continuous;
+        pylon_camera_parameter_set_.metering_mode_ = mode;
+        pylon_camera_parameter_set_.metering_roi_ = roi;
+        pylon_camera_parameter_set_.exposure_given_ = false;
+        pylon_camera_parameter_set_.gain_given_ = false;
+    }
+    return success;
+}
+
+bool PylonCameraNode::setBrightnessCallback(camera_control_msgs::SetBrightness::Request &req,
+                                            camera_control_msgs::SetBrightness::Response &res)
+{
+    res.success = reachBrightness(req.target_brightness,
+                                  req.brightness_continuous,
+                                  req.exposure_auto,
+                                  req.gain_auto,
+                                  pylon_camera_parameter_set_.metering_mode_,
+                                  pylon_camera_parameter_set_.metering_roi_,
+                                  res.reached_brightness);
     res.reached_exposure_time = pylon_camera_->currentExposure();
     res.reached_gain_value = pylon_camera_->currentGain();
     return true;
 }
 
-void PylonCameraNode::setupSamplingIndices(std::vector<std::size_t>& indices,
-                                           std::size_t rows,
-                                           std::size_t cols,
-                                           int downsampling_factor)
-{
-    indices.clear();
-    std::size_t min_window_height = static_cast<float>(rows) /
-                                    static_cast<float>(downsampling_factor);
-    cv::Point2i start_pt(0, 0);
-    cv::Point2i end_pt(cols, rows);
-    // add the iamge center point only once
-    sampling_indices_.push_back(0.5 * rows * cols);
-    genSamplingIndicesRec(indices,
-                          min_window_height,
-                          start_pt,
-                          end_pt);
-    std::sort(indices.begin(), indices.end());
-    return;
-}
-
-void PylonCameraNode::genSamplingIndicesRec(std::vector<std::size_t>& indices,
-                                            const std::size_t& min_window_height,
-                                            const cv::Point2i& s,   // start
-                                            const cv::Point2i& e)   // end
-{
-    if ( static_cast<std::size_t>(std::abs(e.y - s.y)) <= min_window_height )
-    {
-        return;  // abort criteria -> shrinked window has the min_col_size
-    }
-    /*
-     * sampled img:      point:                             idx:
-     * s 0 0 0 0 0 0  a) [(e.x-s.x)*0.5, (e.y-s.y)*0.5]     a.x*a.y*0.5
-     * 0 0 0 d 0 0 0  b) [a.x,           1.5*a.y]           b.y*img_rows+b.x
-     * 0 0 0 0 0 0 0  c) [0.5*a.x,       a.y]               c.y*img_rows+c.x
-     * 0 c 0 a 0 f 0  d) [a.x,           0.5*a.y]           d.y*img_rows+d.x
-     * 0 0 0 0 0 0 0  f) [1.5*a.x,       a.y]               f.y*img_rows+f.x
-     * 0 0 0 b 0 0 0
-     * 0 0 0 0 0 0 e
-     */
-    cv::Point2i a, b, c, d, f, delta;
-    a = s + 0.5 * (e - s);  // center point
-    delta = 0.5 * (e - s);
-    b = s + cv::Point2i(delta.x,       1.5 * delta.y);
-    c = s + cv::Point2i(0.5 * delta.x, delta.y);
-    d = s + cv::Point2i(delta.x,       0.5 * delta.y);
-    f = s + cv::Point2i(1.5 * delta.x, delta.y);
-    indices.push_back(b.y * pylon_camera_->imageCols() + b.x);
-    indices.push_back(c.y * pylon_camera_->imageCols() + c.x);
-    indices.push_back(d.y * pylon_camera_->imageCols() + d.x);
-    indices.push_back(f.y * pylon_camera_->imageCols() + f.x);
-    genSamplingIndicesRec(indices, min_window_height, s, a);
-    genSamplingIndicesRec(indices, min_window_height, a, e);
-    genSamplingIndicesRec(indices, min_window_height, cv::Point2i(s.x, a.y), cv::Point2i(a.x, e.y));
-    genSamplingIndicesRec(indices, min_window_height, cv::Point2i(a.x, s.y), cv::Point2i(e.x, a.y));
-    return;
-}
-
-float PylonCameraNode::calcCurrentBrightness()
+bool PylonCameraNode::setMeteredBrightnessCallback(pylon_camera::SetMeteredBrightness::Request &req,
+                                                   pylon_camera::SetMeteredBrightness::Response &res)
 {
-    boost::lock_guard<boost::recursive_mutex> lock(grab_mutex_);
-    if ( img_raw_msg_.data.empty() )
+    METERING_MODE mode;
+    if ( !metering::meteringModeFromString(req.metering_mode, mode) )
     {
-        return 0.0;
+        ROS_ERROR_STREAM("Unknown metering mode: '" << req.metering_mode
+            << "'. Valid modes are 'average', 'center_weighted', 'spot', "
+            << "'roi' and 'matrix'");
+        res.success = false;
+        return true;
     }
-    float sum = 0.0;
-    if ( sensor_msgs::image_encodings::isMono(img_raw_msg_.encoding) )
-    {
-        // The mean brightness is calculated using a subset of all pixels
-        for ( const std::size_t& idx : sampling_indices_ )
+    res.success = reachBrightness(req.target_brightness,
+                                  req.brightness_continuous,
+                                  req.exposure_auto,
+                                  req.gain_auto,
+                                  mode,
+                                  req.roi,
+                                  res.reached_brightness);
+    res.reached_exposure_time = pylon_camera_->currentExposure();
+    res.reached_gain_value = pylon_camera_->currentGain();
+    return true;
+}
+
+float PylonCameraNode::calcCurrentBrightness(const METERING_MODE& mode,
+                                             const sensor_msgs::RegionOfInterest& roi,
+                                             float& image_brightness)
+{
+    image_brightness = 0.0;
+    sensor_msgs::ImageConstPtr img;
+    boost::shared_ptr<const metering::WeightMask> mask;
+    {
+        // the brightness search holds the grab mutex anyway, because it
+        // drives the camera itself. Only the image and the mask have to be
+        // taken under the lock, both are never modified once they are set
+        boost::lock_guard<boost::recursive_mutex> lock(grab_mutex_);
+        img = img_raw_ptr_;
+        if ( !img || img->data.empty() )
         {
-           sum += img_raw_msg_.data.at(idx);
+            return 0.0;
         }
-        if ( sum > 0.0 )
+        if ( !metering_mask_ ||
+             !metering_mask_->matches(mode, roi, img->width, img->height) )
         {
-            sum /= static_cast<float>(sampling_indices_.size());
+            metering_mask_.reset(new metering::WeightMask(mode, roi,
+                                                          img->width,
+                                                          img->height));
+            if ( !metering_mask_->isValid() )
+            {
+                ROS_WARN_STREAM("The metering region (" << roi.x_offset << ", "
+                    << roi.y_offset << ", " << roi.width << ", " << roi.height
+                    << ") is outside of the " << img->width << "x"
+                    << img->height << " image! Will meter the average instead");
+            }
         }
+        mask = metering_mask_;
     }
-    else
+    ScopedLatency latency(&statistics_, LS_BRIGHTNESS);
+    if ( img->data.size() != pylon_camera_->state()->size_byte_ )
     {
-        // The mean brightness is calculated using all pixels and all channels
-        sum = std::accumulate(img_raw_msg_.data.begin(), img_raw_msg_.data.end(), 0);
-        if ( sum > 0.0 )
-        {
-            sum /= static_cast<float>(img_raw_msg_.data.size());
-        }
+        // the image was grabbed before the last change of the image format
+        return 0.0;
     }
-    return sum;
+    const std::size_t& step = pylon_camera_parameter_set_.metering_grid_step_;
+    metering::MeteringResult result;
+    if ( !metering::meter(*img, step, step, *mask, result) )
+    {
+        return 0.0;
+    }
+    image_brightness = static_cast<float>(result.mean_);
+    return static_cast<float>(result.metered_mean_);
 }
 
 bool PylonCameraNode::setSleepingCallback(camera_control_msgs::SetSleeping::Request &req,
@@ -1489,6 +2530,100 @@ bool PylonCameraNode::setSleepingCallback(camera_control_msgs::SetSleeping::Requ
     return true;
 }
 
+bool PylonCameraNode::enableStatisticsCallback(camera_control_msgs::SetBool::Request &req,
+                                               camera_control_msgs::SetBool::Response &res)
+{
+    statistics_.setEnabled(req.data);
+    // keep the parameter in sync, init() reads it again after a reset
+    nh_.setParam("enable_statistics", static_cast<bool>(req.data));
+    ROS_INFO_STREAM((req.data ? "Enabled" : "Disabled")
+            << " the pipeline statistics");
+    res.success = true;
+    return true;
+}
+
+void PylonCameraNode::publishStatistics(const ros::WallTimerEvent& event)
+{
+    if ( !statistics_.isEnabled() )
+    {
+        return;
+    }
+
+    uint64_t num_dropped = 0;
+    {
+        boost::lock_guard<boost::mutex> lock(publish_mutex_);
+        if ( frame_ring_ )
+        {
+            const uint64_t total_dropped = frame_ring_->numDropped();
+            // the ring and its counter are recreated on every restart
+            num_dropped = total_dropped >= statistics_num_dropped_ ?
+                          total_dropped - statistics_num_dropped_ : total_dropped;
+            statistics_num_dropped_ = total_dropped;
+        }
+    }
+
+    diagnostic_msgs::DiagnosticStatus status;
+    status.name = nh_.getNamespace() + " pipeline";
+    status.hardware_id = pylon_camera_parameter_set_.deviceUserID();
+    status.level = diagnostic_msgs::DiagnosticStatus::OK;
+    status.message = "OK";
+
+    diagnostic_msgs::KeyValue kv;
+    for ( int i = 0; i < NUM_FRAME_COUNTERS; ++i )
+    {
+        const FRAME_COUNTER counter = static_cast<FRAME_COUNTER>(i);
+        const uint64_t value = statistics_.takeCount(counter);
+        if ( value > 0 && counter != FC_GRABBED && counter != FC_PUBLISHED )
+        {
+            status.level = diagnostic_msgs::DiagnosticStatus::WARN;
+            status.message = "Lost frames";
+        }
+        kv.key = PipelineStatistics::counterName(counter);
+        kv.value = std::to_string(value);
+        status.values.push_back(kv);
+    }
+    kv.key = "frames_dropped";
+    kv.value = std::to_string(num_dropped);
+    status.values.push_back(kv);
+    if ( num_dropped > 0 )
+    {
+        status.level = diagnostic_msgs::DiagnosticStatus::WARN;
+        status.message = "Lost frames";
+    }
+
+    // latencies are reported in milliseconds
+    for ( int i = 0; i < NUM_LATENCY_STAGES; ++i )
+    {
+        const LATENCY_STAGE stage = static_cast<LATENCY_STAGE>(i);
+        const LatencySummary summary = statistics_.takeSummary(stage);
+        const std::string name = PipelineStatistics::stageName(stage);
+        kv.key = name + " count";
+        kv.value = std::to_string(summary.count_);
+        status.values.push_back(kv);
+        if ( summary.count_ == 0 )
+        {
+            continue;
+        }
+        std::stringstream ss;
+        ss << std::fixed << std::setprecision(3)
+           << "mean " << 1e-3 * summary.mean_
+           << " p50 " << 1e-3 * summary.p50_
+           << " p95 " << 1e-3 * summary.p95_
+           << " p99 " << 1e-3 * summary.p99_
+           << " max " << 1e-3 * summary.max_;
+        kv.key = name + " latency [ms]";
+        kv.value = ss.str();
+        status.values.push_back(kv);
+    }
+
+    statistics_pub_.publish(status);
+
+    diagnostic_msgs::DiagnosticArray diagnostics;
+    diagnostics.header.stamp = ros::Time::now();
+    diagnostics.status.push_back(status);
+    diagnostics_pub_.publish(diagnostics);
+}
+
 bool PylonCameraNode::isSleeping()
 {
     return is_sleeping_;
@@ -1496,6 +2631,22 @@ bool PylonCameraNode::isSleeping()
 
 PylonCameraNode::~PylonCameraNode()
 {
+    {
+        boost::lock_guard<boost::mutex> lock(recovery_mutex_);
+        stop_recovery_ = true;
+        recovery_cond_.notify_all();
+    }
+    if ( recovery_thread_.joinable() )
+    {
+        recovery_thread_.join();
+    }
+    if ( pylon_camera_ )
+    {
+        pylon_camera_->setRemovalCallback(PylonCamera::RemovalCallback());
+    }
+    stopAcquisition();
+    // hand the last grab buffer back before the camera is destroyed
+    img_raw_ptr_.reset();
     if ( pylon_camera_ )
     {
         delete pylon_camera_;
@@ -1519,16 +2670,11 @@ PylonCameraNode::~PylonCameraNode()
         img_rect_pub_ = nullptr;
     }
 
-    if ( cv_bridge_img_rect_ )
-    {
-        delete cv_bridge_img_rect_;
-        cv_bridge_img_rect_ = nullptr;
-    }
 
-    if ( pinhole_model_ )
+    if ( rectifier_ )
     {
-        delete pinhole_model_;
-        pinhole_model_ = nullptr;
+        delete rectifier_;
+        rectifier_ = nullptr;
     }
 }
 
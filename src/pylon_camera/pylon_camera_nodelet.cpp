@@ -0,0 +1,107 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread.hpp>
+#include <atomic>
+#include <pylon_camera/pylon_camera_node.h>
+
+namespace pylon_camera
+{
+
+/**
+ * Nodelet variant of the PylonCameraNode. The images are published as
+ * shared pointers, hence nodelets in the same manager receive them without
+ * serialization or copying.
+ */
+class PylonCameraNodelet : public nodelet::Nodelet
+{
+public:
+    PylonCameraNodelet()
+        : nodelet::Nodelet(),
+          pylon_camera_node_(),
+          spin_thread_(),
+          is_running_(false)
+    {}
+
+    virtual ~PylonCameraNodelet()
+    {
+        is_running_ = false;
+        if ( spin_thread_.joinable() )
+        {
+            spin_thread_.join();
+        }
+    }
+
+private:
+    virtual void onInit()
+    {
+        // opening the camera might wait for the device to show up, which
+        // must not block the nodelet manager
+        is_running_ = true;
+        spin_thread_ = boost::thread(boost::bind(&PylonCameraNodelet::spin,
+                                                 this));
+    }
+
+    void spin()
+    {
+        // the node waits for the camera in its constructor, hence it has to
+        // know when the nodelet is unloaded
+        pylon_camera_node_.reset(
+                    new PylonCameraNode(getPrivateNodeHandle(), false, nullptr,
+                                        boost::bind(&PylonCameraNodelet::isUnloading,
+                                                    this)));
+
+        NODELET_INFO_STREAM("Start image grabbing if node connects to topic "
+                << "with a frame_rate of: " << pylon_camera_node_->frameRate()
+                << " Hz");
+
+        // spin() blocks till the next frame is available, but at most 0.1s
+        while ( ros::ok() && is_running_ && pylon_camera_node_->isInitialized() )
+        {
+            pylon_camera_node_->spin();
+        }
+        pylon_camera_node_.reset();
+    }
+
+    bool isUnloading() const
+    {
+        return !is_running_;
+    }
+
+    boost::scoped_ptr<PylonCameraNode> pylon_camera_node_;
+    boost::thread spin_thread_;
+    std::atomic<bool> is_running_;
+};
+
+}  // namespace pylon_camera
+
+PLUGINLIB_EXPORT_CLASS(pylon_camera::PylonCameraNodelet, nodelet::Nodelet)
@@ -28,7 +28,12 @@
  *****************************************************************************/
 
 #include <pylon_camera/pylon_camera_parameter.h>
+#include <pylon_camera/cache_files.h>
+#include <pylon_camera/metering.h>
 #include <sensor_msgs/image_encodings.h>
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
 
 namespace pylon_camera
 {
@@ -39,11 +44,26 @@ PylonCameraParameter::PylonCameraParameter() :
         frame_rate_(5.0),
         camera_info_url_(""),
         image_encoding_(""),
+        serial_number_(""),
+        ip_address_(""),
+        device_class_(""),
         binning_x_(1),
         binning_y_(1),
         binning_x_given_(false),
         binning_y_given_(false),
-        downsampling_factor_exp_search_(1),
+        decimation_x_(1),
+        decimation_y_(1),
+        decimation_x_given_(false),
+        decimation_y_given_(false),
+        downsampling_x_(1),
+        downsampling_y_(1),
+        downsampling_given_(false),
+        downsampling_preference_(DP_SNR),
+        roi_offset_x_(0),
+        roi_offset_y_(0),
+        roi_width_(0),
+        roi_height_(0),
+        roi_given_(false),
         // ##########################
         //  image intensity settings
         // ##########################
@@ -58,13 +78,34 @@ PylonCameraParameter::PylonCameraParameter() :
         brightness_continuous_(false),
         exposure_auto_(true),
         gain_auto_(true),
+        metering_grid_step_(4),
+        metering_mode_(MM_AVERAGE),
+        metering_roi_(),
         // #########################
         exposure_search_timeout_(5.),
         auto_exp_upper_lim_(0.0),
         mtu_size_(3000),
         inter_pkg_delay_(1000),
         shutter_mode_(SM_DEFAULT),
-        auto_flash_(false)
+        acquisition_mode_(AM_SOFTWARE_TRIGGER),
+        triggers_in_flight_(2),
+        event_driven_grabbing_(false),
+        frame_ring_size_(4),
+        overflow_policy_(OP_DROP_OLDEST),
+        cpu_affinity_(-1),
+        timestamp_mode_(TM_EXPOSURE_START),
+        clock_sync_interval_(1.0),
+        enable_statistics_(false),
+        statistics_interval_(1.0),
+        enable_chunk_data_(true),
+        check_payload_crc_(false),
+        use_startup_snapshots_(true),
+        startup_snapshot_dir_(""),
+        use_rectification_cache_(true),
+        rectification_cache_dir_(""),
+        auto_flash_(false),
+        demosaicing_algorithm_(DA_BILINEAR),
+        color_encoding_(sensor_msgs::image_encodings::RGB8)
 {}
 
 PylonCameraParameter::~PylonCameraParameter()
@@ -75,6 +116,9 @@ void PylonCameraParameter::readFromRosParameterServer(const ros::NodeHandle& nh)
     nh.param<std::string>("camera_frame", camera_frame_, "pylon_camera");
 
     nh.param<std::string>("device_user_id", device_user_id_, "");
+    nh.param<std::string>("serial_number", serial_number_, "");
+    nh.param<std::string>("ip_address", ip_address_, "");
+    nh.param<std::string>("device_class", device_class_, "");
 
     if ( nh.hasParam("frame_rate") )
     {
@@ -123,10 +167,106 @@ void PylonCameraParameter::readFromRosParameterServer(const ros::NodeHandle& nh)
             binning_y_ = static_cast<size_t>(binning_y);
         }
     }
-    nh.param<int>("downsampling_factor_exposure_search",
-                  downsampling_factor_exp_search_,
-                  20);
+    decimation_x_given_ = nh.hasParam("decimation_x");
+    if ( decimation_x_given_ )
+    {
+        int decimation_x;
+        nh.getParam("decimation_x", decimation_x);
+        if ( decimation_x > 32 || decimation_x < 0 )
+        {
+            ROS_WARN_STREAM("Desired horizontal decimation_x factor not in "
+                << "valid range! Decimation x = " << decimation_x << ". Will "
+                << "reset it to default value (1)");
+            decimation_x_given_ = false;
+        }
+        else
+        {
+            decimation_x_ = static_cast<size_t>(decimation_x);
+        }
+    }
+    decimation_y_given_ = nh.hasParam("decimation_y");
+    if ( decimation_y_given_ )
+    {
+        int decimation_y;
+        nh.getParam("decimation_y", decimation_y);
+        if ( decimation_y > 32 || decimation_y < 0 )
+        {
+            ROS_WARN_STREAM("Desired vertical decimation_y factor not in "
+                << "valid range! Decimation y = " << decimation_y << ". Will "
+                << "reset it to default value (1)");
+            decimation_y_given_ = false;
+        }
+        else
+        {
+            decimation_y_ = static_cast<size_t>(decimation_y);
+        }
+    }
+
+    downsampling_given_ = nh.hasParam("downsampling_x") ||
+                          nh.hasParam("downsampling_y");
+    if ( downsampling_given_ )
+    {
+        int downsampling_x, downsampling_y;
+        nh.param<int>("downsampling_x", downsampling_x, 1);
+        nh.param<int>("downsampling_y", downsampling_y, 1);
+        if ( downsampling_x > 32 || downsampling_x < 1 ||
+             downsampling_y > 32 || downsampling_y < 1 )
+        {
+            ROS_WARN_STREAM("Desired downsampling factors not in valid range! "
+                << "Downsampling = (" << downsampling_x << ", "
+                << downsampling_y << "). Will not downsample the image");
+            downsampling_given_ = false;
+        }
+        else
+        {
+            downsampling_x_ = static_cast<size_t>(downsampling_x);
+            downsampling_y_ = static_cast<size_t>(downsampling_y);
+        }
+    }
 
+    std::string downsampling_preference_string;
+    nh.param<std::string>("downsampling_preference",
+                          downsampling_preference_string, "snr");
+    if ( downsampling_preference_string == "frame_rate" )
+    {
+        downsampling_preference_ = DP_FRAME_RATE;
+    }
+    else
+    {
+        if ( downsampling_preference_string != "snr" )
+        {
+            ROS_WARN_STREAM("Unknown downsampling preference: '"
+                << downsampling_preference_string << "'. Will prefer binning "
+                << "for a better signal to noise ratio ('snr')");
+        }
+        downsampling_preference_ = DP_SNR;
+    }
+
+    roi_given_ = nh.hasParam("roi_offset_x") || nh.hasParam("roi_offset_y") ||
+                 nh.hasParam("roi_width") || nh.hasParam("roi_height");
+    if ( roi_given_ )
+    {
+        int roi_offset_x, roi_offset_y, roi_width, roi_height;
+        nh.param<int>("roi_offset_x", roi_offset_x, 0);
+        nh.param<int>("roi_offset_y", roi_offset_y, 0);
+        nh.param<int>("roi_width", roi_width, 0);
+        nh.param<int>("roi_height", roi_height, 0);
+        if ( roi_offset_x < 0 || roi_offset_y < 0 || roi_width < 0 || roi_height < 0 )
+        {
+            ROS_WARN_STREAM("Desired region of interest not valid! Offset = ("
+                << roi_offset_x << ", " << roi_offset_y << "), size = ("
+                << roi_width << ", " << roi_height << "). Will use the full "
+                << "image instead");
+            roi_given_ = false;
+        }
+        else
+        {
+            roi_offset_x_ = static_cast<size_t>(roi_offset_x);
+            roi_offset_y_ = static_cast<size_t>(roi_offset_y);
+            roi_width_ = static_cast<size_t>(roi_width);
+            roi_height_ = static_cast<size_t>(roi_height);
+        }
+    }
     if ( nh.hasParam("image_encoding") )
     {
         std::string encoding;
@@ -145,6 +285,32 @@ void PylonCameraParameter::readFromRosParameterServer(const ros::NodeHandle& nh)
         image_encoding_ = encoding;
     }
 
+    std::string demosaicing_algorithm_string;
+    nh.param<std::string>("demosaicing_algorithm",
+                          demosaicing_algorithm_string, "bilinear");
+    if ( demosaicing_algorithm_string == "edge_aware" )
+    {
+        demosaicing_algorithm_ = DA_EDGE_AWARE;
+    }
+    else
+    {
+        if ( demosaicing_algorithm_string != "bilinear" )
+        {
+            ROS_WARN_STREAM("Unknown demosaicing algorithm: '"
+                << demosaicing_algorithm_string << "'. Will use 'bilinear'");
+        }
+        demosaicing_algorithm_ = DA_BILINEAR;
+    }
+    nh.param<std::string>("color_encoding", color_encoding_,
+                          sensor_msgs::image_encodings::RGB8);
+    if ( color_encoding_ != sensor_msgs::image_encodings::RGB8 &&
+         color_encoding_ != sensor_msgs::image_encodings::BGR8 )
+    {
+        ROS_WARN_STREAM("Unsupported color encoding: '" << color_encoding_
+            << "'. Will use 'rgb8'");
+        color_encoding_ = sensor_msgs::image_encodings::RGB8;
+    }
+
     // ##########################
     //  image intensity settings
     // ##########################
@@ -205,6 +371,34 @@ void PylonCameraParameter::readFromRosParameterServer(const ros::NodeHandle& nh)
             }
         }
     }
+    int metering_grid_step;
+    nh.param<int>("metering_grid_step", metering_grid_step, 4);
+    if ( metering_grid_step < 1 || metering_grid_step > 64 )
+    {
+        ROS_WARN_STREAM("Desired metering grid step not in valid range [1, 64]: "
+            << metering_grid_step << ". Will meter every 4th pixel instead");
+        metering_grid_step = 4;
+    }
+    metering_grid_step_ = static_cast<size_t>(metering_grid_step);
+
+    std::string metering_mode_string;
+    nh.param<std::string>("metering_mode", metering_mode_string, "average");
+    if ( !metering::meteringModeFromString(metering_mode_string, metering_mode_) )
+    {
+        ROS_WARN_STREAM("Unknown metering mode: '" << metering_mode_string
+            << "'. Will meter the average of the image ('average')");
+        metering_mode_ = MM_AVERAGE;
+    }
+    int metering_roi_offset_x, metering_roi_offset_y;
+    int metering_roi_width, metering_roi_height;
+    nh.param<int>("metering_roi_offset_x", metering_roi_offset_x, 0);
+    nh.param<int>("metering_roi_offset_y", metering_roi_offset_y, 0);
+    nh.param<int>("metering_roi_width", metering_roi_width, 0);
+    nh.param<int>("metering_roi_height", metering_roi_height, 0);
+    metering_roi_.x_offset = std::max(0, metering_roi_offset_x);
+    metering_roi_.y_offset = std::max(0, metering_roi_offset_y);
+    metering_roi_.width = std::max(0, metering_roi_width);
+    metering_roi_.height = std::max(0, metering_roi_height);
     // ##########################
 
     nh.param<double>("exposure_search_timeout", exposure_search_timeout_, 5.);
@@ -239,6 +433,91 @@ void PylonCameraParameter::readFromRosParameterServer(const ros::NodeHandle& nh)
         shutter_mode_ = SM_DEFAULT;
     }
 
+    std::string acquisition_mode_string;
+    nh.param<std::string>("acquisition_mode", acquisition_mode_string, "software_trigger");
+    if ( acquisition_mode_string == "free_run_one_by_one" )
+    {
+        acquisition_mode_ = AM_FREE_RUN_ONE_BY_ONE;
+    }
+    else if ( acquisition_mode_string == "free_run_latest_image_only" )
+    {
+        acquisition_mode_ = AM_FREE_RUN_LATEST_IMAGE_ONLY;
+    }
+    else if ( acquisition_mode_string == "pipelined_software_trigger" )
+    {
+        acquisition_mode_ = AM_PIPELINED_SOFTWARE_TRIGGER;
+    }
+    else
+    {
+        if ( acquisition_mode_string != "software_trigger" )
+        {
+            ROS_WARN_STREAM("Unknown acquisition mode: '" << acquisition_mode_string
+                << "'. Will use 'software_trigger' instead");
+        }
+        acquisition_mode_ = AM_SOFTWARE_TRIGGER;
+    }
+
+    nh.param<int>("triggers_in_flight", triggers_in_flight_, 2);
+
+    nh.param<bool>("event_driven_grabbing", event_driven_grabbing_, false);
+
+    nh.param<int>("frame_ring_size", frame_ring_size_, 4);
+
+    std::string overflow_policy_string;
+    nh.param<std::string>("overflow_policy", overflow_policy_string, "drop_oldest");
+    if ( overflow_policy_string == "drop_newest" )
+    {
+        overflow_policy_ = OP_DROP_NEWEST;
+    }
+    else if ( overflow_policy_string == "block" )
+    {
+        overflow_policy_ = OP_BLOCK;
+    }
+    else
+    {
+        if ( overflow_policy_string != "drop_oldest" )
+        {
+            ROS_WARN_STREAM("Unknown overflow policy: '" << overflow_policy_string
+                << "'. Will use 'drop_oldest' instead");
+        }
+        overflow_policy_ = OP_DROP_OLDEST;
+    }
+
+    nh.param<int>("cpu_affinity", cpu_affinity_, -1);
+
+    std::string timestamp_mode_string;
+    nh.param<std::string>("timestamp_mode", timestamp_mode_string, "exposure_start");
+    if ( timestamp_mode_string == "host" )
+    {
+        timestamp_mode_ = TM_HOST;
+    }
+    else if ( timestamp_mode_string == "exposure_mid" )
+    {
+        timestamp_mode_ = TM_EXPOSURE_MID;
+    }
+    else
+    {
+        if ( timestamp_mode_string != "exposure_start" )
+        {
+            ROS_WARN_STREAM("Unknown timestamp mode: '" << timestamp_mode_string
+                << "'. Will use 'exposure_start' instead");
+        }
+        timestamp_mode_ = TM_EXPOSURE_START;
+    }
+
+    nh.param<double>("clock_sync_interval", clock_sync_interval_, 1.0);
+
+    nh.param<bool>("enable_statistics", enable_statistics_, false);
+    nh.param<double>("statistics_interval", statistics_interval_, 1.0);
+
+    nh.param<bool>("enable_chunk_data", enable_chunk_data_, true);
+    nh.param<bool>("check_payload_crc", check_payload_crc_, false);
+
+    nh.param<bool>("use_startup_snapshots", use_startup_snapshots_, true);
+    nh.param<std::string>("startup_snapshot_dir", startup_snapshot_dir_, "");
+    nh.param<bool>("use_rectification_cache", use_rectification_cache_, true);
+    nh.param<std::string>("rectification_cache_dir", rectification_cache_dir_, "");
+
     nh.param<bool>("auto_flash", auto_flash_, false);
     
     validateParameterSet(nh);
@@ -253,7 +532,27 @@ void PylonCameraParameter::adaptDeviceUserId(const ros::NodeHandle& nh, const st
 
 void PylonCameraParameter::validateParameterSet(const ros::NodeHandle& nh)
 {
-    if ( !device_user_id_.empty() )
+    if ( !device_class_.empty() &&
+         device_class_ != "BaslerGigE" && device_class_ != "BaslerUsb" &&
+         device_class_ != "BaslerCamEmu" )
+    {
+        ROS_WARN_STREAM("Unknown device class: '" << device_class_ << "'. "
+                << "Will search all transport layers instead");
+        device_class_ = "";
+        nh.setParam("device_class", device_class_);
+    }
+
+    if ( !ip_address_.empty() )
+    {
+        ROS_INFO_STREAM("Trying to open the camera with IP address "
+            << ip_address_);
+    }
+    else if ( !serial_number_.empty() )
+    {
+        ROS_INFO_STREAM("Trying to open the camera with serial number "
+            << serial_number_);
+    }
+    else if ( !device_user_id_.empty() )
     {
         ROS_INFO_STREAM("Trying to open the following camera: "
             << device_user_id_.c_str());
@@ -272,6 +571,68 @@ void PylonCameraParameter::validateParameterSet(const ros::NodeHandle& nh)
         nh.setParam("frame_rate", frame_rate_);
     }
 
+    if ( triggers_in_flight_ < 1 )
+    {
+        ROS_WARN_STREAM("Number of triggers in flight has to be at least 1, "
+                << "but is " << triggers_in_flight_ << ". Will reset it to "
+                << "default value (2)");
+        triggers_in_flight_ = 2;
+        nh.setParam("triggers_in_flight", triggers_in_flight_);
+    }
+
+    if ( event_driven_grabbing_ &&
+         acquisition_mode_ != AM_FREE_RUN_ONE_BY_ONE &&
+         acquisition_mode_ != AM_FREE_RUN_LATEST_IMAGE_ONLY )
+    {
+        ROS_WARN_STREAM("Event-driven grabbing is only supported in the "
+                << "free-running acquisition modes, but the acquisition mode is '"
+                << acquisitionModeString() << "'. Will disable it");
+        event_driven_grabbing_ = false;
+        nh.setParam("event_driven_grabbing", event_driven_grabbing_);
+    }
+
+    if ( event_driven_grabbing_ && overflow_policy_ == OP_BLOCK )
+    {
+        // pylon's grab loop thread would wait for the publisher and stall
+        // the retrieval of all following frames of the camera
+        ROS_WARN_STREAM("The overflow policy 'block' is not supported in "
+                << "event-driven grabbing. Will use 'drop_oldest' instead");
+        overflow_policy_ = OP_DROP_OLDEST;
+        nh.setParam("overflow_policy", std::string("drop_oldest"));
+    }
+
+    if ( frame_ring_size_ < 1 )
+    {
+        ROS_WARN_STREAM("Frame ring size has to be at least 1, but is "
+                << frame_ring_size_ << ". Will reset it to default value (4)");
+        frame_ring_size_ = 4;
+        nh.setParam("frame_ring_size", frame_ring_size_);
+    }
+
+    if ( cpu_affinity_ < -1 )
+    {
+        ROS_WARN_STREAM("CPU affinity has to be a CPU index or -1, but is "
+                << cpu_affinity_ << ". Will reset it to default value (-1)");
+        cpu_affinity_ = -1;
+        nh.setParam("cpu_affinity", cpu_affinity_);
+    }
+
+    if ( clock_sync_interval_ <= 0.0 )
+    {
+        ROS_WARN_STREAM("Clock sync interval has to be positive, but is "
+                << clock_sync_interval_ << ". Will reset it to default value (1s)");
+        clock_sync_interval_ = 1.0;
+        nh.setParam("clock_sync_interval", clock_sync_interval_);
+    }
+
+    if ( statistics_interval_ <= 0.0 )
+    {
+        ROS_WARN_STREAM("Statistics interval has to be positive, but is "
+                << statistics_interval_ << ". Will reset it to default value (1s)");
+        statistics_interval_ = 1.0;
+        nh.setParam("statistics_interval", statistics_interval_);
+    }
+
     if ( exposure_given_ && ( exposure_ <= 0.0 || exposure_ > 1e7 ) )
     {
         ROS_WARN_STREAM("Desired exposure measured in microseconds not in "
@@ -328,11 +689,128 @@ std::string PylonCameraParameter::shutterModeString() const
     }
 }
 
+std::string PylonCameraParameter::acquisitionModeString() const
+{
+    if ( acquisition_mode_ == AM_FREE_RUN_ONE_BY_ONE )
+    {
+        return "free_run_one_by_one";
+    }
+    else if ( acquisition_mode_ == AM_FREE_RUN_LATEST_IMAGE_ONLY )
+    {
+        return "free_run_latest_image_only";
+    }
+    else if ( acquisition_mode_ == AM_PIPELINED_SOFTWARE_TRIGGER )
+    {
+        return "pipelined_software_trigger";
+    }
+    else
+    {
+        return "software_trigger";
+    }
+}
+
+std::string PylonCameraParameter::timestampModeString() const
+{
+    if ( timestamp_mode_ == TM_HOST )
+    {
+        return "host";
+    }
+    else if ( timestamp_mode_ == TM_EXPOSURE_MID )
+    {
+        return "exposure_mid";
+    }
+    else
+    {
+        return "exposure_start";
+    }
+}
+
+std::string PylonCameraParameter::overflowPolicyString() const
+{
+    if ( overflow_policy_ == OP_DROP_NEWEST )
+    {
+        return "drop_newest";
+    }
+    else if ( overflow_policy_ == OP_BLOCK )
+    {
+        return "block";
+    }
+    else
+    {
+        return "drop_oldest";
+    }
+}
+
+std::string PylonCameraParameter::downsamplingPreferenceString() const
+{
+    if ( downsampling_preference_ == DP_FRAME_RATE )
+    {
+        return "frame_rate";
+    }
+    else
+    {
+        return "snr";
+    }
+}
+
+std::string PylonCameraParameter::demosaicingAlgorithmString() const
+{
+    if ( demosaicing_algorithm_ == DA_EDGE_AWARE )
+    {
+        return "edge_aware";
+    }
+    else
+    {
+        return "bilinear";
+    }
+}
+
+std::string PylonCameraParameter::startupSnapshotHash() const
+{
+    // the version has to be increased whenever the startup configuration
+    // of the camera changes
+    std::ostringstream ss;
+    ss << std::setprecision(17) << "v2"
+       << "|" << image_encoding_
+       << "|" << binning_x_given_ << "," << binning_x_
+       << "|" << binning_y_given_ << "," << binning_y_
+       << "|" << decimation_x_given_ << "," << decimation_x_
+       << "|" << decimation_y_given_ << "," << decimation_y_
+       << "|" << downsampling_given_ << "," << downsampling_x_
+       << "," << downsampling_y_ << "," << downsampling_preference_
+       << "|" << roi_given_ << "," << roi_offset_x_ << "," << roi_offset_y_
+       << "," << roi_width_ << "," << roi_height_
+       << "|" << exposure_given_ << "," << exposure_
+       << "|" << gain_given_ << "," << gain_
+       << "|" << gamma_given_ << "," << gamma_
+       << "|" << brightness_given_ << "," << brightness_
+       << "," << brightness_continuous_
+       << "," << exposure_auto_ << "," << gain_auto_
+       << "," << metering_mode_ << "," << metering_roi_.x_offset
+       << "," << metering_roi_.y_offset << "," << metering_roi_.width
+       << "," << metering_roi_.height
+       << "|" << auto_exp_upper_lim_
+       << "|" << mtu_size_ << "," << inter_pkg_delay_
+       << "|" << shutter_mode_
+       << "|" << acquisition_mode_ << "," << frame_rate_
+       << "|" << enable_chunk_data_
+       << "|" << auto_flash_;
+
+    return cache_files::hashString(cache_files::hash(ss.str()));
+}
+
 const std::string& PylonCameraParameter::imageEncoding() const
 {
     return image_encoding_;
 }
 
+void PylonCameraParameter::setImageEncoding(const ros::NodeHandle& nh,
+                                            const std::string& image_encoding)
+{
+    image_encoding_ = image_encoding;
+    nh.setParam("image_encoding", image_encoding_);
+}
+
 const std::string& PylonCameraParameter::cameraFrame() const
 {
     return camera_frame_;
@@ -0,0 +1,528 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include <pylon_camera/rectifier.h>
+#include <pylon_camera/cache_files.h>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <ros/ros.h>
+#include <sensor_msgs/image_encodings.h>
+#include <sensor_msgs/distortion_models.h>
+
+namespace pylon_camera
+{
+
+namespace
+{
+
+namespace enc = sensor_msgs::image_encodings;
+
+/**
+ * Remaps a band of TILE_ROWS rows per index of the parallel range
+ */
+class RemapTiles : public cv::ParallelLoopBody
+{
+public:
+    RemapTiles(const cv::Mat& src,
+               const cv::Mat& dst,
+               const cv::Mat& map_coords,
+               const cv::Mat& map_weights)
+        : src_(src)
+        , dst_(dst)
+        , map_coords_(map_coords)
+        , map_weights_(map_weights)
+    {}
+
+    virtual void operator()(const cv::Range& range) const
+    {
+        const int begin = range.start * Rectifier::TILE_ROWS;
+        const int end = std::min(range.end * Rectifier::TILE_ROWS, dst_.rows);
+        // the tile is a view into the destination buffer, remap() writes into
+        // it because the size and type already match
+        cv::Mat dst_tile = dst_.rowRange(begin, end);
+        cv::remap(src_, dst_tile,
+                  map_coords_.rowRange(begin, end),
+                  map_weights_.rowRange(begin, end),
+                  cv::INTER_LINEAR, cv::BORDER_CONSTANT);
+    }
+
+private:
+    const cv::Mat& src_;
+    const cv::Mat& dst_;
+    const cv::Mat& map_coords_;
+    const cv::Mat& map_weights_;
+};
+
+/**
+ * OpenCV type of the pixels of the image, -1 if the encoding is unknown
+ */
+int cvType(const std::string& encoding)
+{
+    int bit_depth = 0;
+    int channels = 0;
+    try
+    {
+        bit_depth = enc::bitDepth(encoding);
+        channels = enc::numChannels(encoding);
+    }
+    catch ( const std::runtime_error& )
+    {
+        return -1;
+    }
+    if ( bit_depth == 8 )
+    {
+        return CV_MAKETYPE(CV_8U, channels);
+    }
+    else if ( bit_depth == 16 )
+    {
+        return CV_MAKETYPE(CV_16U, channels);
+    }
+    return -1;
+}
+
+/**
+ * Header of a cache file, followed by the coordinate and the weight table
+ */
+struct CacheHeader
+{
+    char magic_[8];
+    uint32_t version_;
+    uint32_t rows_;
+    uint32_t cols_;
+    uint32_t map_type_;
+    uint64_t key_;
+    uint64_t checksum_;
+};
+
+const char CACHE_MAGIC[8] = { 'P', 'Y', 'L', 'R', 'E', 'C', 'T', '\0' };
+
+// has to be increased whenever the computation of the tables changes
+const uint32_t CACHE_VERSION = 1;
+
+/**
+ * Hash of the calibration and geometry
+ */
+uint64_t cacheKey(const sensor_msgs::CameraInfo& cam_info)
+{
+    std::ostringstream ss;
+    ss << std::setprecision(17) << "v" << CACHE_VERSION
+       << "|" << cam_info.width << "," << cam_info.height
+       << "|" << cam_info.distortion_model;
+    ss << "|D";
+    for ( const double& d : cam_info.D )
+    {
+        ss << "," << d;
+    }
+    ss << "|K";
+    for ( const double& k : cam_info.K )
+    {
+        ss << "," << k;
+    }
+    ss << "|R";
+    for ( const double& r : cam_info.R )
+    {
+        ss << "," << r;
+    }
+    ss << "|P";
+    for ( const double& p : cam_info.P )
+    {
+        ss << "," << p;
+    }
+    ss << "|" << cam_info.binning_x << "," << cam_info.binning_y
+       << "|" << cam_info.roi.x_offset << "," << cam_info.roi.y_offset
+       << "," << cam_info.roi.width << "," << cam_info.roi.height;
+
+    return cache_files::hash(ss.str());
+}
+
+/**
+ * FNV-1a over 64 bit words instead of bytes, which verifies the tables of
+ * a 20 MP sensor in a few ms
+ */
+uint64_t checksum(const uint8_t* data, const size_t& size, uint64_t hash)
+{
+    size_t i = 0;
+    for ( ; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t) )
+    {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        hash ^= word;
+        hash *= cache_files::FNV_PRIME;
+    }
+    for ( ; i < size; ++i )
+    {
+        hash ^= data[i];
+        hash *= cache_files::FNV_PRIME;
+    }
+    return hash;
+}
+
+uint64_t checksum(const cv::Mat& map_coords, const cv::Mat& map_weights)
+{
+    uint64_t hash = checksum(map_coords.data, map_coords.total() * map_coords.elemSize(),
+                             cache_files::FNV_OFFSET_BASIS);
+    return checksum(map_weights.data, map_weights.total() * map_weights.elemSize(),
+                    hash);
+}
+
+}  // namespace
+
+Rectifier::Rectifier()
+    : mutex_()
+    , cache_dir_("")
+    , mapped_data_(nullptr)
+    , mapped_size_(0)
+    , maps_valid_(false)
+    , maps_cam_info_()
+    , map_coords_()
+    , map_weights_()
+{}
+
+Rectifier::~Rectifier()
+{
+    releaseMaps();
+}
+
+void Rectifier::setCacheDirectory(const std::string& dir)
+{
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    cache_dir_ = dir;
+}
+
+bool Rectifier::rectify(const sensor_msgs::CameraInfoConstPtr& cam_info,
+                        const sensor_msgs::Image& raw,
+                        sensor_msgs::Image& rect)
+{
+    const int type = cvType(raw.encoding);
+    if ( !cam_info || type < 0 || raw.data.size() < static_cast<size_t>(raw.step) * raw.height )
+    {
+        return false;
+    }
+
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    // an unchanged message is the same calibration
+    if ( cam_info != maps_cam_info_ )
+    {
+        if ( !isCurrent(*cam_info) )
+        {
+            maps_valid_ = buildMaps(*cam_info);
+        }
+        maps_cam_info_ = cam_info;
+    }
+    if ( !maps_valid_ ||
+         map_coords_.rows != static_cast<int>(raw.height) ||
+         map_coords_.cols != static_cast<int>(raw.width) )
+    {
+        // e.g. a frame grabbed before the last change of the ROI
+        return false;
+    }
+
+    // wrap the raw data without copying
+    const cv::Mat src(raw.height, raw.width, type,
+                      const_cast<uint8_t*>(raw.data.data()), raw.step);
+
+    rect.header = raw.header;
+    rect.height = raw.height;
+    rect.width = raw.width;
+    rect.encoding = raw.encoding;
+    rect.is_bigendian = raw.is_bigendian;
+    rect.step = raw.width * CV_ELEM_SIZE(type);
+    rect.data.resize(static_cast<size_t>(rect.step) * rect.height);
+    const cv::Mat dst(rect.height, rect.width, type, rect.data.data(), rect.step);
+
+    const int num_tiles = (dst.rows + TILE_ROWS - 1) / TILE_ROWS;
+    cv::parallel_for_(cv::Range(0, num_tiles),
+                      RemapTiles(src, dst, map_coords_, map_weights_));
+    return true;
+}
+
+void Rectifier::invalidate()
+{
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    maps_valid_ = false;
+    maps_cam_info_.reset();
+    releaseMaps();
+}
+
+bool Rectifier::isCurrent(const sensor_msgs::CameraInfo& cam_info) const
+{
+    if ( !maps_cam_info_ )
+    {
+        return false;
+    }
+    const sensor_msgs::CameraInfo& maps_cam_info = *maps_cam_info_;
+    // the header doesn't affect the rectification
+    return cam_info.height == maps_cam_info.height &&
+           cam_info.width == maps_cam_info.width &&
+           cam_info.distortion_model == maps_cam_info.distortion_model &&
+           cam_info.D == maps_cam_info.D &&
+           cam_info.K == maps_cam_info.K &&
+           cam_info.R == maps_cam_info.R &&
+           cam_info.P == maps_cam_info.P &&
+           cam_info.binning_x == maps_cam_info.binning_x &&
+           cam_info.binning_y == maps_cam_info.binning_y &&
+           cam_info.roi.x_offset == maps_cam_info.roi.x_offset &&
+           cam_info.roi.y_offset == maps_cam_info.roi.y_offset &&
+           cam_info.roi.height == maps_cam_info.roi.height &&
+           cam_info.roi.width == maps_cam_info.roi.width;
+}
+
+bool Rectifier::buildMaps(const sensor_msgs::CameraInfo& cam_info)
+{
+    releaseMaps();
+    if ( cam_info.K[0] == 0.0 || cam_info.width == 0 || cam_info.height == 0 )
+    {
+        // not calibrated
+        return false;
+    }
+    if ( cam_info.distortion_model != sensor_msgs::distortion_models::PLUMB_BOB &&
+         cam_info.distortion_model != sensor_msgs::distortion_models::RATIONAL_POLYNOMIAL )
+    {
+        ROS_ERROR_STREAM("Can't rectify the images, the distortion model '"
+                << cam_info.distortion_model << "' is not supported!");
+        return false;
+    }
+
+    cv::Matx33d K(cam_info.K.data());
+    cv::Matx33d R(cam_info.R.data());
+    cv::Matx34d P(cam_info.P.data());
+    if ( R == cv::Matx33d::zeros() )
+    {
+        R = cv::Matx33d::eye();
+    }
+    if ( P(0, 0) == 0.0 )
+    {
+        // monocular camera without projection matrix
+        P = cv::Matx34d::zeros();
+        for ( int r = 0; r < 3; ++r )
+        {
+            for ( int c = 0; c < 3; ++c )
+            {
+                P(r, c) = K(r, c);
+            }
+        }
+    }
+    cv::Mat D;
+    if ( !cam_info.D.empty() )
+    {
+        D = cv::Mat(1, static_cast<int>(cam_info.D.size()), CV_64F,
+                    const_cast<double*>(cam_info.D.data())).clone();
+    }
+
+    // the calibration refers to the full resolution, binning (or
+    // decimation) scales the first two rows of the matrices
+    const uint32_t binning_x = std::max<uint32_t>(1, cam_info.binning_x);
+    const uint32_t binning_y = std::max<uint32_t>(1, cam_info.binning_y);
+    for ( int c = 0; c < 4; ++c )
+    {
+        if ( c < 3 )
+        {
+            K(0, c) /= binning_x;
+            K(1, c) /= binning_y;
+        }
+        P(0, c) /= binning_x;
+        P(1, c) /= binning_y;
+    }
+
+    // the ROI is given in unbinned pixels, all zero is the full resolution
+    cv::Rect roi(0, 0, cam_info.width / binning_x, cam_info.height / binning_y);
+    if ( cam_info.roi.width != 0 && cam_info.roi.height != 0 )
+    {
+        roi = cv::Rect(cam_info.roi.x_offset / binning_x,
+                       cam_info.roi.y_offset / binning_y,
+                       cam_info.roi.width / binning_x,
+                       cam_info.roi.height / binning_y);
+    }
+    // shifting both principal points by the offset computes the tables only
+    // for the ROI, already relative to its origin
+    K(0, 2) -= roi.x;
+    K(1, 2) -= roi.y;
+    P(0, 2) -= roi.x;
+    P(1, 2) -= roi.y;
+
+    const uint64_t key = cacheKey(cam_info);
+    std::string path;
+    if ( !cache_dir_.empty() )
+    {
+        path = cache_dir_ + "/rectification_" + cache_files::hashString(key) + ".bin";
+        if ( loadMaps(path, key, roi.size()) )
+        {
+            return true;
+        }
+    }
+
+    const ros::WallTime start = ros::WallTime::now();
+    const cv::Matx33d P_3x3(P(0, 0), P(0, 1), P(0, 2),
+                            P(1, 0), P(1, 1), P(1, 2),
+                            P(2, 0), P(2, 1), P(2, 2));
+    cv::initUndistortRectifyMap(K, D, R, P_3x3, roi.size(), CV_16SC2,
+                                map_coords_, map_weights_);
+    ROS_INFO_STREAM("Built the rectification tables for "
+            << roi.width << "x" << roi.height << " pixels in "
+            << 1e3 * (ros::WallTime::now() - start).toSec() << " ms");
+    if ( !path.empty() )
+    {
+        saveMaps(path, key);
+    }
+    return true;
+}
+
+bool Rectifier::loadMaps(const std::string& path,
+                         const uint64_t& key,
+                         const cv::Size& size)
+{
+    const ros::WallTime start = ros::WallTime::now();
+    const int fd = open(path.c_str(), O_RDONLY);
+    if ( fd < 0 )
+    {
+        return false;
+    }
+    const size_t num_pixels = static_cast<size_t>(size.width) * size.height;
+    const size_t coords_size = num_pixels * CV_ELEM_SIZE(CV_16SC2);
+    const size_t weights_size = num_pixels * CV_ELEM_SIZE(CV_16UC1);
+    const size_t expected_size = sizeof(CacheHeader) + coords_size + weights_size;
+
+    struct stat file_stat;
+    void* data = MAP_FAILED;
+    if ( fstat(fd, &file_stat) == 0 &&
+         static_cast<size_t>(file_stat.st_size) == expected_size )
+    {
+        data = mmap(nullptr, expected_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    // the mapping stays valid after closing the file
+    close(fd);
+
+    bool valid = data != MAP_FAILED;
+    if ( valid )
+    {
+        const CacheHeader* header = static_cast<const CacheHeader*>(data);
+        uint8_t* payload = static_cast<uint8_t*>(data) + sizeof(CacheHeader);
+        cv::Mat map_coords(size, CV_16SC2, payload);
+        cv::Mat map_weights(size, CV_16UC1, payload + coords_size);
+        valid = std::memcmp(header->magic_, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0 &&
+                header->version_ == CACHE_VERSION &&
+                header->rows_ == static_cast<uint32_t>(size.height) &&
+                header->cols_ == static_cast<uint32_t>(size.width) &&
+                header->map_type_ == CV_16SC2 &&
+                header->key_ == key &&
+                header->checksum_ == checksum(map_coords, map_weights);
+        if ( valid )
+        {
+            mapped_data_ = data;
+            mapped_size_ = expected_size;
+            map_coords_ = map_coords;
+            map_weights_ = map_weights;
+        }
+        else
+        {
+            munmap(data, expected_size);
+        }
+    }
+    if ( !valid )
+    {
+        ROS_WARN_STREAM("The cached rectification tables " << path
+                << " are corrupt or stale, will rebuild them");
+        std::remove(path.c_str());
+        return false;
+    }
+    ROS_INFO_STREAM("Mapped the cached rectification tables " << path
+            << " in " << 1e3 * (ros::WallTime::now() - start).toSec() << " ms");
+    return true;
+}
+
+void Rectifier::saveMaps(const std::string& path, const uint64_t& key) const
+{
+    if ( !map_coords_.isContinuous() || !map_weights_.isContinuous() ||
+         !cache_files::createDirectories(cache_dir_, "rectification tables") )
+    {
+        return;
+    }
+    CacheHeader header;
+    std::memcpy(header.magic_, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version_ = CACHE_VERSION;
+    header.rows_ = static_cast<uint32_t>(map_coords_.rows);
+    header.cols_ = static_cast<uint32_t>(map_coords_.cols);
+    header.map_type_ = static_cast<uint32_t>(map_coords_.type());
+    header.key_ = key;
+    header.checksum_ = checksum(map_coords_, map_weights_);
+
+    std::ostringstream tmp_path;
+    tmp_path << path << ".tmp" << getpid();
+    {
+        std::ofstream file(tmp_path.str().c_str(),
+                           std::ios::out | std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(map_coords_.data),
+                   map_coords_.total() * map_coords_.elemSize());
+        file.write(reinterpret_cast<const char*>(map_weights_.data),
+                   map_weights_.total() * map_weights_.elemSize());
+        file.close();
+        if ( !file )
+        {
+            ROS_WARN_STREAM("Couldn't write the rectification tables to " << path);
+            std::remove(tmp_path.str().c_str());
+            return;
+        }
+    }
+    if ( std::rename(tmp_path.str().c_str(), path.c_str()) != 0 )
+    {
+        ROS_WARN_STREAM("Couldn't save the rectification tables " << path
+                << ": " << std::strerror(errno));
+        std::remove(tmp_path.str().c_str());
+        return;
+    }
+    ROS_INFO_STREAM("Saved the rectification tables " << path);
+}
+
+void Rectifier::releaseMaps()
+{
+    map_coords_.release();
+    map_weights_.release();
+    if ( mapped_data_ )
+    {
+        munmap(mapped_data_, mapped_size_);
+        mapped_data_ = nullptr;
+        mapped_size_ = 0;
+    }
+}
+
+}  // namespace pylon_camera
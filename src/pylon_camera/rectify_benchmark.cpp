@@ -0,0 +1,158 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+/*
+ This program measures the rectification of the pylon_camera_node, which
+ publishes the image_rect topic, for 5 MP and 12 MP mono8 frames. The first
+ frame includes building the remap tables, all others reuse them. If a cache
+ directory is given, the first frame of a second rectifier maps the tables
+ from the cache file instead. No camera is needed, the frames and the
+ calibration are synthetic.
+
+ USAGE: rosrun pylon_camera rectify_benchmark _iterations:=50 _cache_dir:=/tmp/rect
+*/
+
+#include <ros/ros.h>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <sensor_msgs/distortion_models.h>
+#include <sensor_msgs/image_encodings.h>
+#include <opencv2/core/core.hpp>
+#include <pylon_camera/rectifier.h>
+
+namespace
+{
+
+/**
+ * @return a mono8 frame with a gradient and some texture
+ */
+sensor_msgs::Image syntheticFrame(const int& width, const int& height)
+{
+    sensor_msgs::Image img;
+    img.width = width;
+    img.height = height;
+    img.encoding = sensor_msgs::image_encodings::MONO8;
+    img.step = width;
+    img.data.resize(static_cast<std::size_t>(width) * height);
+    for ( int row = 0; row < height; ++row )
+    {
+        for ( int col = 0; col < width; ++col )
+        {
+            img.data[static_cast<std::size_t>(row) * width + col] =
+                static_cast<uint8_t>((row + col) / 16 + ((row * 7 + col * 13) % 32));
+        }
+    }
+    return img;
+}
+
+/**
+ * @return a plumb bob calibration with a noticeable barrel distortion
+ */
+sensor_msgs::CameraInfo syntheticCalibration(const int& width, const int& height)
+{
+    sensor_msgs::CameraInfo cam_info;
+    cam_info.width = width;
+    cam_info.height = height;
+    cam_info.distortion_model = sensor_msgs::distortion_models::PLUMB_BOB;
+    cam_info.D = { -0.25, 0.08, 0.001, -0.0005, 0.0 };
+    const double f = 0.9 * width;
+    const double cx = 0.5 * width;
+    const double cy = 0.5 * height;
+    cam_info.K = { f, 0.0, cx, 0.0, f, cy, 0.0, 0.0, 1.0 };
+    cam_info.R = { 1.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0 };
+    cam_info.P = { f, 0.0, cx, 0.0, 0.0, f, cy, 0.0, 0.0, 0.0, 1.0, 0.0 };
+    return cam_info;
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    ros::init(argc, argv, "pylon_camera_rectify_benchmark");
+    ros::NodeHandle nh("~");
+
+    int iterations;
+    nh.param<int>("iterations", iterations, 50);
+    std::string cache_dir;
+    nh.param<std::string>("cache_dir", cache_dir, "");
+
+    struct FrameSize
+    {
+        const char* name;
+        int width;
+        int height;
+    };
+    const FrameSize frame_sizes[] = { { "5 MP", 2448, 2048 },
+                                      { "12 MP", 4096, 3000 } };
+
+    ROS_INFO_STREAM("Rectifying with " << cv::getNumThreads() << " threads");
+    for ( const FrameSize& size : frame_sizes )
+    {
+        const sensor_msgs::Image raw = syntheticFrame(size.width, size.height);
+        const sensor_msgs::CameraInfoConstPtr cam_info(new sensor_msgs::CameraInfo(
+                                syntheticCalibration(size.width, size.height)));
+        const double megapixels = size.width * size.height / 1e6;
+        pylon_camera::Rectifier rectifier;
+        rectifier.setCacheDirectory(cache_dir);
+        sensor_msgs::Image rect;
+
+        ros::WallTime start = ros::WallTime::now();
+        if ( !rectifier.rectify(cam_info, raw, rect) )
+        {
+            ROS_ERROR_STREAM("Rectification of the " << size.name << " frame failed");
+            return EXIT_FAILURE;
+        }
+        const double first_ms = 1e3 * (ros::WallTime::now() - start).toSec();
+
+        start = ros::WallTime::now();
+        for ( int i = 0; i < iterations; ++i )
+        {
+            rectifier.rectify(cam_info, raw, rect);
+        }
+        const double duration = (ros::WallTime::now() - start).toSec();
+        const double cached_ms = iterations > 0 ? 1e3 * duration / iterations : 0.0;
+        ROS_INFO_STREAM(size.name << " (" << size.width << "x" << size.height
+                << "): first frame incl. remap tables " << first_ms << " ms, "
+                << "cached tables " << cached_ms << " ms ("
+                << megapixels / cached_ms * 1e3 << " MP/s), "
+                << iterations << " iterations");
+
+        if ( !cache_dir.empty() )
+        {
+            pylon_camera::Rectifier cached_rectifier;
+            cached_rectifier.setCacheDirectory(cache_dir);
+            start = ros::WallTime::now();
+            cached_rectifier.rectify(cam_info, raw, rect);
+            ROS_INFO_STREAM(size.name << ": first frame with cached remap tables "
+                    << 1e3 * (ros::WallTime::now() - start).toSec() << " ms");
+        }
+    }
+    return EXIT_SUCCESS;
+}
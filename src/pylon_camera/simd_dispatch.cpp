@@ -0,0 +1,93 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include <pylon_camera/simd_dispatch.h>
+
+namespace pylon_camera
+{
+
+namespace simd_dispatch
+{
+
+namespace
+{
+
+struct SupportedSets
+{
+    bool is_supported_[NUM_INSTRUCTION_SETS];
+};
+
+SupportedSets detectSupportedSets()
+{
+    SupportedSets sets = SupportedSets();
+    sets.is_supported_[IS_SCALAR] = true;
+#ifdef PYLON_CAMERA_SIMD_X86
+    // needed if this runs before the constructors of libgcc
+    __builtin_cpu_init();
+    sets.is_supported_[IS_SSE2] = __builtin_cpu_supports("sse2");
+    sets.is_supported_[IS_SSSE3] = __builtin_cpu_supports("ssse3");
+    sets.is_supported_[IS_AVX2] = __builtin_cpu_supports("avx2");
+#endif
+#ifdef PYLON_CAMERA_SIMD_NEON
+    // NEON is mandatory on aarch64
+    sets.is_supported_[IS_NEON] = true;
+#endif
+    return sets;
+}
+
+}  // namespace
+
+bool isSupported(const INSTRUCTION_SET& instruction_set)
+{
+    // detected once, the initialization of local statics is thread-safe
+    static const SupportedSets sets = detectSupportedSets();
+    return instruction_set >= IS_SCALAR &&
+           instruction_set < NUM_INSTRUCTION_SETS &&
+           sets.is_supported_[instruction_set];
+}
+
+std::string instructionSetName(const INSTRUCTION_SET& instruction_set)
+{
+    switch ( instruction_set )
+    {
+        case IS_SSE2:
+            return "sse2";
+        case IS_SSSE3:
+            return "ssse3";
+        case IS_AVX2:
+            return "avx2";
+        case IS_NEON:
+            return "neon";
+        default:
+            return "scalar";
+    }
+}
+
+}  // namespace simd_dispatch
+}  // namespace pylon_camera
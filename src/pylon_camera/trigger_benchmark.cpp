@@ -0,0 +1,143 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+/*
+ This program compares the frame rate achieved by the software-trigger mode
+ and the pipelined software-trigger mode. The frames are grabbed back to back
+ without publishing them. The camera is configured with the parameters of the
+ private namespace, as the pylon_camera_node does.
+
+ USAGE: rosrun pylon_camera trigger_benchmark _num_frames:=200 _triggers_in_flight:=2
+*/
+
+#include <ros/ros.h>
+#include <string>
+#include <vector>
+#include <pylon_camera/pylon_camera.h>
+
+namespace
+{
+
+/**
+ * Opens the camera in the given acquisition mode and grabs num_frames frames
+ * @return false if the camera could not be initialized
+ */
+bool benchmark(pylon_camera::PylonCameraParameter parameters,
+               const pylon_camera::ACQUISITION_MODE& acquisition_mode,
+               const int& num_frames,
+               double& fps,
+               int& num_failed_grabs,
+               float& max_possible_fps)
+{
+    parameters.acquisition_mode_ = acquisition_mode;
+    pylon_camera::PylonCamera* pylon_camera =
+                pylon_camera::PylonCamera::create(parameters.deviceUserID());
+    if ( pylon_camera == nullptr )
+    {
+        ROS_ERROR("No camera present");
+        return false;
+    }
+
+    if ( !pylon_camera->registerCameraConfiguration(acquisition_mode) ||
+         !pylon_camera->openCamera() ||
+         !pylon_camera->applyCamSpecificStartupSettings(parameters) ||
+         !pylon_camera->startGrabbing(parameters) )
+    {
+        ROS_ERROR_STREAM("Error while initializing the camera in "
+                << parameters.acquisitionModeString() << " mode");
+        delete pylon_camera;
+        return false;
+    }
+    max_possible_fps = pylon_camera->maxPossibleFramerate();
+
+    sensor_msgs::ImagePtr img;
+    pylon_camera::FrameMetadata metadata;
+    // fill the pipeline before measuring
+    for ( int i = 0; i < 5; ++i )
+    {
+        pylon_camera->grab(img, metadata);
+    }
+
+    num_failed_grabs = 0;
+    const ros::WallTime start = ros::WallTime::now();
+    for ( int i = 0; i < num_frames && ros::ok(); ++i )
+    {
+        // releasing the previous image hands its buffer back to the grabber
+        img.reset();
+        if ( !pylon_camera->grab(img, metadata) )
+        {
+            ++num_failed_grabs;
+        }
+    }
+    const double duration = (ros::WallTime::now() - start).toSec();
+    fps = duration > 0.0 ? num_frames / duration : 0.0;
+
+    img.reset();
+    delete pylon_camera;
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    ros::init(argc, argv, "pylon_camera_trigger_benchmark");
+    ros::NodeHandle nh("~");
+
+    int num_frames;
+    nh.param<int>("num_frames", num_frames, 200);
+
+    pylon_camera::PylonCameraParameter parameters;
+    parameters.readFromRosParameterServer(nh);
+
+    std::vector<pylon_camera::ACQUISITION_MODE> modes;
+    modes.push_back(pylon_camera::AM_SOFTWARE_TRIGGER);
+    modes.push_back(pylon_camera::AM_PIPELINED_SOFTWARE_TRIGGER);
+
+    for ( const pylon_camera::ACQUISITION_MODE& mode : modes )
+    {
+        double fps = 0.0;
+        int num_failed_grabs = 0;
+        float max_possible_fps = 0.0;
+        if ( !benchmark(parameters, mode, num_frames, fps, num_failed_grabs,
+                        max_possible_fps) )
+        {
+            return EXIT_FAILURE;
+        }
+        parameters.acquisition_mode_ = mode;
+        ROS_INFO_STREAM(parameters.acquisitionModeString() << ": "
+                << fps << " fps (" << num_frames << " frames, "
+                << num_failed_grabs << " failed grabs, triggers in flight: "
+                << (mode == pylon_camera::AM_PIPELINED_SOFTWARE_TRIGGER ?
+                        parameters.triggers_in_flight_ : 1)
+                << ", max possible frame rate of the camera: "
+                << max_possible_fps << " fps)");
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,143 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+/*
+ This program measures the throughput of the unpack kernels of the packed
+ 10 and 12 bit pixel formats (Mono10p, Mono12p, Bayer*10p, Bayer*12p). Their
+ correctness is verified against the scalar reference by the unit test
+ test_packed_pixels. No camera is needed.
+
+ USAGE: rosrun pylon_camera unpack_benchmark _width:=2448 _height:=2048 _iterations:=200
+*/
+
+#include <ros/ros.h>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <pylon_camera/packed_pixels.h>
+
+namespace
+{
+
+using pylon_camera::packed_pixels::UNPACK_KERNEL;
+
+/**
+ * Packs the pixels, starting with the least significant bit (GenICam PFNC)
+ */
+std::vector<uint8_t> pack(const std::vector<uint16_t>& pixels, const int& bits)
+{
+    std::vector<uint8_t> packed(
+            pylon_camera::packed_pixels::packedSize(pixels.size(), bits), 0);
+    for ( std::size_t i = 0; i < pixels.size(); ++i )
+    {
+        for ( int b = 0; b < bits; ++b )
+        {
+            const std::size_t bit = i * bits + b;
+            if ( pixels[i] & (1 << b) )
+            {
+                packed[bit >> 3] |= static_cast<uint8_t>(1 << (bit & 7));
+            }
+        }
+    }
+    return packed;
+}
+
+/**
+ * @return the throughput in GB/s of unpacked pixels
+ */
+double benchmark(const int& width,
+                 const int& height,
+                 const int& iterations,
+                 const int& bits,
+                 const UNPACK_KERNEL& kernel)
+{
+    const std::size_t num_pixels = static_cast<std::size_t>(width) * height;
+    std::vector<uint16_t> pixels(num_pixels);
+    for ( std::size_t i = 0; i < num_pixels; ++i )
+    {
+        pixels[i] = static_cast<uint16_t>((i * 2654435761u) % (1 << bits));
+    }
+    const std::vector<uint8_t> packed = pack(pixels, bits);
+    std::vector<uint16_t> unpacked(num_pixels);
+
+    // warm up the caches
+    pylon_camera::packed_pixels::unpack(packed.data(), unpacked.data(),
+                                        num_pixels, bits, kernel);
+    const ros::WallTime start = ros::WallTime::now();
+    for ( int i = 0; i < iterations; ++i )
+    {
+        pylon_camera::packed_pixels::unpack(packed.data(), unpacked.data(),
+                                            num_pixels, bits, kernel);
+    }
+    const double duration = (ros::WallTime::now() - start).toSec();
+    return duration > 0.0 ?
+           iterations * num_pixels * sizeof(uint16_t) / duration / 1e9 : 0.0;
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    ros::init(argc, argv, "pylon_camera_unpack_benchmark");
+    ros::NodeHandle nh("~");
+
+    int width, height, iterations;
+    nh.param<int>("width", width, 2448);
+    nh.param<int>("height", height, 2048);
+    nh.param<int>("iterations", iterations, 200);
+
+    std::vector<UNPACK_KERNEL> kernels;
+    kernels.push_back(pylon_camera::packed_pixels::UK_SCALAR);
+    kernels.push_back(pylon_camera::packed_pixels::UK_SSSE3);
+    kernels.push_back(pylon_camera::packed_pixels::UK_AVX2);
+    kernels.push_back(pylon_camera::packed_pixels::UK_NEON);
+
+    ROS_INFO_STREAM("Best kernel of this CPU: " << pylon_camera::packed_pixels::kernelName(
+                                        pylon_camera::packed_pixels::bestKernel()));
+    const int bit_depths[] = { 10, 12 };
+    for ( const int& bits : bit_depths )
+    {
+        for ( const UNPACK_KERNEL& kernel : kernels )
+        {
+            if ( !pylon_camera::packed_pixels::isSupported(kernel) )
+            {
+                continue;
+            }
+            const double throughput = benchmark(width, height, iterations,
+                                                bits, kernel);
+            ROS_INFO_STREAM(bits << " bit, "
+                    << pylon_camera::packed_pixels::kernelName(kernel) << ": "
+                    << throughput << " GB/s unpacked, "
+                    << throughput * bits / 16 << " GB/s packed ("
+                    << width << "x" << height << ", " << iterations
+                    << " iterations)");
+        }
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,126 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include <pylon_camera/uyvy_conversions.h>
+#include <sensor_msgs/image_encodings.h>
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+namespace pylon_camera
+{
+
+namespace uyvy_conversions
+{
+
+namespace enc = sensor_msgs::image_encodings;
+
+void extractLuma(const uint8_t* src, uint8_t* dst, const std::size_t& num_pixels)
+{
+    std::size_t i = 0;
+#if defined(__SSE2__)
+    // the luma is the upper byte of each 16 bit lane
+    for ( ; i + 16 <= num_pixels; i += 16 )
+    {
+        const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * i));
+        const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * i + 16));
+        const __m128i luma = _mm_packus_epi16(_mm_srli_epi16(lo, 8),
+                                              _mm_srli_epi16(hi, 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), luma);
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    // the second plane of the deinterleaving load holds the luma
+    for ( ; i + 16 <= num_pixels; i += 16 )
+    {
+        const uint8x16x2_t chroma_luma = vld2q_u8(src + 2 * i);
+        vst1q_u8(dst + i, chroma_luma.val[1]);
+    }
+#endif
+    for ( ; i < num_pixels; ++i )
+    {
+        dst[i] = src[2 * i + 1];
+    }
+}
+
+bool toMono(const sensor_msgs::Image& uyvy, sensor_msgs::Image& mono)
+{
+    if ( uyvy.encoding != enc::YUV422 || uyvy.data.empty() )
+    {
+        return false;
+    }
+    mono.header = uyvy.header;
+    mono.height = uyvy.height;
+    mono.width = uyvy.width;
+    mono.encoding = enc::MONO8;
+    mono.is_bigendian = uyvy.is_bigendian;
+    mono.step = uyvy.width;
+    mono.data.resize(static_cast<std::size_t>(mono.step) * mono.height);
+    for ( uint32_t row = 0; row < uyvy.height; ++row )
+    {
+        extractLuma(&uyvy.data[static_cast<std::size_t>(row) * uyvy.step],
+                    &mono.data[static_cast<std::size_t>(row) * mono.step],
+                    uyvy.width);
+    }
+    return true;
+}
+
+bool toColor(const sensor_msgs::Image& uyvy,
+             const std::string& color_encoding,
+             sensor_msgs::Image& color)
+{
+    if ( uyvy.encoding != enc::YUV422 || uyvy.data.empty() )
+    {
+        return false;
+    }
+    const bool bgr = color_encoding == enc::BGR8;
+    color.header = uyvy.header;
+    color.height = uyvy.height;
+    color.width = uyvy.width;
+    color.encoding = bgr ? enc::BGR8 : enc::RGB8;
+    color.is_bigendian = uyvy.is_bigendian;
+    color.step = 3 * uyvy.width;
+    color.data.resize(static_cast<std::size_t>(color.step) * color.height);
+    // OpenCV's conversion is vectorized and processes bands of rows in
+    // parallel
+    const cv::Mat src(uyvy.height, uyvy.width, CV_8UC2,
+                      const_cast<uint8_t*>(uyvy.data.data()), uyvy.step);
+    cv::Mat dst(color.height, color.width, CV_8UC3, color.data.data(), color.step);
+    cv::cvtColor(src, dst, bgr ? cv::COLOR_YUV2BGR_UYVY : cv::COLOR_YUV2RGB_UYVY);
+    return true;
+}
+
+}  // namespace uyvy_conversions
+}  // namespace pylon_camera
@@ -0,0 +1,168 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <pylon_camera/camera_clock_model.h>
+
+namespace
+{
+
+using pylon_camera::CameraClockModel;
+
+const double TICK_FREQUENCY = 1e9;
+
+/**
+ * Synthetic camera clock: host = host_offset + (1 + drift) * ticks / f
+ */
+struct SyntheticClock
+{
+    SyntheticClock(const double& host_offset, const double& drift)
+        : host_offset_(host_offset)
+        , drift_(drift)
+    {}
+
+    double hostTime(const uint64_t& ticks) const
+    {
+        return host_offset_ + (1.0 + drift_) * ticks / TICK_FREQUENCY;
+    }
+
+    /**
+     * Feeds a latch of the ticks with the given round trip, the latch
+     * happens at latch_fraction of the round trip
+     */
+    bool latch(CameraClockModel& model,
+               const uint64_t& ticks,
+               const double& round_trip,
+               const double& latch_fraction = 0.5) const
+    {
+        const double host = hostTime(ticks);
+        return model.addSample(ticks,
+                               ros::Time(host - latch_fraction * round_trip),
+                               ros::Time(host + (1.0 - latch_fraction) * round_trip));
+    }
+
+    double host_offset_;
+    double drift_;
+};
+
+const uint64_t LATCH_PERIOD = 100000000;  // 0.1 s
+
+}  // namespace
+
+TEST(CameraClockModel, recoversOffsetAndDrift)
+{
+    CameraClockModel model(16);
+    model.reset(TICK_FREQUENCY);
+    EXPECT_FALSE(model.isValid());
+
+    const SyntheticClock clock(1000.0, 2e-5);
+    for ( uint64_t i = 0; i < 32; ++i )
+    {
+        EXPECT_TRUE(clock.latch(model, (i + 1) * LATCH_PERIOD, 0.001));
+    }
+    EXPECT_TRUE(model.isValid());
+    EXPECT_EQ(16u, model.numSamples());
+    EXPECT_NEAR(2e-5, model.drift(), 1e-7);
+
+    const uint64_t ticks = 40 * LATCH_PERIOD;
+    EXPECT_NEAR(clock.hostTime(ticks), model.toRosTime(ticks).toSec(), 1e-6);
+}
+
+TEST(CameraClockModel, rejectsLongRoundTrips)
+{
+    CameraClockModel model(16);
+    model.reset(TICK_FREQUENCY);
+
+    const SyntheticClock clock(1000.0, 0.0);
+    for ( uint64_t i = 0; i < 8; ++i )
+    {
+        EXPECT_TRUE(clock.latch(model, (i + 1) * LATCH_PERIOD, 0.001));
+    }
+    // the latch happened right at the start of a long round trip, hence the
+    // middle of it is 5 ms off
+    EXPECT_FALSE(clock.latch(model, 9 * LATCH_PERIOD, 0.01, 0.0));
+    EXPECT_EQ(8u, model.numSamples());
+
+    const uint64_t ticks = 10 * LATCH_PERIOD;
+    EXPECT_NEAR(clock.hostTime(ticks), model.toRosTime(ticks).toSec(), 1e-6);
+}
+
+TEST(CameraClockModel, resetsAfterClockJump)
+{
+    CameraClockModel model(16);
+    model.reset(TICK_FREQUENCY);
+
+    const SyntheticClock clock(1000.0, 1e-5);
+    for ( uint64_t i = 0; i < 8; ++i )
+    {
+        EXPECT_TRUE(clock.latch(model, (100 + i) * LATCH_PERIOD, 0.001));
+    }
+
+    // the camera clock restarts at zero, e.g. after a reboot of the camera
+    const SyntheticClock restarted(clock.hostTime(108 * LATCH_PERIOD), 1e-5);
+    EXPECT_TRUE(restarted.latch(model, LATCH_PERIOD, 0.001));
+    EXPECT_EQ(1u, model.numSamples());
+    for ( uint64_t i = 1; i < 8; ++i )
+    {
+        EXPECT_TRUE(restarted.latch(model, (i + 1) * LATCH_PERIOD, 0.001));
+    }
+    const uint64_t ticks = 10 * LATCH_PERIOD;
+    EXPECT_NEAR(restarted.hostTime(ticks), model.toRosTime(ticks).toSec(), 1e-6);
+}
+
+TEST(CameraClockModel, shortRoundTripAgesOut)
+{
+    const std::size_t window_size = 8;
+    CameraClockModel model(window_size);
+    model.reset(TICK_FREQUENCY);
+
+    // a single lucky latch followed by the usual round trips of GigE
+    const SyntheticClock clock(1000.0, 3e-5);
+    EXPECT_TRUE(clock.latch(model, LATCH_PERIOD, 0.0001));
+    uint64_t i = 1;
+    for ( ; i < window_size; ++i )
+    {
+        EXPECT_FALSE(clock.latch(model, (i + 1) * LATCH_PERIOD, 0.001));
+    }
+    // the lucky round trip left the window, hence the model accepts samples
+    // again and estimates the drift
+    for ( ; i < 4 * window_size; ++i )
+    {
+        clock.latch(model, (i + 1) * LATCH_PERIOD, 0.001);
+    }
+    EXPECT_EQ(window_size, model.numSamples());
+    EXPECT_NEAR(3e-5, model.drift(), 1e-7);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,314 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <boost/make_shared.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+#include <pylon_camera/frame_ring.h>
+
+namespace
+{
+
+using pylon_camera::FrameRing;
+
+const boost::posix_time::milliseconds SHORT_TIMEOUT(10);
+const boost::posix_time::milliseconds LONG_TIMEOUT(5000);
+// frames are numbered from 1, popping leaves 0 in the cell
+const uint64_t NUM_STRESS_FRAMES = 100000;
+// a single frame, less than and as many as the default of frame_ring_size
+const std::size_t STRESS_CAPACITIES[] = { 1, 3, 4 };
+
+std::vector<uint64_t> popAll(FrameRing<uint64_t>& ring)
+{
+    std::vector<uint64_t> frames;
+    uint64_t frame = 0;
+    while ( ring.tryPop(frame) )
+    {
+        frames.push_back(frame);
+    }
+    return frames;
+}
+
+/**
+ * Pushes the frames 1 to n from one thread while this thread pops them,
+ * till the producer is done and the ring is drained
+ * @return the popped frames in the order of popping
+ */
+std::vector<uint64_t> runProducerConsumer(FrameRing<uint64_t>& ring,
+                                          const uint64_t& n)
+{
+    std::atomic<bool> producer_done(false);
+    boost::thread producer([&ring, &n, &producer_done]()
+            {
+                for ( uint64_t i = 1; i <= n; ++i )
+                {
+                    ring.push(i);
+                }
+                producer_done = true;
+            });
+
+    std::vector<uint64_t> frames;
+    frames.reserve(n);
+    uint64_t frame = 0;
+    while ( true )
+    {
+        if ( ring.pop(frame, SHORT_TIMEOUT) )
+        {
+            frames.push_back(frame);
+        }
+        else if ( producer_done )
+        {
+            producer.join();
+            std::vector<uint64_t> rest = popAll(ring);
+            frames.insert(frames.end(), rest.begin(), rest.end());
+            break;
+        }
+    }
+    return frames;
+}
+
+void expectStrictlyIncreasing(const std::vector<uint64_t>& frames)
+{
+    for ( std::size_t i = 1; i < frames.size(); ++i )
+    {
+        ASSERT_LT(frames[i - 1], frames[i]) << "at " << i;
+    }
+}
+
+}  // namespace
+
+TEST(FrameRing, dropNewestKeepsTheOldestFrames)
+{
+    FrameRing<uint64_t> ring(3, pylon_camera::OP_DROP_NEWEST);
+    for ( uint64_t i = 1; i <= 3; ++i )
+    {
+        EXPECT_TRUE(ring.push(i));
+    }
+    EXPECT_FALSE(ring.push(4));
+    EXPECT_FALSE(ring.push(5));
+    EXPECT_EQ(3u, ring.size());
+    EXPECT_EQ(5u, ring.numPushed());
+    EXPECT_EQ(2u, ring.numDropped());
+    EXPECT_EQ(std::vector<uint64_t>({ 1, 2, 3 }), popAll(ring));
+}
+
+TEST(FrameRing, dropOldestKeepsTheNewestFrames)
+{
+    FrameRing<uint64_t> ring(3, pylon_camera::OP_DROP_OLDEST);
+    for ( uint64_t i = 1; i <= 5; ++i )
+    {
+        EXPECT_TRUE(ring.push(i));
+    }
+    EXPECT_EQ(3u, ring.size());
+    EXPECT_EQ(5u, ring.numPushed());
+    EXPECT_EQ(2u, ring.numDropped());
+    EXPECT_EQ(std::vector<uint64_t>({ 3, 4, 5 }), popAll(ring));
+}
+
+TEST(FrameRing, ringOfOneFrameHoldsOneFrame)
+{
+    FrameRing<uint64_t> newest(1, pylon_camera::OP_DROP_NEWEST);
+    EXPECT_TRUE(newest.push(1));
+    EXPECT_FALSE(newest.push(2));
+    EXPECT_EQ(std::vector<uint64_t>({ 1 }), popAll(newest));
+
+    FrameRing<uint64_t> oldest(1, pylon_camera::OP_DROP_OLDEST);
+    EXPECT_TRUE(oldest.push(1));
+    EXPECT_TRUE(oldest.push(2));
+    EXPECT_EQ(1u, oldest.numDropped());
+    EXPECT_EQ(std::vector<uint64_t>({ 2 }), popAll(oldest));
+    EXPECT_TRUE(oldest.push(3));
+    EXPECT_EQ(std::vector<uint64_t>({ 3 }), popAll(oldest));
+}
+
+TEST(FrameRing, blockWaitsForTheConsumer)
+{
+    FrameRing<uint64_t> ring(2, pylon_camera::OP_BLOCK);
+    EXPECT_TRUE(ring.push(1));
+    EXPECT_TRUE(ring.push(2));
+
+    std::atomic<bool> pushed(false);
+    boost::thread producer([&ring, &pushed]()
+            {
+                pushed = ring.push(3);
+            });
+    boost::this_thread::sleep(boost::posix_time::milliseconds(50));
+    EXPECT_FALSE(pushed);
+
+    uint64_t frame = 0;
+    ASSERT_TRUE(ring.pop(frame, SHORT_TIMEOUT));
+    EXPECT_EQ(1u, frame);
+    ASSERT_TRUE(producer.try_join_for(boost::chrono::seconds(5)));
+    EXPECT_TRUE(pushed);
+    EXPECT_EQ(0u, ring.numDropped());
+    EXPECT_EQ(std::vector<uint64_t>({ 2, 3 }), popAll(ring));
+}
+
+TEST(FrameRing, closeReleasesBlockedProducerAndConsumer)
+{
+    FrameRing<uint64_t> full(1, pylon_camera::OP_BLOCK);
+    EXPECT_TRUE(full.push(1));
+    std::atomic<bool> pushed(true);
+    boost::thread producer([&full, &pushed]()
+            {
+                pushed = full.push(2);
+            });
+
+    FrameRing<uint64_t> empty(1, pylon_camera::OP_BLOCK);
+    std::atomic<bool> popped(true);
+    boost::thread consumer([&empty, &popped]()
+            {
+                uint64_t frame = 0;
+                popped = empty.pop(frame, LONG_TIMEOUT);
+            });
+
+    boost::this_thread::sleep(boost::posix_time::milliseconds(50));
+    full.close();
+    empty.close();
+    ASSERT_TRUE(producer.try_join_for(boost::chrono::seconds(1)));
+    ASSERT_TRUE(consumer.try_join_for(boost::chrono::seconds(1)));
+    EXPECT_FALSE(pushed);
+    EXPECT_FALSE(popped);
+    EXPECT_EQ(1u, full.numDropped());
+    // the frames in the ring can still be popped
+    EXPECT_EQ(std::vector<uint64_t>({ 1 }), popAll(full));
+}
+
+TEST(FrameRing, popTimesOutOnEmptyRing)
+{
+    FrameRing<uint64_t> ring(4, pylon_camera::OP_BLOCK);
+    uint64_t frame = 0;
+    EXPECT_FALSE(ring.tryPop(frame));
+    EXPECT_FALSE(ring.pop(frame, SHORT_TIMEOUT));
+    EXPECT_EQ(0u, ring.size());
+}
+
+TEST(FrameRing, positionsWrapAroundTheCells)
+{
+    FrameRing<uint64_t> ring(4, pylon_camera::OP_DROP_NEWEST);
+    uint64_t next_push = 1;
+    uint64_t next_pop = 1;
+    // the fill level varies, hence head and tail pass every cell at every
+    // fill level many times
+    for ( std::size_t round = 0; round < 100; ++round )
+    {
+        const std::size_t num_push = 1 + round % 4;
+        for ( std::size_t i = 0; i < num_push; ++i )
+        {
+            ASSERT_TRUE(ring.push(next_push++));
+        }
+        ASSERT_EQ(num_push, ring.size());
+        for ( const uint64_t& frame : popAll(ring) )
+        {
+            ASSERT_EQ(next_pop++, frame);
+        }
+    }
+    EXPECT_EQ(next_push, next_pop);
+    EXPECT_EQ(0u, ring.numDropped());
+}
+
+TEST(FrameRing, poppedFramesAreReleased)
+{
+    FrameRing<boost::shared_ptr<int> > ring(2, pylon_camera::OP_DROP_OLDEST);
+    boost::shared_ptr<int> frame = boost::make_shared<int>(1);
+    EXPECT_TRUE(ring.push(frame));
+    EXPECT_EQ(2, frame.use_count());
+
+    boost::shared_ptr<int> popped;
+    ASSERT_TRUE(ring.tryPop(popped));
+    popped.reset();
+    EXPECT_EQ(1, frame.use_count());
+
+    // dropped frames as well
+    EXPECT_TRUE(ring.push(frame));
+    EXPECT_TRUE(ring.push(boost::make_shared<int>(2)));
+    EXPECT_TRUE(ring.push(boost::make_shared<int>(3)));
+    EXPECT_EQ(1u, ring.numDropped());
+    EXPECT_EQ(1, frame.use_count());
+}
+
+TEST(FrameRing, blockDeliversEveryFrameInOrderUnderLoad)
+{
+    for ( const std::size_t& capacity : STRESS_CAPACITIES )
+    {
+        SCOPED_TRACE(capacity);
+        FrameRing<uint64_t> ring(capacity, pylon_camera::OP_BLOCK);
+        const std::vector<uint64_t> frames =
+                            runProducerConsumer(ring, NUM_STRESS_FRAMES);
+        ASSERT_EQ(NUM_STRESS_FRAMES, frames.size());
+        for ( std::size_t i = 0; i < frames.size(); ++i )
+        {
+            ASSERT_EQ(i + 1, frames[i]);
+        }
+        EXPECT_EQ(0u, ring.numDropped());
+    }
+}
+
+TEST(FrameRing, dropPoliciesLoseNoUndroppedFrameUnderLoad)
+{
+    const pylon_camera::OVERFLOW_POLICY policies[] = {
+        pylon_camera::OP_DROP_OLDEST,
+        pylon_camera::OP_DROP_NEWEST,
+    };
+    for ( const pylon_camera::OVERFLOW_POLICY& policy : policies )
+    {
+        for ( const std::size_t& capacity : STRESS_CAPACITIES )
+        {
+            SCOPED_TRACE(std::to_string(policy) + ", capacity " +
+                         std::to_string(capacity));
+            FrameRing<uint64_t> ring(capacity, policy);
+            const std::vector<uint64_t> frames =
+                                runProducerConsumer(ring, NUM_STRESS_FRAMES);
+            // in order and without duplicates, every frame is either popped
+            // or counted as dropped
+            expectStrictlyIncreasing(frames);
+            ASSERT_FALSE(frames.empty());
+            EXPECT_LE(1u, frames.front());
+            EXPECT_GE(NUM_STRESS_FRAMES, frames.back());
+            EXPECT_EQ(NUM_STRESS_FRAMES, ring.numPushed());
+            EXPECT_EQ(NUM_STRESS_FRAMES, frames.size() + ring.numDropped());
+            if ( policy == pylon_camera::OP_DROP_OLDEST )
+            {
+                // the newest frame is never dropped
+                EXPECT_EQ(NUM_STRESS_FRAMES, frames.back());
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,270 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <pylon_camera/metering.h>
+#include <sensor_msgs/image_encodings.h>
+
+namespace
+{
+
+using pylon_camera::metering::METERING_KERNEL;
+using pylon_camera::metering::MK_SCALAR;
+using pylon_camera::metering::MeteringResult;
+using pylon_camera::metering::WeightMask;
+
+struct EncodingCase
+{
+    std::string encoding_;
+    bool is_bigendian_;
+    std::size_t bytes_per_pixel_;
+};
+
+const EncodingCase ENCODINGS[] = {
+    { sensor_msgs::image_encodings::MONO8, false, 1 },
+    { sensor_msgs::image_encodings::MONO16, false, 2 },
+    { sensor_msgs::image_encodings::MONO16, true, 2 },
+    { sensor_msgs::image_encodings::RGB8, false, 3 },
+    { sensor_msgs::image_encodings::YUV422, false, 2 },
+};
+
+// odd widths around the block sizes of the kernels (16 and 32 samples)
+const std::size_t WIDTHS[] = { 1, 7, 15, 17, 31, 33, 63, 101 };
+const std::size_t HEIGHT = 19;
+// padding behind each row, filled with bytes the kernels must not meter
+const std::size_t PADDINGS[] = { 0, 5, 32 };
+const uint8_t PADDING_VALUE = 255;
+
+const pylon_camera::METERING_MODE MODES[] = {
+    pylon_camera::MM_AVERAGE,
+    pylon_camera::MM_CENTER_WEIGHTED,
+    pylon_camera::MM_SPOT,
+    pylon_camera::MM_ROI,
+    pylon_camera::MM_MATRIX,
+};
+
+/**
+ * All byte values including a share of saturated ones, varying from row to
+ * row
+ */
+sensor_msgs::Image makeImage(const EncodingCase& c,
+                             const std::size_t& width,
+                             const std::size_t& padding)
+{
+    sensor_msgs::Image img;
+    img.encoding = c.encoding_;
+    img.is_bigendian = c.is_bigendian_;
+    img.width = width;
+    img.height = HEIGHT;
+    img.step = width * c.bytes_per_pixel_ + padding;
+    img.data.assign(img.step * img.height, PADDING_VALUE);
+    uint32_t state = 12345;
+    for ( std::size_t y = 0; y < img.height; ++y )
+    {
+        for ( std::size_t x = 0; x < width * c.bytes_per_pixel_; ++x )
+        {
+            state = state * 1103515245u + 12345u;
+            const uint8_t value = static_cast<uint8_t>(state >> 16);
+            img.data[y * img.step + x] = value > 240 ? 255 : value;
+        }
+    }
+    return img;
+}
+
+sensor_msgs::RegionOfInterest centralRegion(const std::size_t& width)
+{
+    sensor_msgs::RegionOfInterest roi;
+    roi.x_offset = width / 4;
+    roi.y_offset = HEIGHT / 3;
+    roi.width = (width + 1) / 2;
+    roi.height = HEIGHT / 2;
+    return roi;
+}
+
+void expectEqual(const MeteringResult& expected, const MeteringResult& actual)
+{
+    EXPECT_EQ(expected.num_samples_, actual.num_samples_);
+    EXPECT_DOUBLE_EQ(expected.mean_, actual.mean_);
+    EXPECT_DOUBLE_EQ(expected.metered_mean_, actual.metered_mean_);
+    EXPECT_DOUBLE_EQ(expected.saturated_fraction_, actual.saturated_fraction_);
+    for ( std::size_t v = 0; v < 256; ++v )
+    {
+        ASSERT_EQ(expected.histogram_[v], actual.histogram_[v]) << "value " << v;
+    }
+}
+
+std::vector<METERING_KERNEL> supportedSimdKernels()
+{
+    std::vector<METERING_KERNEL> kernels;
+    const METERING_KERNEL candidates[] = { pylon_camera::metering::MK_SSE2,
+                                           pylon_camera::metering::MK_AVX2,
+                                           pylon_camera::metering::MK_NEON };
+    for ( const METERING_KERNEL& kernel : candidates )
+    {
+        if ( pylon_camera::metering::isSupported(kernel) )
+        {
+            kernels.push_back(kernel);
+        }
+    }
+    return kernels;
+}
+
+}  // namespace
+
+TEST(Metering, scalarKernelMetersAllBrightnessBytes)
+{
+    for ( const EncodingCase& c : ENCODINGS )
+    {
+        SCOPED_TRACE(c.encoding_ + (c.is_bigendian_ ? " big endian" : ""));
+        const sensor_msgs::Image img = makeImage(c, 33, 5);
+        pylon_camera::metering::SampleLayout layout;
+        ASSERT_TRUE(pylon_camera::metering::sampleLayout(c.encoding_,
+                                                         c.is_bigendian_,
+                                                         layout));
+        // reference: every brightness byte of the visible pixels
+        uint64_t histogram[256] = { 0 };
+        uint64_t sum = 0;
+        uint64_t num_samples = 0;
+        for ( std::size_t y = 0; y < img.height; ++y )
+        {
+            for ( std::size_t k = 0; k < img.width * layout.per_pixel_; ++k )
+            {
+                const uint8_t v = img.data[y * img.step + layout.offset_ +
+                                           k * layout.stride_];
+                ++histogram[v];
+                sum += v;
+                ++num_samples;
+            }
+        }
+
+        MeteringResult result;
+        ASSERT_TRUE(pylon_camera::metering::meter(img, 1, 1, result, MK_SCALAR));
+        EXPECT_EQ(num_samples, result.num_samples_);
+        EXPECT_DOUBLE_EQ(static_cast<double>(sum) / num_samples, result.mean_);
+        EXPECT_DOUBLE_EQ(result.mean_, result.metered_mean_);
+        EXPECT_DOUBLE_EQ(static_cast<double>(histogram[255]) / num_samples,
+                         result.saturated_fraction_);
+        for ( std::size_t v = 0; v < 256; ++v )
+        {
+            ASSERT_EQ(histogram[v], result.histogram_[v]) << "value " << v;
+        }
+    }
+}
+
+TEST(Metering, simdKernelsMatchScalarKernel)
+{
+    for ( const METERING_KERNEL& kernel : supportedSimdKernels() )
+    {
+        SCOPED_TRACE(pylon_camera::metering::kernelName(kernel));
+        for ( const EncodingCase& c : ENCODINGS )
+        {
+            for ( const std::size_t& width : WIDTHS )
+            {
+                for ( const std::size_t& padding : PADDINGS )
+                {
+                    SCOPED_TRACE(c.encoding_ + (c.is_bigendian_ ? " big endian" : "")
+                                 + ", width " + std::to_string(width)
+                                 + ", padding " + std::to_string(padding));
+                    const sensor_msgs::Image img = makeImage(c, width, padding);
+                    for ( std::size_t step_y = 1; step_y <= 3; step_y += 2 )
+                    {
+                        MeteringResult expected;
+                        MeteringResult actual;
+                        ASSERT_TRUE(pylon_camera::metering::meter(
+                                        img, 1, step_y, expected, MK_SCALAR));
+                        ASSERT_TRUE(pylon_camera::metering::meter(
+                                        img, 1, step_y, actual, kernel));
+                        expectEqual(expected, actual);
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST(Metering, simdKernelsMatchScalarKernelForAllWeightMasks)
+{
+    for ( const METERING_KERNEL& kernel : supportedSimdKernels() )
+    {
+        SCOPED_TRACE(pylon_camera::metering::kernelName(kernel));
+        for ( const pylon_camera::METERING_MODE& mode : MODES )
+        {
+            SCOPED_TRACE(pylon_camera::metering::meteringModeString(mode));
+            for ( const EncodingCase& c : ENCODINGS )
+            {
+                for ( const std::size_t& width : WIDTHS )
+                {
+                    SCOPED_TRACE(c.encoding_ + (c.is_bigendian_ ? " big endian" : "")
+                                 + ", width " + std::to_string(width));
+                    const sensor_msgs::Image img = makeImage(c, width, 5);
+                    const WeightMask mask(mode, centralRegion(width),
+                                          img.width, img.height);
+                    for ( std::size_t step = 1; step <= 2; ++step )
+                    {
+                        MeteringResult expected;
+                        MeteringResult actual;
+                        ASSERT_TRUE(pylon_camera::metering::meter(
+                                        img, step, step, mask, expected, MK_SCALAR));
+                        ASSERT_TRUE(pylon_camera::metering::meter(
+                                        img, step, step, mask, actual, kernel));
+                        expectEqual(expected, actual);
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST(Metering, averageMaskMetersLikeUnweightedMetering)
+{
+    const sensor_msgs::Image img = makeImage(ENCODINGS[0], 101, 5);
+    const WeightMask mask(pylon_camera::MM_AVERAGE, sensor_msgs::RegionOfInterest(),
+                          img.width, img.height);
+    MeteringResult weighted;
+    MeteringResult unweighted;
+    ASSERT_TRUE(pylon_camera::metering::meter(img, 1, 1, mask, weighted));
+    ASSERT_TRUE(pylon_camera::metering::meter(img, 1, 1, unweighted));
+    expectEqual(unweighted, weighted);
+}
+
+TEST(Metering, bestKernelIsSupported)
+{
+    EXPECT_TRUE(pylon_camera::metering::isSupported(
+                        pylon_camera::metering::bestKernel()));
+    EXPECT_TRUE(pylon_camera::metering::isSupported(MK_SCALAR));
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
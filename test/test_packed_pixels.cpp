@@ -0,0 +1,194 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <vector>
+#include <pylon_camera/packed_pixels.h>
+
+namespace
+{
+
+using pylon_camera::packed_pixels::UNPACK_KERNEL;
+using pylon_camera::packed_pixels::UK_SCALAR;
+
+const int BIT_DEPTHS[] = { 10, 12 };
+// the widest kernel (AVX2) unpacks 16 pixels per block
+const std::size_t BLOCK_SIZE = 16;
+// written behind the image, to detect overwrites
+const uint16_t GUARD = 0xABCD;
+
+/**
+ * Packs the pixels, starting with the least significant bit (GenICam PFNC)
+ */
+std::vector<uint8_t> pack(const std::vector<uint16_t>& pixels, const int& bits)
+{
+    std::vector<uint8_t> packed(
+            pylon_camera::packed_pixels::packedSize(pixels.size(), bits), 0);
+    for ( std::size_t i = 0; i < pixels.size(); ++i )
+    {
+        for ( int b = 0; b < bits; ++b )
+        {
+            const std::size_t bit = i * bits + b;
+            if ( pixels[i] & (1 << b) )
+            {
+                packed[bit >> 3] |= static_cast<uint8_t>(1 << (bit & 7));
+            }
+        }
+    }
+    return packed;
+}
+
+/**
+ * Every position within a block takes all values, while the neighbours
+ * differ from block to block
+ */
+std::vector<uint16_t> allValuesAtAllLanes(const int& bits)
+{
+    const std::size_t num_values = 1 << bits;
+    std::vector<uint16_t> pixels(num_values * BLOCK_SIZE);
+    for ( std::size_t block = 0; block < num_values; ++block )
+    {
+        for ( std::size_t pos = 0; pos < BLOCK_SIZE; ++pos )
+        {
+            pixels[block * BLOCK_SIZE + pos] = static_cast<uint16_t>(
+                                        (block + pos * 97) % num_values);
+        }
+    }
+    return pixels;
+}
+
+/**
+ * Unpacks with the given kernel into a buffer with one guard pixel behind
+ * the image. The exact size of the source lets memory checkers detect
+ * overreads.
+ */
+std::vector<uint16_t> unpack(const std::vector<uint16_t>& pixels,
+                             const int& bits,
+                             const UNPACK_KERNEL& kernel)
+{
+    const std::vector<uint8_t> packed = pack(pixels, bits);
+    std::vector<uint16_t> unpacked(pixels.size() + 1, GUARD);
+    EXPECT_TRUE(pylon_camera::packed_pixels::unpack(packed.data(),
+                                                    unpacked.data(),
+                                                    pixels.size(),
+                                                    bits,
+                                                    kernel));
+    return unpacked;
+}
+
+std::vector<UNPACK_KERNEL> supportedSimdKernels()
+{
+    std::vector<UNPACK_KERNEL> kernels;
+    const UNPACK_KERNEL candidates[] = { pylon_camera::packed_pixels::UK_SSSE3,
+                                         pylon_camera::packed_pixels::UK_AVX2,
+                                         pylon_camera::packed_pixels::UK_NEON };
+    for ( const UNPACK_KERNEL& kernel : candidates )
+    {
+        if ( pylon_camera::packed_pixels::isSupported(kernel) )
+        {
+            kernels.push_back(kernel);
+        }
+    }
+    return kernels;
+}
+
+}  // namespace
+
+TEST(PackedPixels, scalarKernelUnpacksAllValues)
+{
+    for ( const int& bits : BIT_DEPTHS )
+    {
+        SCOPED_TRACE(bits);
+        const std::vector<uint16_t> pixels = allValuesAtAllLanes(bits);
+        const std::vector<uint16_t> unpacked = unpack(pixels, bits, UK_SCALAR);
+        for ( std::size_t i = 0; i < pixels.size(); ++i )
+        {
+            // aligned to the most significant bit
+            ASSERT_EQ(static_cast<uint16_t>(pixels[i] << (16 - bits)),
+                      unpacked[i]) << "pixel " << i;
+        }
+        EXPECT_EQ(GUARD, unpacked.back());
+    }
+}
+
+TEST(PackedPixels, simdKernelsMatchScalarKernel)
+{
+    for ( const UNPACK_KERNEL& kernel : supportedSimdKernels() )
+    {
+        SCOPED_TRACE(pylon_camera::packed_pixels::kernelName(kernel));
+        for ( const int& bits : BIT_DEPTHS )
+        {
+            SCOPED_TRACE(bits);
+            const std::vector<uint16_t> pixels = allValuesAtAllLanes(bits);
+            EXPECT_EQ(unpack(pixels, bits, UK_SCALAR),
+                      unpack(pixels, bits, kernel));
+        }
+    }
+}
+
+TEST(PackedPixels, simdKernelsMatchScalarKernelForAllSizesAndLanes)
+{
+    for ( const UNPACK_KERNEL& kernel : supportedSimdKernels() )
+    {
+        SCOPED_TRACE(pylon_camera::packed_pixels::kernelName(kernel));
+        for ( const int& bits : BIT_DEPTHS )
+        {
+            const std::vector<uint16_t> pixels = allValuesAtAllLanes(bits);
+            // shifting the start moves every value through all lanes, the
+            // sizes up to four AVX2 blocks end in remainders of all lengths
+            for ( std::size_t offset = 0; offset < BLOCK_SIZE; ++offset )
+            {
+                for ( std::size_t size = 0; size <= 4 * BLOCK_SIZE; ++size )
+                {
+                    const std::vector<uint16_t> part(
+                                pixels.begin() + 8 * 97 + offset,
+                                pixels.begin() + 8 * 97 + offset + size);
+                    ASSERT_EQ(unpack(part, bits, UK_SCALAR),
+                              unpack(part, bits, kernel))
+                            << bits << " bit, offset " << offset
+                            << ", size " << size;
+                }
+            }
+        }
+    }
+}
+
+TEST(PackedPixels, bestKernelIsSupported)
+{
+    EXPECT_TRUE(pylon_camera::packed_pixels::isSupported(
+                        pylon_camera::packed_pixels::bestKernel()));
+    EXPECT_TRUE(pylon_camera::packed_pixels::isSupported(UK_SCALAR));
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}